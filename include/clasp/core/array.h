@@ -518,9 +518,9 @@ namespace core {
     virtual size_t elementSizeInBytes() const override {return sizeof(value_type); };
     virtual void* rowMajorAddressOfElement_(size_t i) const override {return (void*)&(this->_Data[i]);};
     virtual void unsafe_fillArrayWithElt(T_sp initialElement, size_t start, size_t end) override {
-      for (size_t i(start); i<end; ++i ) {
-        (*this)[i] = leaf_type::from_object(initialElement);
-      }
+      // Convert the element once - std::fill turns into memset or a vectorized store loop
+      value_type element = leaf_type::from_object(initialElement);
+      std::fill(this->begin()+start,this->begin()+end,element);
     };
     virtual Array_sp reverse() const final { return templated_ranged_reverse<leaf_type>(*reinterpret_cast<const leaf_type*>(this),0,this->length()); };
     virtual Array_sp nreverse() final { return templated_ranged_nreverse(*this,0,this->length()); };
@@ -87,13 +87,7 @@ public: // Functions here
   static Bignum_sp create(uint64_t v) {
     return create_from_limbs(1, v, true);
   }
-  static Bignum_sp create(double d) {
-    // KLUDGE: there is no mpn function for converting from a double.
-    // However, this conses, which we shouldn't need to do.
-    mpz_class rop;
-    mpz_set_d(rop.get_mpz_t(), d);
-    return create(rop);
-  }
+  static Bignum_sp create(double d);
 
   static Bignum_sp make(const string &value_in_string);
 
@@ -172,6 +166,7 @@ Integer_sp bignum_result(mp_size_t, const mp_limb_t*);
 Integer_sp core__next_fmul(Bignum_sp, Fixnum);
 Bignum_sp core__next_mul(Bignum_sp, Bignum_sp);
 Bignum_sp core__mul_fixnums(Fixnum, Fixnum);
+Bignum_sp next_lshift(const mp_limb_t*, mp_size_t, Fixnum);
 Bignum_sp core__next_lshift(Bignum_sp, Fixnum);
 Integer_sp core__next_rshift(Bignum_sp, Fixnum);
 T_mv core__next_truncate(Bignum_sp, Bignum_sp);
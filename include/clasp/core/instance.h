@@ -113,6 +113,7 @@ namespace core {
         REF_CLASS_DEFAULT_INITARGS = (7+CLASS_SLOT_OFFSET),
         REF_CLASS_FINALIZED = (8+CLASS_SLOT_OFFSET),
         REF_CLASS_DOCSTRING = (9+CLASS_SLOT_OFFSET),
+        REF_CLASS_SIZE = (10+CLASS_SLOT_OFFSET),
         REF_CLASS_DEPENDENTS = (12+CLASS_SLOT_OFFSET),
         REF_CLASS_LOCATION_TABLE = (14+CLASS_SLOT_OFFSET),
         REF_CLASS_STAMP_FOR_INSTANCES_ = (15+CLASS_SLOT_OFFSET),
@@ -257,6 +258,8 @@ inline void low_level_instanceSet(RackType_sp rack, size_t index, T_sp value) {
   rack->low_level_rackSet(index, value);
 }
 
+T_sp core__allocate_standard_instance(Instance_sp cl, size_t slot_count);
+
 }; // core namespace
 
 
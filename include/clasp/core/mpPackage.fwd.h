@@ -342,6 +342,7 @@ void debug_mutex_unlock(Mutex* m);
 #define DISSASSM_NAMEWORD 0x0053534153534944
 #define JITGDBIF_NAMEWORD 0x004942444754494a
 #define MPSMESSG_NAMEWORD 0x005353454d53504d     // MPSMESSG
+#define MPIREQST_NAMEWORD 0x005351455249504d     // MPIREQS
 
 struct Mutex {
   uint64_t _NameWord;
@@ -976,6 +976,9 @@ namespace core {
     UNREACHABLE();
   }
 
+  // Defined in bignum.cc
+  Integer_sp next_fixnum_lshift(Fixnum num, Fixnum shift);
+
   inline Integer_sp clasp_shift(Integer_sp n, Fixnum bits) {
     if (n.fixnump()) {
       if (bits < 0) {
@@ -1007,10 +1010,7 @@ namespace core {
             Integer_sp result((gctools::Tagged)0);
             return result;
         }
-        Bignum val(static_cast<signed long>(n.unsafe_fixnum()));
-        Bignum res;
-        mpz_mul_2exp(res.get_mpz_t(), val.get_mpz_t(), bits);
-        return Integer_O::create(res);
+        return next_fixnum_lshift(n.unsafe_fixnum(), bits);
       }
     }
     return n->shift_(bits);
@@ -32,7 +32,7 @@ THE SOFTWARE.
 #include <vector>
 #include <set>
 #include <clasp/core/object.h>
-#include <clasp/core/array.fwd.h>
+#include <clasp/core/array.h>
 #include <clasp/core/symbolToEnumConverter.h>
 #include <clasp/core/serialize.fwd.h>
 
@@ -47,6 +47,9 @@ FORWARD(Serializer);
     Serializer_O(const std::string data) : _Data(data) {};
     string __repr__() const;
   };
+
+  SimpleVector_byte8_t_sp core__serialize_to_octets(T_sp object);
+  T_mv core__deserialize_from_octets(SimpleVector_byte8_t_sp octets, size_t start, T_sp end);
 };
 
 #endif
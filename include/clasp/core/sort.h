@@ -28,9 +28,12 @@ THE SOFTWARE.
 #define sort_H
 
 #include <stdio.h>
+#include <string.h>
 #include <string>
 #include <vector>
 #include <set>
+#include <algorithm>
+#include <type_traits>
 #include <clasp/core/object.h>
 
 //#define	DEBUG_SORT
@@ -248,5 +251,58 @@ public:
     }
   }
 
+
+  // LSD radix sort of raw integers into increasing order, one byte per pass.
+  // Signed values have their sign bit flipped so that they sort as unsigned.
+  template <typename IntType>
+    void radixSort(IntType* data, size_t n) {
+    typedef typename std::make_unsigned<IntType>::type UnsignedType;
+    const UnsignedType flip = std::is_signed<IntType>::value ? (UnsignedType)((UnsignedType)1 << (sizeof(UnsignedType)*8-1)) : 0;
+    if (n<=1) return;
+    std::vector<IntType> buffer(n);
+    IntType* source = data;
+    IntType* target = buffer.data();
+    for ( size_t shift=0; shift<sizeof(UnsignedType)*8; shift += 8 ) {
+      size_t counts[256];
+      memset(counts,0,sizeof(counts));
+      for ( size_t i=0; i<n; ++i ) counts[(((UnsignedType)source[i]^flip)>>shift)&0xFF]++;
+      // Skip passes where every element has the same digit
+      if (counts[(((UnsignedType)source[0]^flip)>>shift)&0xFF] == n) continue;
+      size_t offset = 0;
+      for ( size_t b=0; b<256; ++b ) {
+        size_t count = counts[b];
+        counts[b] = offset;
+        offset += count;
+      }
+      for ( size_t i=0; i<n; ++i ) target[counts[(((UnsignedType)source[i]^flip)>>shift)&0xFF]++] = source[i];
+      std::swap(source,target);
+    }
+    if (source!=data) memcpy(data,source,n*sizeof(IntType));
+  }
+
+  // Sort raw integers - radix sort for large ranges and std::sort (introsort) for small ones
+  template <typename IntType>
+    void integerSort(IntType* data, size_t n, bool descending) {
+    if (n>=512) radixSort(data,n);
+    else std::sort(data,data+n);
+    if (descending) std::reverse(data,data+n);
+  }
+
+  // Sort raw floats - returns false and leaves the data untouched if there are NaNs
+  // because they can't be ordered with < or >.
+  template <typename FloatType>
+    bool floatSort(FloatType* data, size_t n, bool descending, bool stable) {
+    for ( size_t i=0; i<n; ++i ) if (data[i]!=data[i]) return false;
+    // -0.0 and 0.0 are distinguishable so stability matters for floats
+    if (descending) {
+      if (stable) std::stable_sort(data,data+n,[](FloatType x, FloatType y) {return x>y;});
+      else std::sort(data,data+n,[](FloatType x, FloatType y) {return x>y;});
+    } else {
+      if (stable) std::stable_sort(data,data+n);
+      else std::sort(data,data+n);
+    }
+    return true;
+  }
+
 };
 #endif //]
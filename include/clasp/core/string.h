@@ -1,17 +1,16 @@
 // Strings
 
+#include <clasp/core/stringKernels.h>
+
 namespace core {
   template <typename T1,typename T2>
     bool template_string_EQ_equal(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2)
   {
-    const typename T1::simple_element_type* cp1((const typename T1::simple_element_type*)string1.rowMajorAddressOfElement_(start1));
-    const typename T2::simple_element_type* cp2((const typename T2::simple_element_type*)string2.rowMajorAddressOfElement_(start2));
     size_t length = end1 - start1;
     if (length != (end2 - start2)) return false;
-    for (size_t i = 0; i < length; ++i, ++cp1, ++cp2)
-      if ((static_cast<claspCharacter>(*cp1) != static_cast<claspCharacter>(*cp2)))
-        return false;
-    return true;
+    const typename T1::simple_element_type* cp1((const typename T1::simple_element_type*)string1.rowMajorAddressOfElement_(start1));
+    const typename T2::simple_element_type* cp2((const typename T2::simple_element_type*)string2.rowMajorAddressOfElement_(start2));
+    return string_kernels::equal(cp1,cp2,length);
   }
 }; // namespace core
 
@@ -0,0 +1,440 @@
+/*
+    File: stringKernels.h
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+#ifndef _core_stringKernels_H
+#define _core_stringKernels_H
+
+// ----------------------------------------------------------------------
+//
+//  Raw string kernels
+//
+//  These work directly on the storage of strings - claspChar for
+//  base strings and claspCharacter for character strings.
+//  They are used by string.cc once the string arguments have been
+//  dispatched to their concrete types so that the inner loops
+//  don't go through rowMajorAref and don't box characters.
+//  When SSE2/AVX2 are available (x86-64) the loops are vectorized,
+//  otherwise they fall back to simple scalar loops.
+//
+
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#include <clasp/core/character.h>
+
+namespace core {
+namespace string_kernels {
+
+/*! Returned by the find/search kernels when nothing was found */
+static const size_t npos = ~(size_t)0;
+
+// ------------------------------------------------------------
+//
+// Equality
+//
+
+/*! Return the index of the first element where s1 and s2 differ or n if they don't */
+inline size_t mismatch(const claspChar* s1, const claspChar* s2, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for ( ; i+32<=n; i+=32 ) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(s1+i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(s2+i));
+    uint32_t eq = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a,b));
+    if (eq != 0xFFFFFFFF) return i + __builtin_ctz(~eq);
+  }
+#endif
+#if defined(__SSE2__)
+  for ( ; i+16<=n; i+=16 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s1+i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(s2+i));
+    uint32_t eq = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a,b));
+    if (eq != 0xFFFF) return i + __builtin_ctz(~eq);
+  }
+#endif
+  for ( ; i<n; ++i ) if (s1[i]!=s2[i]) return i;
+  return n;
+}
+
+inline size_t mismatch(const claspCharacter* s1, const claspCharacter* s2, size_t n) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  for ( ; i+8<=n; i+=8 ) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(s1+i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(s2+i));
+    uint32_t eq = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a,b)));
+    if (eq != 0xFF) return i + __builtin_ctz(~eq);
+  }
+#endif
+#if defined(__SSE2__)
+  for ( ; i+4<=n; i+=4 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s1+i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(s2+i));
+    uint32_t eq = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a,b)));
+    if (eq != 0xF) return i + __builtin_ctz(~eq);
+  }
+#endif
+  for ( ; i<n; ++i ) if (s1[i]!=s2[i]) return i;
+  return n;
+}
+
+inline size_t mismatch(const claspChar* s1, const claspCharacter* s2, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  // Widen 16 base characters at a time to four vectors of 32-bit characters
+  const __m128i zero = _mm_setzero_si128();
+  for ( ; i+16<=n; i+=16 ) {
+    __m128i b = _mm_loadu_si128((const __m128i*)(s1+i));
+    __m128i lo = _mm_unpacklo_epi8(b,zero);
+    __m128i hi = _mm_unpackhi_epi8(b,zero);
+    __m128i c0 = _mm_cmpeq_epi32(_mm_unpacklo_epi16(lo,zero),_mm_loadu_si128((const __m128i*)(s2+i)));
+    __m128i c1 = _mm_cmpeq_epi32(_mm_unpackhi_epi16(lo,zero),_mm_loadu_si128((const __m128i*)(s2+i+4)));
+    __m128i c2 = _mm_cmpeq_epi32(_mm_unpacklo_epi16(hi,zero),_mm_loadu_si128((const __m128i*)(s2+i+8)));
+    __m128i c3 = _mm_cmpeq_epi32(_mm_unpackhi_epi16(hi,zero),_mm_loadu_si128((const __m128i*)(s2+i+12)));
+    __m128i all = _mm_and_si128(_mm_and_si128(c0,c1),_mm_and_si128(c2,c3));
+    if (_mm_movemask_epi8(all)!=0xFFFF) break; // find the exact position below
+  }
+#endif
+  for ( ; i<n; ++i ) if (static_cast<claspCharacter>(s1[i])!=s2[i]) return i;
+  return n;
+}
+
+inline size_t mismatch(const claspCharacter* s1, const claspChar* s2, size_t n) {
+  return mismatch(s2,s1,n);
+}
+
+template <typename C1, typename C2>
+inline bool equal(const C1* s1, const C2* s2, size_t n) {
+  return mismatch(s1,s2,n)==n;
+}
+
+// ------------------------------------------------------------
+//
+// Case folding
+//
+// Only the ASCII range is folded in the vector loops - as soon as a block
+// contains a character outside of it the block is handled by the scalar
+// claspCharacter_upcase/claspCharacter_downcase so that the results are
+// identical to the scalar code.
+//
+
+#if defined(__SSE2__)
+/*! Fold a-z (or A-Z if from_lower is false) in a block of base characters */
+inline __m128i fold_ascii_epi8(__m128i x, bool from_lower) {
+  const __m128i lo = _mm_set1_epi8(from_lower ? 'a'-1 : 'A'-1);
+  const __m128i hi = _mm_set1_epi8(from_lower ? 'z'+1 : 'Z'+1);
+  __m128i in_range = _mm_and_si128(_mm_cmpgt_epi8(x,lo),_mm_cmpgt_epi8(hi,x));
+  return _mm_xor_si128(x,_mm_and_si128(in_range,_mm_set1_epi8(0x20)));
+}
+
+inline __m128i fold_ascii_epi32(__m128i x, bool from_lower) {
+  const __m128i lo = _mm_set1_epi32(from_lower ? 'a'-1 : 'A'-1);
+  const __m128i hi = _mm_set1_epi32(from_lower ? 'z'+1 : 'Z'+1);
+  __m128i in_range = _mm_and_si128(_mm_cmpgt_epi32(x,lo),_mm_cmpgt_epi32(hi,x));
+  return _mm_xor_si128(x,_mm_and_si128(in_range,_mm_set1_epi32(0x20)));
+}
+
+inline bool all_ascii_epi32(__m128i x) {
+  // claspCharacter codes are < #x110000 so a signed compare is fine
+  return _mm_movemask_epi8(_mm_cmpgt_epi32(_mm_set1_epi32(128),x))==0xFFFF;
+}
+#endif
+
+inline bool char_equal_ci(claspCharacter c1, claspCharacter c2) {
+  return c1==c2 || claspCharacter_upcase(c1)==claspCharacter_upcase(c2);
+}
+
+/*! Case insensitive (string-equal) comparison of n characters */
+inline bool equal_ci(const claspChar* s1, const claspChar* s2, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for ( ; i+16<=n; i+=16 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s1+i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(s2+i));
+    if (_mm_movemask_epi8(_mm_or_si128(a,b))==0) {
+      a = fold_ascii_epi8(a,true);
+      b = fold_ascii_epi8(b,true);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi8(a,b))!=0xFFFF) return false;
+    } else {
+      for (size_t j=i; j<i+16; ++j ) if (!char_equal_ci(s1[j],s2[j])) return false;
+    }
+  }
+#endif
+  for ( ; i<n; ++i ) if (!char_equal_ci(s1[i],s2[i])) return false;
+  return true;
+}
+
+inline bool equal_ci(const claspCharacter* s1, const claspCharacter* s2, size_t n) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for ( ; i+4<=n; i+=4 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s1+i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(s2+i));
+    if (all_ascii_epi32(_mm_or_si128(a,b))) {
+      a = fold_ascii_epi32(a,true);
+      b = fold_ascii_epi32(b,true);
+      if (_mm_movemask_epi8(_mm_cmpeq_epi32(a,b))!=0xFFFF) return false;
+    } else {
+      for (size_t j=i; j<i+4; ++j ) if (!char_equal_ci(s1[j],s2[j])) return false;
+    }
+  }
+#endif
+  for ( ; i<n; ++i ) if (!char_equal_ci(s1[i],s2[i])) return false;
+  return true;
+}
+
+template <typename C1, typename C2>
+inline bool equal_ci(const C1* s1, const C2* s2, size_t n) {
+  for (size_t i=0; i<n; ++i ) {
+    if (!char_equal_ci(static_cast<claspCharacter>(s1[i]),static_cast<claspCharacter>(s2[i]))) return false;
+  }
+  return true;
+}
+
+/*! Copy n characters from src to dest upcasing (or downcasing) them - src and dest may be the same */
+inline void change_case(const claspChar* src, claspChar* dest, size_t n, bool upcase) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for ( ; i+16<=n; i+=16 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(src+i));
+    if (_mm_movemask_epi8(a)==0) {
+      _mm_storeu_si128((__m128i*)(dest+i),fold_ascii_epi8(a,upcase));
+    } else {
+      for (size_t j=i; j<i+16; ++j ) dest[j] = upcase ? claspCharacter_upcase(src[j]) : claspCharacter_downcase(src[j]);
+    }
+  }
+#endif
+  for ( ; i<n; ++i ) dest[i] = upcase ? claspCharacter_upcase(src[i]) : claspCharacter_downcase(src[i]);
+}
+
+inline void change_case(const claspCharacter* src, claspCharacter* dest, size_t n, bool upcase) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  for ( ; i+4<=n; i+=4 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(src+i));
+    if (all_ascii_epi32(a)) {
+      _mm_storeu_si128((__m128i*)(dest+i),fold_ascii_epi32(a,upcase));
+    } else {
+      for (size_t j=i; j<i+4; ++j ) dest[j] = upcase ? claspCharacter_upcase(src[j]) : claspCharacter_downcase(src[j]);
+    }
+  }
+#endif
+  for ( ; i<n; ++i ) dest[i] = upcase ? claspCharacter_upcase(src[i]) : claspCharacter_downcase(src[i]);
+}
+
+// ------------------------------------------------------------
+//
+// Single character search
+//
+
+/*! Return the index of the first c in s[0..n) or npos */
+inline size_t find_char(const claspChar* s, size_t n, claspCharacter c) {
+  if (c>255) return npos;
+  const void* pos = memchr(s,c,n); // libc memchr is vectorized
+  if (!pos) return npos;
+  return (const claspChar*)pos - s;
+}
+
+inline size_t find_char(const claspCharacter* s, size_t n, claspCharacter c) {
+  size_t i = 0;
+#if defined(__AVX2__)
+  const __m256i c8 = _mm256_set1_epi32(c);
+  for ( ; i+8<=n; i+=8 ) {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(s+i));
+    uint32_t m = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a,c8)));
+    if (m) return i + __builtin_ctz(m);
+  }
+#endif
+#if defined(__SSE2__)
+  const __m128i c4 = _mm_set1_epi32(c);
+  for ( ; i+4<=n; i+=4 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s+i));
+    uint32_t m = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a,c4)));
+    if (m) return i + __builtin_ctz(m);
+  }
+#endif
+  for ( ; i<n; ++i ) if (s[i]==c) return i;
+  return npos;
+}
+
+/*! Return the index of the last c in s[0..n) or npos */
+inline size_t rfind_char(const claspChar* s, size_t n, claspCharacter c) {
+  if (c>255) return npos;
+  size_t i = n;
+#if defined(__SSE2__)
+  const __m128i c16 = _mm_set1_epi8((char)c);
+  for ( ; i>=16; i-=16 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s+i-16));
+    uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a,c16));
+    if (m) return i - 16 + (31 - __builtin_clz(m));
+  }
+#endif
+  for ( ; i>0; --i ) if (s[i-1]==c) return i-1;
+  return npos;
+}
+
+inline size_t rfind_char(const claspCharacter* s, size_t n, claspCharacter c) {
+  size_t i = n;
+#if defined(__SSE2__)
+  const __m128i c4 = _mm_set1_epi32(c);
+  for ( ; i>=4; i-=4 ) {
+    __m128i a = _mm_loadu_si128((const __m128i*)(s+i-4));
+    uint32_t m = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a,c4)));
+    if (m) return i - 4 + (31 - __builtin_clz(m));
+  }
+#endif
+  for ( ; i>0; --i ) if (s[i-1]==c) return i-1;
+  return npos;
+}
+
+// ------------------------------------------------------------
+//
+// Substring search
+//
+// For equal element widths the candidate positions are filtered by
+// comparing the first and the last character of the needle against a
+// whole block of the haystack at once, only surviving candidates are
+// compared in full.  This behaves well for both short and long needles
+// without the setup cost of Boyer-Moore style tables.
+//
+
+/*! Return the index in outer[0..n) where sub[0..m) first occurs or npos */
+inline size_t search(const claspChar* sub, size_t m, const claspChar* outer, size_t n) {
+  if (m==0) return 0;
+  if (m>n) return npos;
+  if (m==1) return find_char(outer,n,sub[0]);
+  const size_t last = n-m; // last possible starting position
+  size_t i = 0;
+#if defined(__AVX2__)
+  {
+    const __m256i first = _mm256_set1_epi8((char)sub[0]);
+    const __m256i lastc = _mm256_set1_epi8((char)sub[m-1]);
+    for ( ; i+32<=last+1; i+=32 ) {
+      __m256i bf = _mm256_loadu_si256((const __m256i*)(outer+i));
+      __m256i bl = _mm256_loadu_si256((const __m256i*)(outer+i+m-1));
+      uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(first,bf),_mm256_cmpeq_epi8(lastc,bl)));
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (memcmp(outer+i+bit+1,sub+1,m-2)==0) return i+bit;
+        mask &= mask-1;
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i first = _mm_set1_epi8((char)sub[0]);
+    const __m128i lastc = _mm_set1_epi8((char)sub[m-1]);
+    for ( ; i+16<=last+1; i+=16 ) {
+      __m128i bf = _mm_loadu_si128((const __m128i*)(outer+i));
+      __m128i bl = _mm_loadu_si128((const __m128i*)(outer+i+m-1));
+      uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first,bf),_mm_cmpeq_epi8(lastc,bl)));
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (memcmp(outer+i+bit+1,sub+1,m-2)==0) return i+bit;
+        mask &= mask-1;
+      }
+    }
+  }
+#endif
+  for ( ; i<=last; ++i ) {
+    if (outer[i]==sub[0] && outer[i+m-1]==sub[m-1] && memcmp(outer+i+1,sub+1,m-2)==0) return i;
+  }
+  return npos;
+}
+
+inline size_t search(const claspCharacter* sub, size_t m, const claspCharacter* outer, size_t n) {
+  if (m==0) return 0;
+  if (m>n) return npos;
+  if (m==1) return find_char(outer,n,sub[0]);
+  const size_t last = n-m;
+  size_t i = 0;
+#if defined(__AVX2__)
+  {
+    const __m256i first = _mm256_set1_epi32(sub[0]);
+    const __m256i lastc = _mm256_set1_epi32(sub[m-1]);
+    for ( ; i+8<=last+1; i+=8 ) {
+      __m256i bf = _mm256_loadu_si256((const __m256i*)(outer+i));
+      __m256i bl = _mm256_loadu_si256((const __m256i*)(outer+i+m-1));
+      uint32_t mask = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(_mm256_cmpeq_epi32(first,bf),_mm256_cmpeq_epi32(lastc,bl))));
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (memcmp(outer+i+bit+1,sub+1,(m-2)*sizeof(claspCharacter))==0) return i+bit;
+        mask &= mask-1;
+      }
+    }
+  }
+#endif
+#if defined(__SSE2__)
+  {
+    const __m128i first = _mm_set1_epi32(sub[0]);
+    const __m128i lastc = _mm_set1_epi32(sub[m-1]);
+    for ( ; i+4<=last+1; i+=4 ) {
+      __m128i bf = _mm_loadu_si128((const __m128i*)(outer+i));
+      __m128i bl = _mm_loadu_si128((const __m128i*)(outer+i+m-1));
+      uint32_t mask = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(_mm_cmpeq_epi32(first,bf),_mm_cmpeq_epi32(lastc,bl))));
+      while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (memcmp(outer+i+bit+1,sub+1,(m-2)*sizeof(claspCharacter))==0) return i+bit;
+        mask &= mask-1;
+      }
+    }
+  }
+#endif
+  for ( ; i<=last; ++i ) {
+    if (outer[i]==sub[0] && outer[i+m-1]==sub[m-1] && memcmp(outer+i+1,sub+1,(m-2)*sizeof(claspCharacter))==0) return i;
+  }
+  return npos;
+}
+
+/*! Mixed element widths - use find_char to skip to candidates */
+template <typename S, typename O>
+inline size_t search(const S* sub, size_t m, const O* outer, size_t n) {
+  if (m==0) return 0;
+  if (m>n) return npos;
+  const claspCharacter c0 = static_cast<claspCharacter>(sub[0]);
+  const size_t last = n-m;
+  size_t i = 0;
+  while (i<=last) {
+    size_t pos = find_char(outer+i,last-i+1,c0);
+    if (pos==npos) return npos;
+    i += pos;
+    if (equal(sub+1,outer+i+1,m-1)) return i;
+    ++i;
+  }
+  return npos;
+}
+
+}; // namespace string_kernels
+}; // namespace core
+
+#endif
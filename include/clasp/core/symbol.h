@@ -294,6 +294,16 @@ public:
   /*! Return the global bound function */
   inline Function_sp symbolFunction() const { return _Function.load(std::memory_order_relaxed); }
 
+  /*! Compare-and-swap the global function; return the old value */
+  inline Function_sp casSymbolFunction(Function_sp cmp, Function_sp new_function) {
+    _Function.compare_exchange_strong(cmp, new_function);
+    return cmp;
+  }
+  inline Function_sp casSetfFdefinition(Function_sp cmp, Function_sp new_function) {
+    _SetfFunction.compare_exchange_strong(cmp, new_function);
+    return cmp;
+  }
+
   /*! Return true if the symbol has a function bound*/
   bool fboundp() const;
 
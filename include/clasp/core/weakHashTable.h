@@ -57,8 +57,8 @@ public: // instance variables here
   typedef typename gctools::WeakKeyHashTable::value_type value_type;
   typedef typename gctools::WeakKeyHashTable::KeyBucketsType KeyBucketsType;
   typedef typename gctools::WeakKeyHashTable::ValueBucketsType ValueBucketsType;
-  typedef typename gctools::WeakKeyHashTable::KeyBucketsAllocatorType KeyBucketsAllocatorType;
-  typedef typename gctools::WeakKeyHashTable::ValueBucketsAllocatorType ValueBucketsAllocatorType;
+  typedef typename gctools::WeakKeyHashTable::WeakBucketsAllocatorType WeakBucketsAllocatorType;
+  typedef typename gctools::WeakKeyHashTable::StrongBucketsAllocatorType StrongBucketsAllocatorType;
   typedef gctools::WeakKeyHashTable HashTableType;
 #else
   typedef gctools::tagged_backcastable_base_ptr<T_O> value_type;
@@ -71,7 +71,7 @@ public: // instance variables here
   HashTableType _HashTable;
   
 public:
-  WeakKeyHashTable_O(size_t sz, Number_sp rehashSize, double rehashThreshold ) : _HashTable(sz,rehashSize, rehashThreshold) {};
+  WeakKeyHashTable_O(size_t sz, Number_sp rehashSize, double rehashThreshold, gctools::HashTableWeakness weakness = gctools::WeakKey ) : _HashTable(sz,rehashSize, rehashThreshold, weakness) {};
   WeakKeyHashTable_O();
   void initialize() override; 
 public:
@@ -98,6 +98,7 @@ public:
   Number_sp rehash_size() override;
   double rehash_threshold() override;
   T_sp hash_table_test() override;
+  Symbol_sp weakness() const;
 
   string __repr__() const override;
 };
@@ -109,7 +110,7 @@ public:
 
 
 namespace core {
-WeakKeyHashTable_sp core__make_weak_key_hash_table(Fixnum_sp size);
+WeakKeyHashTable_sp core__make_weak_key_hash_table(Fixnum_sp size, Symbol_sp weakness);
 };
 
 
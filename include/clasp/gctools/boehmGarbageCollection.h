@@ -27,6 +27,8 @@ THE SOFTWARE.
 #ifndef _clasp_boehmGarbageCollection_H
 #define _clasp_boehmGarbageCollection_H
 
+#include <atomic>
+
 /*! Return the most derived pointer of the object pointed to by the smart_ptr */
 #define GC_BASE_ADDRESS_FROM_SMART_PTR(_smartptr_) (dynamic_cast<void *>(_smartptr_.px_ref()))
 #define GC_BASE_ADDRESS_FROM_PTR(_ptr_) (const_cast<void *>(dynamic_cast<const void *>(_ptr_)))
@@ -58,6 +60,32 @@ namespace gctools {
 
 namespace gctools {
 
+/*! Boehm reports collection events from 7.6 on */
+#if (GC_VERSION_MAJOR > 7) || ((GC_VERSION_MAJOR == 7) && (GC_VERSION_MINOR >= 6))
+#define CLASP_BOEHM_COLLECTION_EVENTS 1
+#endif
+
+  /*! Times are in nanoseconds.  A pause is the time the world is stopped,
+      a collection runs from the start to the end of a collection cycle. */
+  struct BoehmCollectionStatistics {
+    std::atomic<size_t>   _Collections;
+    std::atomic<uint64_t> _TotalCollectionNanoseconds;
+    std::atomic<uint64_t> _MaxCollectionNanoseconds;
+    std::atomic<uint64_t> _LastCollectionNanoseconds;
+    std::atomic<size_t>   _Pauses;
+    std::atomic<uint64_t> _TotalPauseNanoseconds;
+    std::atomic<uint64_t> _MaxPauseNanoseconds;
+    // Only touched by the collector while it holds the allocation lock
+    uint64_t _CollectionStart;
+    uint64_t _PauseStart;
+    void reset();
+  };
+
+  extern BoehmCollectionStatistics global_boehm_statistics;
+  extern bool global_boehm_incremental;
+  extern size_t global_boehm_typed_stamps;
+  extern size_t global_boehm_atomic_stamps;
+
   void boehm_set_finalizer_list(gctools::Tagged object, gctools::Tagged finalizers );
   void boehm_clear_finalizer_list(gctools::Tagged object);
 
@@ -105,12 +105,38 @@ inline void* verify_alignment(void* ptr) {
 
 #ifdef USE_BOEHM
 #define ALIGNED_GC_MALLOC(sz) MAYBE_VERIFY_ALIGNMENT(GC_memalign(Alignment(),sz))
-#define ALIGNED_GC_MALLOC_ATOMIC(sz) MAYBE_VERIFY_ALIGNMENT(GC_memalign(Alignment(),sz))
+// Boehm granules are 16 bytes on 64-bit so GC_MALLOC_ATOMIC already satisfies Alignment()
+// and the memory is never scanned.  It is not cleared either.
+#define ALIGNED_GC_MALLOC_ATOMIC(sz) MAYBE_VERIFY_ALIGNMENT(GC_MALLOC_ATOMIC(sz))
 #define ALIGNED_GC_MALLOC_UNCOLLECTABLE(sz) MAYBE_VERIFY_ALIGNMENT((void*)gctools::AlignUp((uintptr_t)GC_MALLOC_UNCOLLECTABLE(sz+Alignment())))
 #endif
 
 namespace gctools {
 #ifdef USE_BOEHM
+  /*! How Boehm allocates each stamp when CLASP_GC_TYPED_ALLOCATION is set.
+      Built from global_stamp_layout by boehm_build_stamp_descriptors.
+      _Atomic stamps have no pointer fields at all.  _Descriptor describes the
+      pointer fields of a fixed size class and only applies to allocations of
+      exactly _Size bytes (header included).  Everything else is scanned conservatively. */
+  struct BoehmStampDescriptor {
+    GC_descr  _Descriptor;
+    size_t    _Size;
+    bool      _Atomic;
+  };
+  extern BoehmStampDescriptor* global_boehm_stamp_descriptors;
+  extern size_t                global_boehm_stamp_descriptors_max;
+
+  /*! Weak buckets, mappings and weak pointers have their own allocation path.
+      The links in them are registered as disappearing links so they must not be
+      scanned, but the words in front of them (the dependent pointer) must be.
+      Only the first header_size bytes are scanned.  The memory is cleared. */
+  inline void* boehm_weak_allocation(size_t header_size, size_t size) {
+    size_t words = header_size/sizeof(GC_word);
+    GC_word bitmap = (words >= GC_WORDSZ) ? ~(GC_word)0 : (((GC_word)1 << words) - 1);
+    GC_descr descriptor = GC_make_descriptor(&bitmap,words);
+    return MAYBE_VERIFY_ALIGNMENT(GC_malloc_explicitly_typed(size,descriptor));
+  }
+
   inline Header_s* do_boehm_atomic_allocation(const Header_s::StampWtagMtag& the_header, size_t size) 
   {
     RAII_DISABLE_INTERRUPTS();
@@ -121,8 +147,9 @@ namespace gctools {
 #endif
     Header_s* header = reinterpret_cast<Header_s*>(ALIGNED_GC_MALLOC_ATOMIC(true_size));
     my_thread_low_level->_Allocations.registerAllocation(the_header.unshifted_stamp(),true_size);
-#ifdef DEBUG_GUARD
+    // Atomic memory is not cleared by Boehm
     memset(header,0x00,true_size);
+#ifdef DEBUG_GUARD
     new (header) Header_s(the_header,size,tail_size,true_size);
 #else
     new (header) Header_s(the_header);
@@ -136,8 +163,24 @@ namespace gctools {
 #ifdef DEBUG_GUARD
     size_t tail_size = ((rand()%8)+1)*Alignment();
     true_size += tail_size;
-#endif
     Header_s* header = reinterpret_cast<Header_s*>(ALIGNED_GC_MALLOC(true_size));
+#else
+    Header_s* header;
+    size_t stamp_index = the_header.unshifted_stamp()>>Header_s::mtag_width;
+    if (global_boehm_stamp_descriptors && stamp_index<=global_boehm_stamp_descriptors_max) {
+      const BoehmStampDescriptor& desc = global_boehm_stamp_descriptors[stamp_index];
+      if (desc._Atomic) {
+        header = reinterpret_cast<Header_s*>(ALIGNED_GC_MALLOC_ATOMIC(true_size));
+        memset(header,0x00,true_size);
+      } else if (desc._Descriptor && desc._Size==true_size) {
+        header = reinterpret_cast<Header_s*>(MAYBE_VERIFY_ALIGNMENT(GC_malloc_explicitly_typed(true_size,desc._Descriptor)));
+      } else {
+        header = reinterpret_cast<Header_s*>(ALIGNED_GC_MALLOC(true_size));
+      }
+    } else {
+      header = reinterpret_cast<Header_s*>(ALIGNED_GC_MALLOC(true_size));
+    }
+#endif
     my_thread_low_level->_Allocations.registerAllocation(the_header.unshifted_stamp(),true_size);
 #ifdef DEBUG_GUARD
     memset(header,0x00,true_size);
@@ -1103,9 +1146,9 @@ public:
     size_t size = sizeof_container<container_type>(num); // NO HEADER FOR BUCKETS
 #ifdef USE_BOEHM
 #ifdef DEBUG_GCWEAK
-    printf("%s:%d Allocating Bucket with GC_MALLOC_ATOMIC\n", __FILE__, __LINE__);
+    printf("%s:%d Allocating weak Bucket\n", __FILE__, __LINE__);
 #endif
-    container_pointer myAddress = (container_pointer)ALIGNED_GC_MALLOC_ATOMIC(size);
+    container_pointer myAddress = (container_pointer)boehm_weak_allocation(sizeof_container<container_type>(0),size);
     my_thread_low_level->_Allocations.registerAllocation(STAMP_null,size);
     if (!myAddress)
       throw_hard_error("Out of memory in allocate");
@@ -1242,8 +1285,8 @@ public:
   static gctools::tagged_pointer<container_type> allocate( const VT &val) {
     size_t size = sizeof(container_type);
 #ifdef USE_BOEHM
-    printf("%s:%d Allocating Mapping with GC_MALLOC_ATOMIC\n", __FILE__, __LINE__);
-    container_pointer myAddress = (container_pointer)ALIGNED_GC_MALLOC_ATOMIC(size);
+    printf("%s:%d Allocating weak Mapping\n", __FILE__, __LINE__);
+    container_pointer myAddress = (container_pointer)boehm_weak_allocation(size-sizeof(VT),size);
     my_thread_low_level->_Allocations.registerAllocation(STAMP_null,size);
     if (!myAddress)
       throw_hard_error("Out of memory in allocate");
@@ -1317,9 +1360,9 @@ public:
     size_t size = sizeof(VT);
 #ifdef USE_BOEHM
 #ifdef DEBUG_GCWEAK
-    printf("%s:%d Allocating WeakPointer with GC_MALLOC_ATOMIC\n", __FILE__, __LINE__);
+    printf("%s:%d Allocating WeakPointer\n", __FILE__, __LINE__);
 #endif
-    value_pointer myAddress = (value_pointer)ALIGNED_GC_MALLOC_ATOMIC(size);
+    value_pointer myAddress = (value_pointer)boehm_weak_allocation(size-sizeof(contained_type),size);
     my_thread_low_level->_Allocations.registerAllocation(STAMP_null,size);
     if (!myAddress)
       throw_hard_error("Out of memory in allocate");
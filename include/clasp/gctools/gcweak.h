@@ -184,6 +184,14 @@ struct BucketsBase : public WeakObject {
     return NULL;
   };
 
+  /*! Acquire/release access to a bucket for readers that do not take the table lock */
+  T load(size_t idx) {
+    return T((gctools::Tagged)__atomic_load_n(&this->bucket[idx].rawRef_(), __ATOMIC_ACQUIRE));
+  }
+  void store(size_t idx, const T &val) {
+    __atomic_store_n(&this->bucket[idx].rawRef_(), val.raw_(), __ATOMIC_RELEASE);
+  }
+
   int length() const {
     GCTOOLS_ASSERT(this->_length.fixnump());
     return this->_length.unsafe_fixnum();
@@ -211,6 +219,16 @@ inline bool unboundOrDeletedOrSplatted(core::T_sp bucket) {
           || !bucket           // splatted by Boehm
           );
 }
+
+/*! Only pointers to real objects get a disappearing link - immediates and the
+    hash table marker symbols are stored as they are */
+inline bool weakLinkp(core::T_sp bucket) {
+  return (bucket.objectp()
+          && !bucket.unboundp()
+          && !bucket.deletedp()
+          && !bucket.no_keyp()
+          && !bucket.sameAsKeyP());
+}
 #endif
 
 template <class T, class U>
@@ -220,7 +238,7 @@ struct Buckets<T, U, WeakLinks> : public BucketsBase<T, U> {
   virtual ~Buckets() {
 #ifdef USE_BOEHM
     for (size_t i(0), iEnd(this->length()); i < iEnd; ++i) {
-      if (!unboundOrDeletedOrSplatted(this->bucket[i])) {
+      if (weakLinkp(this->bucket[i])) {
         //		    printf("%s:%d Buckets dtor idx: %zu unregister disappearing link @%p\n", __FILE__, __LINE__, i, &this->bucket[i].rawRef_());
         int result = GC_unregister_disappearing_link(reinterpret_cast<void **>(&this->bucket[i].rawRef_()));
         if (!result) {
@@ -233,13 +251,13 @@ struct Buckets<T, U, WeakLinks> : public BucketsBase<T, U> {
   }
 
   void set(size_t idx, const value_type &val) {
-    if (!val.objectp()) {
-      printf("%s:%d Only  objectp() objects can be added to Mapping\n", __FILE__, __LINE__);
+    if (!val.raw_()) {
+      printf("%s:%d A NULL (or an unencoded fixnum 0) cannot be added to weak Buckets\n", __FILE__, __LINE__);
       abort();
     }
 #ifdef USE_BOEHM
     //	    printf("%s:%d ---- Buckets set idx: %zu   this->bucket[idx] = %p\n", __FILE__, __LINE__, idx, this->bucket[idx].raw_() );
-    if (!unboundOrDeletedOrSplatted(this->bucket[idx])) {
+    if (weakLinkp(this->bucket[idx])) {
       auto &rawRef = this->bucket[idx].rawRef_();
       void **linkAddress = reinterpret_cast<void **>(&rawRef);
       //		printf("%s:%d Buckets set idx: %zu unregister disappearing link @%p\n", __FILE__, __LINE__, idx, linkAddress );
@@ -248,20 +266,27 @@ struct Buckets<T, U, WeakLinks> : public BucketsBase<T, U> {
         throw_hard_error("The link was not registered as a disappearing link!");
       }
     }
-    if (!unboundOrDeletedOrSplatted(val)) {
-      this->bucket[idx] = val;
+    this->store(idx, val);
+    if (weakLinkp(val)) {
       //		printf("%s:%d Buckets set idx: %zu register disappearing link @%p\n", __FILE__, __LINE__, idx, &this->bucket[idx].rawRef_());
-      GCTOOLS_ASSERT(val.objectp());
-      GC_general_register_disappearing_link(reinterpret_cast<void **>(&this->bucket[idx].rawRef_()), reinterpret_cast<void *>(this->bucket[idx].rawRef_()));
-    } else {
-      this->bucket[idx] = val;
+      GC_general_register_disappearing_link(reinterpret_cast<void **>(&this->bucket[idx].rawRef_()), reinterpret_cast<void *>(val.raw_()));
     }
 #endif
 #ifdef USE_MPS
     GCWEAK_LOG(BF("Setting Buckets<T,U,WeakLinks> idx=%d  address=%p") % idx % ((void *)(val.raw_())));
-    this->bucket[idx] = val;
+    this->store(idx, val);
 #endif
   }
+
+  /*! Clear the bucket the way the collector would - used to test splat handling */
+  void splat(size_t idx) {
+#ifdef USE_BOEHM
+    if (weakLinkp(this->bucket[idx])) {
+      GC_unregister_disappearing_link(reinterpret_cast<void **>(&this->bucket[idx].rawRef_()));
+    }
+#endif
+    this->store(idx, value_type((gctools::Tagged)0));
+  }
 };
 
 template <class T, class U>
@@ -271,7 +296,7 @@ struct Buckets<T, U, StrongLinks> : public BucketsBase<T, U> {
   virtual ~Buckets() {}
   void set(size_t idx, const value_type &val) {
     GCWEAK_LOG(BF("Setting Buckets<T,U,StrongLinks> idx=%d  address=%p") % idx % ((void *)(val.raw_())));
-    this->bucket[idx] = val;
+    this->store(idx, val);
   }
 };
 
@@ -283,39 +308,90 @@ typedef gctools::smart_ptr<core::T_O> BucketValueType;
 typedef gctools::Buckets<BucketValueType, BucketValueType, gctools::WeakLinks> WeakBucketsObjectType;
 typedef gctools::Buckets<BucketValueType, BucketValueType, gctools::StrongLinks> StrongBucketsObjectType;
 
+/*! Which side of a WeakKeyHashTable is held weakly.
+    An entry disappears as soon as any weakly held side of it is collected. */
+typedef enum { WeakKey,
+               WeakValue,
+               WeakKeyAndValue } HashTableWeakness;
+
 class WeakKeyHashTable {
   friend class core::WeakKeyHashTable_O;
 
 public:
   typedef BucketValueType value_type;
-  typedef WeakBucketsObjectType KeyBucketsType;
-  typedef StrongBucketsObjectType ValueBucketsType;
+  typedef BucketsBase<value_type, value_type> KeyBucketsType;
+  typedef BucketsBase<value_type, value_type> ValueBucketsType;
 
 public:
   typedef WeakKeyHashTable MyType;
 
 public:
-  typedef gctools::GCBucketAllocator<KeyBucketsType> KeyBucketsAllocatorType;
-  typedef gctools::GCBucketAllocator<ValueBucketsType> ValueBucketsAllocatorType;
+  typedef gctools::GCBucketAllocator<WeakBucketsObjectType> WeakBucketsAllocatorType;
+  typedef gctools::GCBucketAllocator<StrongBucketsObjectType> StrongBucketsAllocatorType;
+  /*! Number of entries that set() checks for collected keys/values each time it is called */
+  static const size_t SweepBatch = 8;
 
 public:
   core::Number_sp _RehashSize;
   double _RehashThreshold;
   size_t _Length;
+  HashTableWeakness _Weakness;
+  size_t _SweepIndex;                                // where the next incremental sweep starts
   gctools::tagged_pointer<KeyBucketsType> _Keys;     // hash buckets for keys
   gctools::tagged_pointer<ValueBucketsType> _Values; // hash buckets for values
 #ifdef CLASP_THREADS
     mutable mp::SharedMutex_sp _Mutex;
 #endif
 public:
-  WeakKeyHashTable(size_t length, core::Number_sp rehashSize, double rehashThreshold) : _Length(length), _RehashSize(rehashSize), _RehashThreshold(rehashThreshold) {};
+  WeakKeyHashTable(size_t length, core::Number_sp rehashSize, double rehashThreshold, HashTableWeakness weakness = WeakKey) : _Length(length), _RehashSize(rehashSize), _RehashThreshold(rehashThreshold), _Weakness(weakness), _SweepIndex(0) {};
   void initialize();
 public:
   static uint sxhashKey(const value_type &key);
 
+  /*! Fixnum 0 is a NULL pointer, which is what the collector splats weak buckets with.
+      Store it as the no-key marker instead and translate it back on the way out. */
+  static value_type encode(core::T_sp obj) {
+    if (!obj.raw_()) return value_type(gctools::make_tagged_no_key<core::T_O>());
+    return value_type(obj);
+  }
+  static core::T_sp decode(const value_type &val) {
+    if (val.no_keyp()) return core::T_sp(gctools::make_tagged_fixnum<core::Fixnum_I>(0));
+    return core::T_sp(val);
+  }
+  /*! An entry is live if neither its key nor its value was splatted by the collector */
+  static bool liveEntryp(const value_type &key, const value_type &value) {
+    return (key.raw_() && !key.unboundp() && !key.deletedp()
+            && value.raw_() && !value.unboundp() && !value.deletedp());
+  }
+  /*! Store into a bucket, registering a disappearing link if the buckets are weak */
+  static void setBucket(gctools::tagged_pointer<KeyBucketsType> buckets, size_t idx, const value_type &val) {
+    if (buckets->kind() == WeakBucketKind) {
+      static_cast<WeakBucketsObjectType *>(&*buckets)->set(idx, val);
+    } else {
+      static_cast<StrongBucketsObjectType *>(&*buckets)->set(idx, val);
+    }
+  }
+  bool weakKeysp() const { return this->_Weakness != WeakValue; };
+  bool weakValuesp() const { return this->_Weakness != WeakKey; };
+
+  /*! The current key buckets for readers that don't take the lock */
+  gctools::tagged_pointer<KeyBucketsType> loadKeys() const {
+    gctools::tagged_pointer<KeyBucketsType> keys;
+    keys.thePointer = __atomic_load_n(&this->_Keys.thePointer, __ATOMIC_ACQUIRE);
+    return keys;
+  }
+  /*! The current value buckets for readers that don't take the lock.
+      Load them after the keys and check that they belong together. */
+  gctools::tagged_pointer<ValueBucketsType> loadValues() const {
+    gctools::tagged_pointer<ValueBucketsType> values;
+    values.thePointer = __atomic_load_n(&this->_Values.thePointer, __ATOMIC_ACQUIRE);
+    return values;
+  }
+
   /*! Return 0 if there is no more room in the sequence of entries for the key
 	  Return 1 if the element is found or an unbound or deleted entry is found.
 	  Return the entry index in (b)
+	  Entries whose key or value was collected are turned into deleted entries on the way.
 	*/
   static size_t find_no_lock(gctools::tagged_pointer<KeyBucketsType> keys, const value_type &key, size_t &b
 #ifdef DEBUG_FIND
@@ -323,6 +399,10 @@ public:
                   bool debugFind = false, stringstream *reportP = NULL
 #endif
                   );
+  /*! Read-only probe for (key) - never writes to the buckets so it is safe without the lock */
+  static bool find_lock_free(gctools::tagged_pointer<KeyBucketsType> keys, const value_type &key, size_t &b);
+  /*! If the entry at (idx) lost its key or its value to the collector turn it into a deleted entry */
+  static bool reap_not_safe(gctools::tagged_pointer<KeyBucketsType> keys, size_t idx);
 
 public:
   void setupThreadSafeHashTable();
@@ -338,10 +418,13 @@ public:
     gctools::tagged_pointer<ValueBucketsType> tempValues = this->_Values;
     core::Number_sp rehashSize = this->_RehashSize;
     double rehashThreshold = this->_RehashThreshold;
-    this->_Keys = other._Keys;
-    this->_Values = other._Values;
+    // Lock free readers load the keys and then the values, and retry
+    // unless the values they got are the dependent of the keys they got.
+    __atomic_store_n(&this->_Values.thePointer, other._Values.thePointer, __ATOMIC_RELEASE);
+    __atomic_store_n(&this->_Keys.thePointer, other._Keys.thePointer, __ATOMIC_RELEASE);
     this->_RehashSize = other._RehashSize;
     this->_RehashThreshold = other._RehashThreshold;
+    this->_SweepIndex = 0;
     other._Keys = tempKeys;
     other._Values = tempValues;
     other._RehashSize = rehashSize;
@@ -374,6 +457,7 @@ public:
     return result;
   }
 
+  void sweep_not_safe(size_t batch);
   int rehash_not_safe( const value_type &key, size_t &key_bucket);
   int rehash(const value_type &key, size_t &key_bucket);
   int trySet(core::T_sp tkey, core::T_sp value);
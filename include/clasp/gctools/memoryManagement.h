@@ -39,6 +39,7 @@ THE SOFTWARE.
   #define GC_THREADS
 #endif
 #include <gc/gc.h>
+#include <gc/gc_typed.h>
 #endif // USE_BOEHM
 
 #ifdef USE_MPS
@@ -32,6 +32,7 @@ THE SOFTWARE.
 #include <vector>
 #include <set>
 #include <clasp/core/object.h>
+#include <clasp/core/array.h>
 #ifdef USE_MPI
 #include <boost/mpi.hpp>
 namespace bmpi = boost::mpi;
@@ -101,6 +102,29 @@ public:
 
   core::T_mv prim_Recv(int source, int tag);
 
+  //! Blocking send of a specialized numeric vector straight from its storage
+  void send_vector(core::Vector_sp vector, int dest, int tag);
+  //! Blocking receive into the storage of vector, return (values vector source tag count)
+  core::T_mv recv_vector(core::Vector_sp vector, int source, int tag);
+
+  /*! Nonblocking sends and receives return a request handle that must be
+	  completed with wait_request or test_request */
+  core::Fixnum isend_object(core::T_sp obj, int dest, int tag);
+  core::Fixnum isend_vector(core::Vector_sp vector, int dest, int tag);
+  core::Fixnum irecv_vector(core::Vector_sp vector, int source, int tag);
+  core::T_mv wait_request(core::Fixnum request);
+  core::T_mv test_request(core::Fixnum request);
+
+  //! Collective operations over every process of the communicator
+  void barrier();
+  core::T_sp broadcast(core::T_sp obj, int root);
+  core::Vector_sp broadcast_vector(core::Vector_sp vector, int root);
+  core::T_sp gather_objects(core::T_sp obj, int root);
+  core::T_sp reduce_objects(core::T_sp obj, core::T_sp function, int root);
+  core::T_sp allreduce_objects(core::T_sp obj, core::T_sp function);
+  core::Vector_sp reduce_vector(core::T_sp op, core::Vector_sp source, core::Vector_sp result, int root);
+  core::Vector_sp allreduce_vector(core::T_sp op, core::Vector_sp source, core::Vector_sp result);
+
   DEFAULT_CTOR_DTOR(Mpi_O);
 };
 
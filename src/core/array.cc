@@ -39,6 +39,7 @@ THE SOFTWARE.
 #include <clasp/core/lispStream.h>
 #include <clasp/core/array.h>
 #include <clasp/core/fli.h>
+#include <clasp/core/sort.h>
 #include <clasp/core/wrappers.h>
 
 /*! Adding a new specialized array
@@ -582,9 +583,27 @@ CL_DEFUN T_sp core__PERCENTdisplaced_index_offset(MDArray_sp array) {
   return clasp_make_fixnum(array->displacedIndexOffset());
 }
 
+// Element types whose storage can be copied with memmove.
+// T vectors are excluded because stores of objects may need a write barrier,
+// bit-unit vectors because their elements aren't addressable.
+static bool memmove_copyable_simple_vector_p(AbstractSimpleVector_sp vec) {
+  return gc::IsA<SimpleVector_double_sp>(vec)
+    || gc::IsA<SimpleVector_float_sp>(vec)
+    || gc::IsA<SimpleVector_fixnum_sp>(vec)
+    || gc::IsA<SimpleVector_byte8_t_sp>(vec)
+    || gc::IsA<SimpleVector_int8_t_sp>(vec)
+    || gc::IsA<SimpleVector_byte16_t_sp>(vec)
+    || gc::IsA<SimpleVector_int16_t_sp>(vec)
+    || gc::IsA<SimpleVector_byte32_t_sp>(vec)
+    || gc::IsA<SimpleVector_int32_t_sp>(vec)
+    || gc::IsA<SimpleVector_byte64_t_sp>(vec)
+    || gc::IsA<SimpleVector_int64_t_sp>(vec)
+    || gc::IsA<SimpleVector_size_t_sp>(vec)
+    || gc::IsA<SimpleBaseString_sp>(vec)
+    || gc::IsA<SimpleCharacterString_sp>(vec);
+}
+
 void core__copy_subarray(Array_sp dest, Fixnum_sp destStart, Array_sp orig, Fixnum_sp origStart, Fixnum_sp len) {
-  // TODO: THIS NEEDS TO BE OPTIMIZED FOR DIFFERENT TYPES OF ARRAYS!!!!!!!
-  //       Currently this is very inefficient
   size_t iLen = unbox_fixnum(len);
   if (iLen == 0)
     return;
@@ -594,6 +613,18 @@ void core__copy_subarray(Array_sp dest, Fixnum_sp destStart, Array_sp orig, Fixn
   size_t iOrigStart = unbox_fixnum(origStart);
   if ((iLen + iDestStart) >= dest->arrayTotalSize()) iLen = dest->arrayTotalSize()-iDestStart;
   if ((iLen + iOrigStart) >= orig->arrayTotalSize()) iLen = orig->arrayTotalSize()-iOrigStart;
+  if (iLen == 0) return;
+  // If both arrays store the same unboxed element type, copy the raw storage.
+  AbstractSimpleVector_sp destVec, origVec;
+  size_t destOffset, destEnd, origOffset, origEnd;
+  dest->asAbstractSimpleVectorRange(destVec,destOffset,destEnd);
+  orig->asAbstractSimpleVectorRange(origVec,origOffset,origEnd);
+  if (destVec->__class() == origVec->__class() && memmove_copyable_simple_vector_p(destVec)) {
+    memmove(destVec->rowMajorAddressOfElement_(destOffset+iDestStart),
+            origVec->rowMajorAddressOfElement_(origOffset+iOrigStart),
+            iLen*destVec->elementSizeInBytes());
+    return;
+  }
   if (iDestStart < iOrigStart) {
     for (size_t i = 0; i < iLen; ++i) {
       dest->rowMajorAset(iDestStart, orig->rowMajorAref(iOrigStart));
@@ -1113,6 +1144,47 @@ CL_DEFUN clasp_ffi::ForeignData_sp ext__array_pointer(Array_sp source )
   return clasp_ffi::ForeignData_O::create(source->rowMajorAddressOfElement_(0));
 }
 
+// ------------------------------------------------------------
+//
+// Sorting specialized vectors
+//
+
+template <typename SimpleVectorType>
+bool template_sort_integer_vector(AbstractSimpleVector_sp vec, size_t start, size_t end, bool descending) {
+  if (!gc::IsA<gctools::smart_ptr<SimpleVectorType>>(vec)) return false;
+  typename SimpleVectorType::value_type* data = (typename SimpleVectorType::value_type*)vec->rowMajorAddressOfElement_(start);
+  sort::integerSort(data,end-start,descending);
+  return true;
+}
+
+template <typename SimpleVectorType>
+bool template_sort_float_vector(AbstractSimpleVector_sp vec, size_t start, size_t end, bool descending, bool stable) {
+  if (!gc::IsA<gctools::smart_ptr<SimpleVectorType>>(vec)) return false;
+  typename SimpleVectorType::value_type* data = (typename SimpleVectorType::value_type*)vec->rowMajorAddressOfElement_(start);
+  return sort::floatSort(data,end-start,descending,stable);
+}
+
+CL_LAMBDA(vector descending stable);
+CL_DOCSTRING("Sort a vector specialized on fixnum, (un)signed-byte 8/16/32/64 or single/double-float in place with the predicate < (or > if descending) without calling the predicate. Return T if the vector was sorted and NIL if the vector can't be sorted this way - e.g. it is not a specialized numeric vector or contains NaNs.");
+CL_DEFUN bool core__sort_specialized_vector(Vector_sp vector, bool descending, bool stable) {
+  AbstractSimpleVector_sp vec;
+  size_t start, end;
+  vector->asAbstractSimpleVectorRange(vec,start,end);
+  if (template_sort_integer_vector<SimpleVector_fixnum_O>(vec,start,end,descending)) return true;
+  if (template_sort_float_vector<SimpleVector_double_O>(vec,start,end,descending,stable)) return true;
+  if (template_sort_float_vector<SimpleVector_float_O>(vec,start,end,descending,stable)) return true;
+  if (template_sort_integer_vector<SimpleVector_byte8_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_int8_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_byte16_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_int16_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_byte32_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_int32_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_byte64_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_int64_t_O>(vec,start,end,descending)) return true;
+  if (template_sort_integer_vector<SimpleVector_size_t_O>(vec,start,end,descending)) return true;
+  return false;
+}
+
 CL_DOCSTRING("Pin the objects in the list in memory and then call the thunk");
 CL_DEFUN T_mv ext__pinned_objects_funcall(List_sp objects, T_sp thunk)
 {
@@ -43,17 +43,32 @@ CL_DEFUN Bignum_sp core__next_from_fixnum(Fixnum fix) {
 }
 
 Bignum_sp Bignum_O::create(const mpz_class& c) {
-  const mp_size_t limbsize = sizeof(mp_limb_t);
-  const size_t nails = GMP_NAIL_BITS;
-  // copied from gmp docs
-  size_t numb = 8*limbsize - nails;
-  size_t count = (mpz_sizeinbase(c.get_mpz_t(), 2) + numb - 1) / numb;
-  mp_limb_t dest[count];
-  // These parameters are chosen in order to hopefully
-  // just let GMP copy its limbs directly.
-  mpz_export(dest, &count, -1, limbsize, 0, nails, c.get_mpz_t());
-  mp_size_t len = count * mpz_sgn(c.get_mpz_t());
-  return create_from_limbs(len, 0, false, count, dest);
+  // An mpz stores its magnitude as normalized limbs, least significant
+  // first, same as we do, so we can copy them without an export.
+  mpz_srcptr z = c.get_mpz_t();
+  mp_size_t size = mpz_size(z);
+  mp_size_t len = (mpz_sgn(z) < 0) ? -size : size;
+  return create_from_limbs(len, 0, false, size, mpz_limbs_read(z));
+}
+
+Bignum_sp Bignum_O::create(double d) {
+  // Only called for doubles outside the fixnum range, which are integral
+  // unless they are infinities or NaNs - those have no integer value.
+  if (!std::isfinite(d)) {
+    ERROR(cl::_sym_floatingPointInvalidOperation,
+          core::lisp_createList(kw::_sym_operation, cl::_sym_truncate,
+                                kw::_sym_operands, core::lisp_createList(DoubleFloat_O::create(d))));
+  }
+  // |d| = mantissa * 2^(exponent-53) exactly, with a 53 bit mantissa.
+  int exponent;
+  double fraction = std::frexp(std::abs(d), &exponent);
+  mp_limb_t mantissa = static_cast<mp_limb_t>(std::ldexp(fraction, 53));
+  mp_size_t len = (d < 0) ? -1 : 1;
+  Fixnum shift = exponent - 53;
+  if (shift >= 0)
+    return next_lshift(&mantissa, len, shift);
+  mantissa >>= -shift;
+  return create_from_limbs(len, mantissa, true);
 }
 
 void Bignum_O::sxhash_(HashGenerator &hg) const {
@@ -83,15 +98,15 @@ Integer_sp bignum_result(mp_size_t len, const mp_limb_t* limbs) {
 }
 
 mpz_class Bignum_O::mpz() const {
+  // Copy the limbs straight into the mpz - mpz_limbs_finish takes the
+  // signed length, so no separate negation is needed.
   mp_size_t len = this->length();
+  mp_size_t size = std::abs(len);
   mpz_class m;
-  mpz_import(m.get_mpz_t(), std::abs(len), -1, sizeof(mp_limb_t), 0, GMP_NAIL_BITS,
-             this->limbs());
-  if (len < 0) {
-    mpz_class r;
-    mpz_neg(r.get_mpz_t(), m.get_mpz_t());
-    return r;
-  } else return m;
+  mp_limb_t* dest = mpz_limbs_write(m.get_mpz_t(), size);
+  memcpy(dest, this->limbs(), size*sizeof(mp_limb_t));
+  mpz_limbs_finish(m.get_mpz_t(), len);
+  return m;
 }
 
 string Bignum_O::__repr__() const {
@@ -252,11 +267,11 @@ CL_DEFUN Integer_sp core__next_fmul(Bignum_sp left, Fixnum right) {
   return bignum_result(result_len, result_limbs);
 }
 
-CL_DEFUN Bignum_sp core__next_lshift(Bignum_sp num, Fixnum shift) {
+// Shift the magnitude LIMBS with signed length LEN left by SHIFT >= 0 bits.
+// LEN must not be zero, and the result must not fit in a fixnum.
+Bignum_sp next_lshift(const mp_limb_t* limbs, mp_size_t len, Fixnum shift) {
   ASSERT(shift >= 0);
-  mp_size_t len = num->length();
   size_t size = std::abs(len);
-  const mp_limb_t* limbs = num->limbs();
   unsigned int nlimbs = shift / mp_bits_per_limb;
   unsigned int nbits = shift % mp_bits_per_limb;
   size_t result_size = size + nlimbs + 1;
@@ -266,19 +281,29 @@ CL_DEFUN Bignum_sp core__next_lshift(Bignum_sp num, Fixnum shift) {
   if (nbits == 0) {
     carry = 0;
     // do the "carry" ourselves by copying memory
-    // FIXME: memcpy? std::copy?
-    for (size_t i = 0; i < size; ++i) result_limbs[nlimbs+i] = limbs[i];
+    mpn_copyi(&(result_limbs[nlimbs]), limbs, size);
   }
   else carry = mpn_lshift(&(result_limbs[nlimbs]), limbs, size, nbits);
   if (carry == 0) --result_size;
   else result_limbs[result_size-1] = carry;
-  for (size_t i = 0; i < nlimbs; ++i) result_limbs[i] = 0;
-  // Since we start with a bignum, and we're making it bigger, we have a bignum.
+  mpn_zero(result_limbs, nlimbs);
   return Bignum_O::create_from_limbs((len < 0) ?
                                             -result_size : result_size, 0, false,
                                             result_size, result_limbs);
 }
 
+CL_DEFUN Bignum_sp core__next_lshift(Bignum_sp num, Fixnum shift) {
+  // Since we start with a bignum, and we're making it bigger, we have a bignum.
+  return next_lshift(num->limbs(), num->length(), shift);
+}
+
+// Used by clasp_shift when shifting a fixnum left overflows.
+Integer_sp next_fixnum_lshift(Fixnum num, Fixnum shift) {
+  if (num == 0) return clasp_make_fixnum(0);
+  mp_limb_t limb = (num < 0) ? -num : num;
+  return next_lshift(&limb, (num < 0) ? -1 : 1, shift);
+}
+
 CL_DEFUN Integer_sp core__next_rshift(Bignum_sp num, Fixnum shift) {
   ASSERT(shift >= 0);
   mp_size_t len = num->length();
@@ -294,8 +319,7 @@ CL_DEFUN Integer_sp core__next_rshift(Bignum_sp num, Fixnum shift) {
     mp_limb_t copy[size];
     mpn_sub_1(copy, limbs, size, 1);
     if (nbits == 0) {
-      // FIXME: memcpy? std::copy?
-      for (size_t i = 0; i < result_size; ++i) result_limbs[i] = copy[nlimbs+i];
+      mpn_copyi(result_limbs, &(copy[nlimbs]), result_size);
       mpn_add_1(result_limbs, result_limbs, result_size, 1);
     } else {
       mpn_rshift(result_limbs, &(copy[nlimbs]), result_size, nbits);
@@ -309,8 +333,7 @@ CL_DEFUN Integer_sp core__next_rshift(Bignum_sp num, Fixnum shift) {
     size_t result_size = size - nlimbs;
     mp_limb_t result_limbs[result_size];
     if (nbits == 0) {
-      // FIXME: memcpy? std::copy?
-      for (size_t i = 0; i < result_size; ++i) result_limbs[i] = limbs[nlimbs+i];
+      mpn_copyi(result_limbs, &(limbs[nlimbs]), result_size);
       // input bignum is normalized, so high limb is not zero
     } else {
       // we don't need outshifted bits, so we ignore mpn_rshift's return value
@@ -464,8 +487,7 @@ Integer_sp next_gcd(const mp_limb_t* llimbs, mp_size_t lsize,
   n_left_zero_bits = __builtin_ctzll(llimbs[0]);
   mp_limb_t llimbs_copy[lsize];
   if (n_left_zero_bits == 0) {
-    // FIXME: Could memcpy/whatever.
-    for (mp_size_t i = 0; i < lsize; ++i) llimbs_copy[i] = llimbs[i];
+    mpn_copyi(llimbs_copy, llimbs, lsize);
   } else {
     mpn_rshift(llimbs_copy, llimbs, lsize, n_left_zero_bits);
     if (llimbs_copy[lsize-1] == 0) --lsize;
@@ -480,7 +502,7 @@ Integer_sp next_gcd(const mp_limb_t* llimbs, mp_size_t lsize,
   n_right_zero_bits = __builtin_ctzll(rlimbs[0]);
   mp_limb_t rlimbs_copy[rsize];
   if (n_right_zero_bits == 0) {
-    for (mp_size_t i = 0; i < rsize; ++i) rlimbs_copy[i] = rlimbs[i];
+    mpn_copyi(rlimbs_copy, rlimbs, rsize);
   } else {
     mpn_rshift(rlimbs_copy, rlimbs, rsize, n_right_zero_bits);
     if (rlimbs_copy[rsize-1] == 0) --rsize;
@@ -519,12 +541,9 @@ Integer_sp next_gcd(const mp_limb_t* llimbs, mp_size_t lsize,
   // and otherwise construct it.
   mp_limb_t result_size = gcd_size + n_result_zero_limbs;
   mp_limb_t result_limbs[result_size+1]; // +1 for space to shift into.
-  for (mp_size_t i = 0; i < n_result_zero_limbs; ++i)
-    result_limbs[i] = 0;
+  mpn_zero(result_limbs, n_result_zero_limbs);
   if (n_result_zero_bits == 0) {
-    // FIXME blabla memcpy
-    for (mp_size_t i = 0; i < gcd_size; ++i)
-      result_limbs[i+n_result_zero_limbs] = gcd_limbs[i];
+    mpn_copyi(&(result_limbs[n_result_zero_limbs]), gcd_limbs, gcd_size);
   } else {
     mp_limb_t carry;
     carry = mpn_lshift(&(result_limbs[n_result_zero_limbs]),
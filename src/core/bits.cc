@@ -728,7 +728,8 @@ Integer_sp clasp_boole(Fixnum op, Integer_sp i1, Integer_sp i2) {
       Bignum_sp left = gc::As<Bignum_sp>(i1);
       Bignum_sp right = gc::As<Bignum_sp>(i2);
       mp_size_t llen = left->length(), rlen = right->length();
-      mp_limb_t result[std::max(std::abs(llen), std::abs(rlen))];
+      // +1 since the result can be a limb longer, see next_operation_rest.
+      mp_limb_t result[std::max(std::abs(llen), std::abs(rlen)) + 1];
       next_bit_operator bop = next_operations[op];
       mp_size_t res_len = bop(result, left->limbs(), llen, right->limbs(), rlen);
       return bignum_result(res_len, result);
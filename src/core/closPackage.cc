@@ -54,6 +54,7 @@ SYMBOL_EXPORT_SC_(ClosPkg, DEPENDENTS);
 SYMBOL_EXPORT_SC_(ClosPkg, SLOTS);
 SYMBOL_EXPORT_SC_(ClosPkg, DIRECT_DEFAULT_INITARGS);
 SYMBOL_EXPORT_SC_(ClosPkg, FINALIZED);
+SYMBOL_SC_(ClosPkg, SIZE);
 SYMBOL_EXPORT_SC_(ClosPkg, PRECEDENCE_LIST);
 SYMBOL_EXPORT_SC_(ClosPkg, DIRECT_SLOTS);
 SYMBOL_EXPORT_SC_(ClosPkg, DEFAULT_INITARGS);
@@ -240,15 +240,22 @@ CL_DEFUN T_sp cl__make_hash_table(T_sp test, Fixnum_sp size,
                                   Symbol_sp weakness, T_sp debug,
                                   T_sp thread_safe, T_sp hashf) {
   SYMBOL_EXPORT_SC_(KeywordPkg, key);
+  SYMBOL_EXPORT_SC_(KeywordPkg, value);
+  SYMBOL_EXPORT_SC_(KeywordPkg, key_and_value);
+  SYMBOL_EXPORT_SC_(KeywordPkg, key_or_value);
   if (weakness.notnilp()) {
-    if (weakness == INTERN_(kw, key)) {
+    if (weakness == kw::_sym_key || weakness == kw::_sym_value || weakness == kw::_sym_key_and_value) {
       if (test == cl::_sym_eq || test == cl::_sym_eq->symbolFunction()) {
-        return core__make_weak_key_hash_table(size);
+        return core__make_weak_key_hash_table(size,weakness);
       } else {
         SIMPLE_ERROR(BF("Weak hash tables non-EQ tests are not yet supported"));
       }
     }
-    SIMPLE_ERROR(BF("Only :weakness :key (weak-key hash tables) are currently supported"));
+    if (weakness == kw::_sym_key_or_value) {
+      // Keeping an entry while either side is reachable needs ephemeron support from the collector
+      SIMPLE_ERROR(BF(":weakness :key-or-value is not supported by this garbage collector"));
+    }
+    SIMPLE_ERROR(BF("Only :weakness :key, :value or :key-and-value are currently supported"));
   }
   double rehash_threshold = maybeFixRehashThreshold(clasp_to_double(orehash_threshold));
   HashTable_sp table = _Nil<HashTable_O>();
@@ -291,7 +298,7 @@ CL_DECLARE();
 CL_DOCSTRING("hash_table_weakness");
 CL_DEFUN Symbol_sp core__hash_table_weakness(T_sp ht) {
   if (gc::IsA<WeakKeyHashTable_sp>(ht)) {
-    return kw::_sym_key;
+    return gc::As_unsafe<WeakKeyHashTable_sp>(ht)->weakness();
   }
   return _Nil<Symbol_O>();
 }
@@ -142,6 +142,7 @@ CL_DEFUN List_sp core__class_slot_sanity_check()
   ADD_SANITY_CHECK_SIMPLE(SLOTS,CLASS_SLOTS);
   ADD_SANITY_CHECK_SIMPLE(DIRECT_DEFAULT_INITARGS,CLASS_DIRECT_DEFAULT_INITARGS);
   ADD_SANITY_CHECK_SIMPLE(FINALIZED,CLASS_FINALIZED);
+  ADD_SANITY_CHECK_SIMPLE(SIZE,CLASS_SIZE);
   ADD_SANITY_CHECK_SIMPLE(PRECEDENCE_LIST,CLASS_CLASS_PRECEDENCE_LIST);
   ADD_SANITY_CHECK_SIMPLE(DIRECT_SLOTS,CLASS_DIRECT_SLOTS);
   ADD_SANITY_CHECK_SIMPLE(DEFAULT_INITARGS,CLASS_DEFAULT_INITARGS);
@@ -47,6 +47,8 @@ THE SOFTWARE.
 #include <clasp/core/numbers.h>
 #include <clasp/core/bignum.h>
 #include <clasp/core/num_arith.h>
+#include <clasp/core/array.h>
+#include <clasp/core/sequence.h>
 #include <clasp/core/wrappers.h>
 #include <clasp/core/mathDispatch.h>
 
@@ -162,4 +164,170 @@ CL_DEFUN Integer_sp cl__lcm(List_sp nums) {
   SYMBOL_EXPORT_SC_(ClPkg, gcd);
   SYMBOL_EXPORT_SC_(ClPkg, lcm);
 
+// ------------------------------------------------------------
+//
+// Exact summation
+//
+// Summing rationals with the generic + conses an intermediate bignum
+// or ratio for every element and normalizes every ratio with a gcd.
+// ExactSum keeps the running sum in mpz_class variables that are updated
+// in place, with an unnormalized denominator, and normalizes once when
+// the result is extracted. Floats are added exactly into a separate
+// binary fixed point accumulator.
+
+struct ExactSum {
+  // The sum is _Numerator/_Denominator + _Binary*2^_BinaryExponent
+  mpz_class _Numerator;
+  mpz_class _Denominator;
+  mpz_class _Binary;
+  Fixnum _BinaryExponent;
+  mpz_class _Temp;
+  ExactSum() : _Numerator(0), _Denominator(1), _Binary(0), _BinaryExponent(0) {};
+
+  // Return a read only mpz view of the integer without copying the limbs.
+  static mpz_srcptr integerView(Integer_sp i, mpz_t storage, mp_limb_t& limb) {
+    if (i.fixnump()) {
+      Fixnum f = i.unsafe_fixnum();
+      limb = (f < 0) ? -f : f;
+      return mpz_roinit_n(storage, &limb, (f < 0) ? -1 : (f > 0) ? 1 : 0);
+    }
+    Bignum_sp b = gc::As_unsafe<Bignum_sp>(i);
+    return mpz_roinit_n(storage, b->limbs(), b->length());
+  }
+
+  void addInteger(mpz_srcptr n) {
+    if (mpz_cmp_ui(this->_Denominator.get_mpz_t(), 1) == 0)
+      mpz_add(this->_Numerator.get_mpz_t(), this->_Numerator.get_mpz_t(), n);
+    else
+      mpz_addmul(this->_Numerator.get_mpz_t(), n, this->_Denominator.get_mpz_t());
+  }
+
+  void addRatio(mpz_srcptr n, mpz_srcptr d) {
+    mpz_ptr num = this->_Numerator.get_mpz_t();
+    mpz_ptr den = this->_Denominator.get_mpz_t();
+    mpz_ptr temp = this->_Temp.get_mpz_t();
+    if (mpz_cmp(den, d) == 0) {
+      // The common case when summing e.g. amounts of cents
+      mpz_add(num, num, n);
+    } else if (mpz_divisible_p(den, d)) {
+      mpz_divexact(temp, den, d);
+      mpz_addmul(num, n, temp);
+    } else {
+      // Use the lcm of the denominators so the denominator doesn't grow
+      // with the number of elements. num/den + n/d with g = gcd(den,d) is
+      // (num*(d/g) + n*(den/g)) / (den*(d/g))
+      mpz_class g, dg;
+      mpz_gcd(g.get_mpz_t(), den, d);
+      mpz_divexact(dg.get_mpz_t(), d, g.get_mpz_t());
+      mpz_divexact(temp, den, g.get_mpz_t());
+      mpz_mul(num, num, dg.get_mpz_t());
+      mpz_addmul(num, n, temp);
+      mpz_mul(den, den, dg.get_mpz_t());
+    }
+  }
+
+  // Return false if x is not finite - that can't be summed exactly.
+  bool addDouble(double x) {
+    if (!std::isfinite(x)) return false;
+    if (x == 0.0) return true;
+    int e;
+    double fraction = std::frexp(x, &e);
+    // x = mantissa * 2^exponent exactly
+    int64_t mantissa = static_cast<int64_t>(std::ldexp(fraction, 53));
+    Fixnum exponent = e - 53;
+    mpz_ptr binary = this->_Binary.get_mpz_t();
+    mpz_ptr temp = this->_Temp.get_mpz_t();
+    if (mpz_sgn(binary) == 0) {
+      mpz_set_si(binary, mantissa);
+      this->_BinaryExponent = exponent;
+    } else if (exponent >= this->_BinaryExponent) {
+      mpz_set_si(temp, mantissa);
+      mpz_mul_2exp(temp, temp, exponent - this->_BinaryExponent);
+      mpz_add(binary, binary, temp);
+    } else {
+      mpz_mul_2exp(binary, binary, this->_BinaryExponent - exponent);
+      this->_BinaryExponent = exponent;
+      if (mantissa < 0) mpz_sub_ui(binary, binary, -mantissa);
+      else mpz_add_ui(binary, binary, mantissa);
+    }
+    return true;
+  }
+
+  // Add the number if it can be added exactly and return true, else return false.
+  bool add(T_sp x, bool exactFloats, T_sp& floatPrototype) {
+    mpz_t storage, dstorage;
+    mp_limb_t limb, dlimb;
+    if (x.fixnump() || gc::IsA<Bignum_sp>(x)) {
+      this->addInteger(integerView(gc::As_unsafe<Integer_sp>(x), storage, limb));
+      return true;
+    }
+    if (gc::IsA<Ratio_sp>(x)) {
+      Ratio_sp r = gc::As_unsafe<Ratio_sp>(x);
+      this->addRatio(integerView(r->numerator(), storage, limb),
+                     integerView(r->denominator(), dstorage, dlimb));
+      return true;
+    }
+    if (!exactFloats) return false;
+    if (x.single_floatp()) {
+      if (!this->addDouble(x.unsafe_single_float())) return false;
+      if (floatPrototype.nilp()) floatPrototype = x;
+      return true;
+    }
+    if (gc::IsA<DoubleFloat_sp>(x)) {
+      if (!this->addDouble(gc::As_unsafe<DoubleFloat_sp>(x)->get())) return false;
+      floatPrototype = x;
+      return true;
+    }
+    return false;
+  }
+
+  Rational_sp value() {
+    mpz_class num, den;
+    if (mpz_sgn(this->_Binary.get_mpz_t()) == 0) {
+      num = this->_Numerator;
+      den = this->_Denominator;
+    } else if (this->_BinaryExponent >= 0) {
+      mpz_mul_2exp(this->_Temp.get_mpz_t(), this->_Binary.get_mpz_t(), this->_BinaryExponent);
+      num = this->_Numerator;
+      mpz_addmul(num.get_mpz_t(), this->_Temp.get_mpz_t(), this->_Denominator.get_mpz_t());
+      den = this->_Denominator;
+    } else {
+      mpz_mul_2exp(num.get_mpz_t(), this->_Numerator.get_mpz_t(), -this->_BinaryExponent);
+      mpz_addmul(num.get_mpz_t(), this->_Binary.get_mpz_t(), this->_Denominator.get_mpz_t());
+      mpz_mul_2exp(den.get_mpz_t(), this->_Denominator.get_mpz_t(), -this->_BinaryExponent);
+    }
+    mpz_gcd(this->_Temp.get_mpz_t(), num.get_mpz_t(), den.get_mpz_t());
+    if (mpz_cmp_ui(this->_Temp.get_mpz_t(), 1) > 0) {
+      mpz_divexact(num.get_mpz_t(), num.get_mpz_t(), this->_Temp.get_mpz_t());
+      mpz_divexact(den.get_mpz_t(), den.get_mpz_t(), this->_Temp.get_mpz_t());
+    }
+    if (den == 1) return Integer_O::create(num);
+    return Ratio_O::create_primitive(Integer_O::create(num), Integer_O::create(den));
+  }
+};
+
+SYMBOL_EXPORT_SC_(CorePkg, exact_sum);
+CL_LAMBDA(sequence start end exact-floats);
+CL_DOCSTRING("Sum the elements of the list or vector SEQUENCE from START to END exactly. Stop at the first element that can't be summed exactly - anything that is not a rational, or not a finite float if EXACT-FLOATS is true. Return the exact sum as a rational, the index of the element where summing stopped (END if it didn't) and the widest float that was summed or NIL.");
+CL_DEFUN T_mv core__exact_sum(T_sp sequence, size_t start, T_sp end, bool exact_floats) {
+  ExactSum sum;
+  T_sp floatPrototype = _Nil<T_O>();
+  size_t index = start;
+  if (sequence.consp() || sequence.nilp()) {
+    size_t iend = end.nilp() ? ~(size_t)0 : unbox_fixnum(gc::As<Fixnum_sp>(end));
+    List_sp cur = sequence;
+    for (size_t i = 0; i < start && cur.consp(); ++i) cur = oCdr(cur);
+    for (; index < iend && cur.consp(); ++index, cur = oCdr(cur)) {
+      if (!sum.add(oCar(cur), exact_floats, floatPrototype)) break;
+    }
+  } else {
+    Vector_sp vec = gc::As<Vector_sp>(sequence);
+    size_t_pair p = sequenceStartEnd(core::_sym_exact_sum, vec->length(), start, end);
+    for (index = p.start; index < p.end; ++index) {
+      if (!sum.add(vec->rowMajorAref(index), exact_floats, floatPrototype)) break;
+    }
+  }
+  return Values(sum.value(), clasp_make_fixnum(index), floatPrototype);
+}
+
 };
@@ -34,6 +34,13 @@ THE SOFTWARE.
 #include <clasp/core/hashTableEq.h>
 #include <clasp/core/symbolTable.h>
 #include <clasp/core/serialize.h>
+#include <clasp/core/bignum.h>
+#include <clasp/core/instance.h>
+#include <clasp/core/package.h>
+#include <clasp/core/predicates.h>
+#include <clasp/core/designators.h>
+#include <clasp/core/array_int8.h>
+#include <clasp/core/sequence.h>
 
 #include <clasp/core/wrappers.h>
 
@@ -50,4 +57,592 @@ CL_DEFUN Serializer_sp make_serializer(const std::string& s) {
   return ser;
 };
 
+/*! Binary object archives.
+
+An archive is a header (magic, format version, byte order/word size)
+followed by one object.  Every object starts with a tag byte.  Conses,
+symbols, packages, vectors, hash tables and instances are numbered in the
+order they are first written and later occurrences are written as a
+reference to that number, so sharing and cycles survive a round trip.
+Unboxed vectors and strings are written as their raw storage.  Vectors
+with a fill pointer or that are adjustable are written as a header with
+the element type, size and fill pointer followed by their contents as a
+separate simple vector; displacement is not kept.  Symbols are
+written by package name and symbol name and are re-interned when read;
+classes are written by name; instances of standard and structure classes
+are written as their class name and the contents of their rack.
+*/
+
+#define SERIALIZE_VERSION 2
+#define SERIALIZE_BYTE_ORDER ((sizeof(void*)<<1) | (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ ? 1 : 0))
+
+typedef enum {
+  serialize_nil = 0,
+  serialize_fixnum,
+  serialize_character,
+  serialize_single_float,
+  serialize_double_float,
+  serialize_bignum,
+  serialize_ratio,
+  serialize_complex,
+  serialize_unbound,
+  serialize_reference,
+  serialize_cons,
+  serialize_symbol,
+  serialize_uninterned_symbol,
+  serialize_package,
+  serialize_raw_vector,
+  serialize_bit_vector,
+  serialize_simple_vector,
+  serialize_hash_table,
+  serialize_class,
+  serialize_instance,
+  serialize_complex_vector
+} SerializeTag;
+
+// Vectors whose storage is written byte for byte.  The codes are part of the format.
+#define SERIALIZE_RAW_VECTOR_KINDS(X) \
+  X(1, SimpleVector_double_O) \
+  X(2, SimpleVector_float_O) \
+  X(3, SimpleVector_fixnum_O) \
+  X(4, SimpleVector_byte8_t_O) \
+  X(5, SimpleVector_int8_t_O) \
+  X(6, SimpleVector_byte16_t_O) \
+  X(7, SimpleVector_int16_t_O) \
+  X(8, SimpleVector_byte32_t_O) \
+  X(9, SimpleVector_int32_t_O) \
+  X(10, SimpleVector_byte64_t_O) \
+  X(11, SimpleVector_int64_t_O) \
+  X(12, SimpleVector_size_t_O) \
+  X(13, SimpleBaseString_O) \
+  X(14, SimpleCharacterString_O)
+
+static const char serialize_magic[4] = {'C','L','S','B'};
+
+struct BinarySerializer {
+  std::vector<unsigned char> _Buffer;
+  HashTableEq_sp _Shared;
+  size_t _NextIndex;
+  BinarySerializer() : _Shared(HashTableEq_O::create_default()), _NextIndex(0) {
+    this->writeBytes(serialize_magic,sizeof(serialize_magic));
+    this->writeByte(SERIALIZE_VERSION);
+    this->writeByte(SERIALIZE_BYTE_ORDER);
+  }
+  void writeByte(unsigned char b) { this->_Buffer.push_back(b); }
+  void writeBytes(const void* data, size_t len) {
+    const unsigned char* bytes = (const unsigned char*)data;
+    this->_Buffer.insert(this->_Buffer.end(),bytes,bytes+len);
+  }
+  void writeUnsigned(uint64_t val) {
+    while (val >= 0x80) {
+      this->writeByte((unsigned char)(val|0x80));
+      val >>= 7;
+    }
+    this->writeByte((unsigned char)val);
+  }
+  void writeSigned(int64_t val) { this->writeUnsigned(((uint64_t)val<<1) ^ (uint64_t)(val>>63)); }
+  // Returns true if OBJ was already written, in which case a reference has been emitted.
+  bool writeReferenceOrRegister(T_sp obj) {
+    T_sp index = this->_Shared->gethash(obj,_Unbound<T_O>());
+    if (index.unboundp()) {
+      this->_Shared->setf_gethash(obj,make_fixnum(this->_NextIndex++));
+      return false;
+    }
+    this->writeByte(serialize_reference);
+    this->writeUnsigned(index.unsafe_fixnum());
+    return true;
+  }
+  void writeCons(Cons_sp cons);
+  void writeVectorRange(AbstractSimpleVector_sp vec, size_t start, size_t end);
+  void writeVector(T_sp obj);
+  void writeComplexVector(Array_sp array);
+  void writeHashTable(HashTable_sp table);
+  void writeInstance(Instance_sp instance);
+  void write(T_sp obj);
+};
+
+void BinarySerializer::writeCons(Cons_sp cons) {
+  // Walk the cdr chain iteratively so that long lists don't use stack.
+  T_sp cur = cons;
+  while (true) {
+    this->writeByte(serialize_cons);
+    this->write(CONS_CAR(cur));
+    cur = CONS_CDR(cur);
+    if (!cur.consp() || this->writeReferenceOrRegister(cur)) break;
+  }
+  if (!cur.consp()) this->write(cur);
+}
+
+void BinarySerializer::writeVectorRange(AbstractSimpleVector_sp vec, size_t start, size_t end) {
+  size_t len = end-start;
+#define SERIALIZE_WRITE_RAW(code,vectorClass) \
+  if (gc::IsA<gc::smart_ptr<vectorClass>>(vec)) { \
+    this->writeByte(serialize_raw_vector); \
+    this->writeByte(code); \
+    this->writeUnsigned(len); \
+    if (len) this->writeBytes(vec->rowMajorAddressOfElement_(start),len*vec->elementSizeInBytes()); \
+    return; \
+  }
+  SERIALIZE_RAW_VECTOR_KINDS(SERIALIZE_WRITE_RAW);
+#undef SERIALIZE_WRITE_RAW
+  if (gc::IsA<SimpleBitVector_sp>(vec)) {
+    SimpleBitVector_sp bv = gc::As_unsafe<SimpleBitVector_sp>(vec);
+    this->writeByte(serialize_bit_vector);
+    this->writeUnsigned(len);
+    for (size_t i = 0; i < len; i += 8) {
+      unsigned char byte = 0;
+      for (size_t j = 0; j < 8 && i+j < len; ++j) {
+        if (bv->testBit(start+i+j)) byte |= (1<<j);
+      }
+      this->writeByte(byte);
+    }
+    return;
+  }
+  if (gc::IsA<SimpleVector_sp>(vec)) {
+    SimpleVector_sp sv = gc::As_unsafe<SimpleVector_sp>(vec);
+    this->writeByte(serialize_simple_vector);
+    this->writeUnsigned(len);
+    for (size_t i = start; i < end; ++i) this->write((*sv)[i]);
+    return;
+  }
+  SIMPLE_ERROR(BF("Cannot serialize vectors of element-type %s") % _rep_(vec->element_type()));
+}
+
+void BinarySerializer::writeVector(T_sp obj) {
+  AbstractSimpleVector_sp vec;
+  size_t start, end;
+  gc::As_unsafe<Array_sp>(obj)->asAbstractSimpleVectorRange(vec,start,end);
+  this->writeVectorRange(vec,start,end);
+}
+
+void BinarySerializer::writeComplexVector(Array_sp array) {
+  AbstractSimpleVector_sp vec;
+  size_t start, end;
+  array->asAbstractSimpleVectorRange(vec,start,end);
+  size_t size = array->arrayTotalSize();
+  bool fillPointerP = array->arrayHasFillPointerP();
+  this->writeByte(serialize_complex_vector);
+  this->writeByte((fillPointerP ? 1 : 0) | (array->adjustableArrayP() ? 2 : 0));
+  this->write(vec->element_type());
+  this->writeUnsigned(size);
+  if (fillPointerP) this->writeUnsigned(array->fillPointer());
+  // The contents, up to the full size, are a vector of their own that the
+  // reader numbers as well.
+  ++this->_NextIndex;
+  this->writeVectorRange(vec,start,start+size);
+}
+
+void BinarySerializer::writeHashTable(HashTable_sp table) {
+  T_sp test = table->hashTableTest();
+  unsigned char code;
+  if (test == cl::_sym_eq) code = 0;
+  else if (test == cl::_sym_eql) code = 1;
+  else if (test == cl::_sym_equal) code = 2;
+  else if (test == cl::_sym_equalp) code = 3;
+  else SIMPLE_ERROR(BF("Cannot serialize hash tables with test %s") % _rep_(test));
+  this->writeByte(serialize_hash_table);
+  this->writeByte(code);
+  this->writeUnsigned(table->hashTableCount());
+  table->mapHash([this] (T_sp key, T_sp value) {
+      this->write(key);
+      this->write(value);
+    });
+}
+
+void BinarySerializer::writeInstance(Instance_sp instance) {
+  if (clos__classp(instance)) {
+    this->writeByte(serialize_class);
+    this->write(instance->_className());
+    return;
+  }
+  if (typeid(*instance) != typeid(Instance_O) || !gc::IsA<Rack_sp>(instance->_Rack)) {
+    SIMPLE_ERROR(BF("Cannot serialize %s") % _rep_(instance));
+  }
+  Rack_sp rack = instance->_Rack;
+  size_t numberOfSlots = rack->length();
+  this->writeByte(serialize_instance);
+  this->write(instance->_Class->_className());
+  this->writeUnsigned(numberOfSlots);
+  for (size_t i = 0; i < numberOfSlots; ++i) this->write(rack->low_level_rackRef(i));
+}
+
+void BinarySerializer::write(T_sp obj) {
+  if (obj.nilp()) {
+    this->writeByte(serialize_nil);
+  } else if (obj.fixnump()) {
+    this->writeByte(serialize_fixnum);
+    this->writeSigned(obj.unsafe_fixnum());
+  } else if (obj.characterp()) {
+    this->writeByte(serialize_character);
+    this->writeUnsigned(obj.unsafe_character());
+  } else if (obj.single_floatp()) {
+    float f = obj.unsafe_single_float();
+    this->writeByte(serialize_single_float);
+    this->writeBytes(&f,sizeof(f));
+  } else if (obj.unboundp()) {
+    this->writeByte(serialize_unbound);
+  } else if (obj.consp()) {
+    if (!this->writeReferenceOrRegister(obj)) this->writeCons(gc::As_unsafe<Cons_sp>(obj));
+  } else if (DoubleFloat_sp df = obj.asOrNull<DoubleFloat_O>()) {
+    double d = df->get();
+    this->writeByte(serialize_double_float);
+    this->writeBytes(&d,sizeof(d));
+  } else if (Bignum_sp big = obj.asOrNull<Bignum_O>()) {
+    mp_size_t len = big->length();
+    this->writeByte(serialize_bignum);
+    this->writeSigned(len);
+    this->writeBytes(big->limbs(),std::abs(len)*sizeof(mp_limb_t));
+  } else if (Ratio_sp ratio = obj.asOrNull<Ratio_O>()) {
+    this->writeByte(serialize_ratio);
+    this->write(ratio->numerator());
+    this->write(ratio->denominator());
+  } else if (Complex_sp complex = obj.asOrNull<Complex_O>()) {
+    this->writeByte(serialize_complex);
+    this->write(complex->real());
+    this->write(complex->imaginary());
+  } else if (obj.generalp()) {
+    if (this->writeReferenceOrRegister(obj)) return;
+    if (Symbol_sp sym = obj.asOrNull<Symbol_O>()) {
+      T_sp pkg = sym->homePackage();
+      if (pkg.nilp()) {
+        this->writeByte(serialize_uninterned_symbol);
+      } else {
+        this->writeByte(serialize_symbol);
+        this->write(gc::As<Package_sp>(pkg)->_Name);
+      }
+      this->write(sym->symbolName());
+    } else if (Package_sp pkg = obj.asOrNull<Package_O>()) {
+      this->writeByte(serialize_package);
+      this->write(pkg->_Name);
+    } else if (gc::IsA<Array_sp>(obj) && gc::As_unsafe<Array_sp>(obj)->rank() == 1) {
+      Array_sp array = gc::As_unsafe<Array_sp>(obj);
+      if (array->arrayHasFillPointerP() || array->adjustableArrayP()) this->writeComplexVector(array);
+      else this->writeVector(obj);
+    } else if (HashTable_sp table = obj.asOrNull<HashTable_O>()) {
+      this->writeHashTable(table);
+    } else if (Instance_sp instance = obj.asOrNull<Instance_O>()) {
+      this->writeInstance(instance);
+    } else {
+      SIMPLE_ERROR(BF("Cannot serialize %s") % _rep_(obj));
+    }
+  } else {
+    SIMPLE_ERROR(BF("Cannot serialize %s") % _rep_(obj));
+  }
+}
+
+struct BinaryDeserializer {
+  const unsigned char* _Cur;
+  const unsigned char* _End;
+  ComplexVector_T_sp _Shared;
+  BinaryDeserializer(const unsigned char* start, const unsigned char* end)
+    : _Cur(start), _End(end), _Shared(ComplexVector_T_O::make(64,_Nil<T_O>(),clasp_make_fixnum(0))) {
+    if (end-start < (ptrdiff_t)(sizeof(serialize_magic)+2) || memcmp(start,serialize_magic,sizeof(serialize_magic)) != 0) {
+      SIMPLE_ERROR(BF("The octets do not contain a serialized object"));
+    }
+    this->_Cur += sizeof(serialize_magic);
+    unsigned char version = this->readByte();
+    if (version != SERIALIZE_VERSION) {
+      SIMPLE_ERROR(BF("Cannot read serialization format version %d - only version %d is supported") % (int)version % SERIALIZE_VERSION);
+    }
+    if (this->readByte() != SERIALIZE_BYTE_ORDER) {
+      SIMPLE_ERROR(BF("The serialized object was written on a machine with a different byte order or word size"));
+    }
+  }
+  [[noreturn]] void truncated() { SIMPLE_ERROR(BF("Serialized object is truncated")); }
+  void need(size_t len) { if ((size_t)(this->_End-this->_Cur) < len) this->truncated(); }
+  // Check that COUNT elements of at least ELEMENT_SIZE bytes each can
+  // still be read, before allocating anything for them.
+  void needElements(size_t count, size_t element_size) {
+    if (count > (size_t)(this->_End-this->_Cur)/element_size) this->truncated();
+  }
+  unsigned char readByte() {
+    this->need(1);
+    return *this->_Cur++;
+  }
+  void readBytes(void* dest, size_t len) {
+    this->need(len);
+    memcpy(dest,this->_Cur,len);
+    this->_Cur += len;
+  }
+  uint64_t readUnsigned() {
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      unsigned char byte = this->readByte();
+      result |= (uint64_t)(byte&0x7f) << shift;
+      if (!(byte&0x80)) return result;
+    }
+    SIMPLE_ERROR(BF("Malformed integer in serialized object"));
+  }
+  int64_t readSigned() {
+    uint64_t val = this->readUnsigned();
+    return (int64_t)(val>>1) ^ -(int64_t)(val&1);
+  }
+  // Names are written as string objects, so they keep any character.
+  SimpleString_sp readName() {
+    T_sp name = this->read();
+    if (!gc::IsA<SimpleString_sp>(name)) {
+      SIMPLE_ERROR(BF("Expected a name in serialized object but got %s") % _rep_(name));
+    }
+    return gc::As_unsafe<SimpleString_sp>(name);
+  }
+  // Reserve the index of the object about to be read; fill it with registerAt.
+  size_t reserve() {
+    size_t index = this->_Shared->length();
+    this->_Shared->vectorPushExtend(_Nil<T_O>());
+    return index;
+  }
+  T_sp registerAt(size_t index, T_sp obj) {
+    this->_Shared->rowMajorAset(index,obj);
+    return obj;
+  }
+  T_sp readCons();
+  T_sp readRawVector();
+  T_sp readComplexVector(size_t index);
+  T_sp readHashTable(size_t index);
+  T_sp readInstance(size_t index);
+  T_sp read();
+};
+
+T_sp BinaryDeserializer::readCons() {
+  Cons_sp head = Cons_O::create(_Nil<T_O>(),_Nil<T_O>());
+  this->registerAt(this->reserve(),head);
+  head->setCar(this->read());
+  Cons_sp cur = head;
+  while (true) {
+    this->need(1);
+    if (*this->_Cur != serialize_cons) {
+      cur->setCdr(this->read());
+      return head;
+    }
+    ++this->_Cur;
+    Cons_sp next = Cons_O::create(_Nil<T_O>(),_Nil<T_O>());
+    this->registerAt(this->reserve(),next);
+    cur->setCdr(next);
+    next->setCar(this->read());
+    cur = next;
+  }
+}
+
+T_sp BinaryDeserializer::readRawVector() {
+  unsigned char kind = this->readByte();
+  size_t len = this->readUnsigned();
+  // Every element takes at least a byte.
+  this->needElements(len,1);
+  AbstractSimpleVector_sp vec;
+  switch (kind) {
+#define SERIALIZE_MAKE_RAW(code,vectorClass) case code: vec = vectorClass::make(len); break;
+    SERIALIZE_RAW_VECTOR_KINDS(SERIALIZE_MAKE_RAW);
+#undef SERIALIZE_MAKE_RAW
+  default:
+      SIMPLE_ERROR(BF("Unknown vector kind %d in serialized object") % (int)kind);
+  }
+  if (len) this->readBytes(vec->rowMajorAddressOfElement_(0),len*vec->elementSizeInBytes());
+  if (gc::IsA<SimpleCharacterString_sp>(vec)) {
+    SimpleCharacterString_sp str = gc::As_unsafe<SimpleCharacterString_sp>(vec);
+    for (size_t i = 0; i < len; ++i) {
+      if ((uint64_t)(*str)[i] >= CHAR_CODE_LIMIT) {
+        SIMPLE_ERROR(BF("Invalid character code %lu in serialized string") % (uint64_t)(*str)[i]);
+      }
+    }
+  }
+  return vec;
+}
+
+T_sp BinaryDeserializer::readComplexVector(size_t index) {
+  unsigned char flags = this->readByte();
+  T_sp elementType = this->read();
+  size_t size = this->readUnsigned();
+  // The contents take at least a bit per element.
+  this->needElements(size/8,1);
+  T_sp fillPointer = _Nil<T_O>();
+  if (flags&1) {
+    size_t fp = this->readUnsigned();
+    if (fp > size) SIMPLE_ERROR(BF("Fill pointer %lu exceeds vector size %lu in serialized object") % fp % size);
+    fillPointer = make_fixnum(fp);
+  }
+  Vector_sp vec = core__make_vector(elementType,size,flags&2,fillPointer);
+  this->registerAt(index,vec);
+  // The contents may refer to the vector itself, so read them after it is registered.
+  T_sp contents = this->read();
+  if (!gc::IsA<AbstractSimpleVector_sp>(contents) || gc::As_unsafe<AbstractSimpleVector_sp>(contents)->length() != size) {
+    SIMPLE_ERROR(BF("Expected the %lu elements of a vector in serialized object but got %s") % size % _rep_(contents));
+  }
+  AbstractSimpleVector_sp data = gc::As_unsafe<AbstractSimpleVector_sp>(contents);
+  for (size_t i = 0; i < size; ++i) vec->rowMajorAset(i,data->rowMajorAref(i));
+  return vec;
+}
+
+T_sp BinaryDeserializer::readHashTable(size_t index) {
+  unsigned char code = this->readByte();
+  T_sp test;
+  switch (code) {
+  case 0: test = cl::_sym_eq; break;
+  case 1: test = cl::_sym_eql; break;
+  case 2: test = cl::_sym_equal; break;
+  case 3: test = cl::_sym_equalp; break;
+  default:
+      SIMPLE_ERROR(BF("Unknown hash table test %d in serialized object") % (int)code);
+  }
+  size_t count = this->readUnsigned();
+  this->needElements(count,2);
+  HashTable_sp table = HashTable_O::create(test);
+  this->registerAt(index,table);
+  // Keys may still be under construction while their entry is read,
+  // so hash them only once every entry has been read.
+  SimpleVector_sp entries = SimpleVector_O::make(count*2);
+  for (size_t i = 0; i < count*2; ++i) (*entries)[i] = this->read();
+  for (size_t i = 0; i < count; ++i) table->setf_gethash((*entries)[2*i],(*entries)[2*i+1]);
+  return table;
+}
+
+T_sp BinaryDeserializer::readInstance(size_t index) {
+  Symbol_sp className = gc::As<Symbol_sp>(this->read());
+  Instance_sp cl = gc::As<Instance_sp>(cl__find_class(className,true,_Nil<T_O>()));
+  size_t numberOfSlots = this->readUnsigned();
+  // The class may have changed since the instance was written, so only
+  // fill in a rack that has the layout the class has now.
+  if (cl->instanceRef(Instance_O::REF_CLASS_FINALIZED).nilp()) {
+    SIMPLE_ERROR(BF("Cannot deserialize an instance of %s: the class is not finalized") % _rep_(className));
+  }
+  if (cl->_Class->_className() == clos::_sym_funcallable_standard_class) {
+    SIMPLE_ERROR(BF("Cannot deserialize an instance of %s: it is funcallable") % _rep_(className));
+  }
+  T_sp size = cl->instanceRef(Instance_O::REF_CLASS_SIZE);
+  if (!size.fixnump() || (size_t)size.unsafe_fixnum() != numberOfSlots) {
+    SIMPLE_ERROR(BF("Cannot deserialize an instance of %s with %lu slots: the class now has %s") % _rep_(className) % numberOfSlots % _rep_(size));
+  }
+  this->needElements(numberOfSlots,1);
+  Instance_sp instance = gc::As_unsafe<Instance_sp>(core__allocate_standard_instance(cl,numberOfSlots));
+  this->registerAt(index,instance);
+  Rack_sp rack = instance->_Rack;
+  for (size_t i = 0; i < numberOfSlots; ++i) rack->low_level_rackSet(i,this->read());
+  return instance;
+}
+
+T_sp BinaryDeserializer::read() {
+  unsigned char tag = this->readByte();
+  switch (tag) {
+  case serialize_nil:
+      return _Nil<T_O>();
+  case serialize_fixnum:
+      return make_fixnum(this->readSigned());
+  case serialize_character: {
+    uint64_t code = this->readUnsigned();
+    if (code >= CHAR_CODE_LIMIT) SIMPLE_ERROR(BF("Invalid character code %lu in serialized object") % code);
+    return clasp_make_character(code);
+  }
+  case serialize_single_float: {
+    float f;
+    this->readBytes(&f,sizeof(f));
+    return clasp_make_single_float(f);
+  }
+  case serialize_double_float: {
+    double d;
+    this->readBytes(&d,sizeof(d));
+    return DoubleFloat_O::create(d);
+  }
+  case serialize_bignum: {
+    int64_t len = this->readSigned();
+    if (len == 0) SIMPLE_ERROR(BF("Zero length bignum in serialized object"));
+    uint64_t size = (len < 0) ? -(uint64_t)len : (uint64_t)len;
+    this->needElements(size,sizeof(mp_limb_t));
+    std::vector<mp_limb_t> limbs(size);
+    this->readBytes(limbs.data(),size*sizeof(mp_limb_t));
+    return Bignum_O::create_from_limbs(len,0,false,size,limbs.data());
+  }
+  case serialize_ratio: {
+    Integer_sp num = gc::As<Integer_sp>(this->read());
+    Integer_sp den = gc::As<Integer_sp>(this->read());
+    return Ratio_O::create_primitive(num,den);
+  }
+  case serialize_complex: {
+    Real_sp real = gc::As<Real_sp>(this->read());
+    Real_sp imag = gc::As<Real_sp>(this->read());
+    return Complex_O::create(real,imag);
+  }
+  case serialize_unbound:
+      return _Unbound<T_O>();
+  case serialize_reference: {
+    size_t index = this->readUnsigned();
+    if (index >= this->_Shared->length()) SIMPLE_ERROR(BF("Invalid reference %lu in serialized object") % index);
+    return this->_Shared->rowMajorAref(index);
+  }
+  case serialize_cons:
+      return this->readCons();
+  case serialize_symbol: {
+    size_t index = this->reserve();
+    SimpleString_sp pkgName = this->readName();
+    SimpleString_sp name = this->readName();
+    T_sp sym = coerce::packageDesignator(pkgName)->intern(name);
+    return this->registerAt(index,sym);
+  }
+  case serialize_uninterned_symbol: {
+    size_t index = this->reserve();
+    return this->registerAt(index,Symbol_O::create(this->readName()));
+  }
+  case serialize_package: {
+    size_t index = this->reserve();
+    return this->registerAt(index,coerce::packageDesignator(this->readName()));
+  }
+  case serialize_raw_vector: {
+    size_t index = this->reserve();
+    return this->registerAt(index,this->readRawVector());
+  }
+  case serialize_bit_vector: {
+    size_t index = this->reserve();
+    size_t len = this->readUnsigned();
+    this->needElements(len/8+(len%8 != 0),1);
+    SimpleBitVector_sp bv = SimpleBitVector_O::make(len);
+    this->registerAt(index,bv);
+    for (size_t i = 0; i < len; i += 8) {
+      unsigned char byte = this->readByte();
+      for (size_t j = 0; j < 8 && i+j < len; ++j) bv->setBit(i+j,(byte>>j)&1);
+    }
+    return bv;
+  }
+  case serialize_simple_vector: {
+    size_t index = this->reserve();
+    size_t len = this->readUnsigned();
+    this->needElements(len,1);
+    SimpleVector_sp sv = SimpleVector_O::make(len);
+    this->registerAt(index,sv);
+    for (size_t i = 0; i < len; ++i) (*sv)[i] = this->read();
+    return sv;
+  }
+  case serialize_hash_table:
+      return this->readHashTable(this->reserve());
+  case serialize_class: {
+    size_t index = this->reserve();
+    Symbol_sp className = gc::As<Symbol_sp>(this->read());
+    return this->registerAt(index,cl__find_class(className,true,_Nil<T_O>()));
+  }
+  case serialize_instance:
+      return this->readInstance(this->reserve());
+  case serialize_complex_vector:
+      return this->readComplexVector(this->reserve());
+  default:
+      SIMPLE_ERROR(BF("Unknown tag %d in serialized object") % (int)tag);
+  }
+}
+
+CL_LAMBDA(object);
+CL_DOCSTRING("Serialize OBJECT into a (simple-array (unsigned-byte 8) (*)) that core:deserialize-from-octets turns back into an equivalent object, preserving sharing and cycles.");
+CL_DEFUN SimpleVector_byte8_t_sp core__serialize_to_octets(T_sp object) {
+  BinarySerializer serializer;
+  serializer.write(object);
+  size_t len = serializer._Buffer.size();
+  return SimpleVector_byte8_t_O::make(len,0,false,len,serializer._Buffer.data());
+}
+
+SYMBOL_EXPORT_SC_(CorePkg, deserialize_from_octets);
+CL_LAMBDA(octets &optional (start 0) end);
+CL_DOCSTRING("Read an object written by core:serialize-to-octets from OCTETS between START and END. Return the object and the index after it.");
+CL_DEFUN T_mv core__deserialize_from_octets(SimpleVector_byte8_t_sp octets, size_t start, T_sp end) {
+  size_t_pair p = sequenceStartEnd(core::_sym_deserialize_from_octets, octets->length(), start, end);
+  const unsigned char* data = (const unsigned char*)octets->rowMajorAddressOfElement_(0);
+  BinaryDeserializer deserializer(data+p.start,data+p.end);
+  T_sp object = deserializer.read();
+  return Values(object,make_fixnum(deserializer._Cur-data));
+}
+
 };
@@ -1,10 +1,14 @@
 #include <string.h>
+#include <algorithm>
+#include <bitset>
+#include <vector>
 #include <clasp/core/foundation.h>
 #include <clasp/core/corePackage.h>
 #include <clasp/core/bformat.h>
 #include <clasp/core/designators.h>
 #include <clasp/core/array.h>
 #include <clasp/core/character.h>
+#include <clasp/core/stringKernels.h>
 #include <clasp/core/ql.h>
 
 // ----------------------------------------------------------------------
@@ -29,45 +33,62 @@ namespace core {
         ss << "\"";
         return ss.str();
     };
-static bool member_charbag(claspCharacter c, SEQUENCE_sp char_bag) {
-  if (char_bag.nilp())
-    return false;
-  if (Cons_sp clcur = char_bag.asOrNull<Cons_O>()) {
-    List_sp lcur = clcur;
-    for (; lcur.notnilp(); lcur = oCdr(lcur)) {
-      if (cl__eql(oCar(lcur), clasp_make_character(c)))
-        return true;
-    }
-  } else if (Vector_sp vcur = char_bag.asOrNull<Vector_O>()) {
-    for (size_t i = 0, iEnd(vcur->length()); i < iEnd; ++i) {
-      if (cl__eql(vcur->rowMajorAref(i),clasp_make_character(c)))
-        return true;
+/*! The characters of a char-bag collected once so that trimming
+    doesn't call cl__eql for every character of the string. */
+struct CharBag {
+  std::bitset<256> _Base;
+  std::vector<claspCharacter> _Wide;
+  void add(T_sp tc) {
+    if (!tc.characterp()) return;
+    claspCharacter c = tc.unsafe_character();
+    if (c<256) this->_Base.set(c);
+    else this->_Wide.push_back(c);
+  }
+  CharBag(T_sp char_bag) {
+    if (char_bag.nilp()) return;
+    if (Cons_sp clcur = char_bag.asOrNull<Cons_O>()) {
+      List_sp lcur = clcur;
+      for (; lcur.notnilp(); lcur = oCdr(lcur)) this->add(oCar(lcur));
+    } else if (Vector_sp vcur = char_bag.asOrNull<Vector_O>()) {
+      for (size_t i = 0, iEnd(vcur->length()); i < iEnd; ++i) this->add(vcur->rowMajorAref(i));
     }
   }
-  return false;
-}
+  inline bool contains(claspCharacter c) const {
+    if (c<256) return this->_Base.test(c);
+    return std::find(this->_Wide.begin(),this->_Wide.end(),c) != this->_Wide.end();
+  }
+};
 
-static String_sp string_trim0(bool left_trim, bool right_trim, T_sp char_bag, T_sp tstrng) {
-  cl_index i, j;
-  String_sp strng = coerce::stringDesignator(tstrng);
-  i = 0;
-  j = cl__length(strng);
+template <typename CharType>
+static void template_string_trim(const CharType* data, const CharBag& bag, bool left_trim, bool right_trim, size_t& i, size_t& j) {
   if (left_trim) {
     for (; i < j; i++) {
-      claspCharacter c = cl__char(strng,i).unsafe_character();
-      if (!member_charbag(c, char_bag))
+      if (!bag.contains(static_cast<claspCharacter>(data[i])))
         break;
     }
   }
   if (right_trim) {
     for (; j > i; j--) {
-      claspCharacter c = cl__char(strng,j - 1).unsafe_character();
-      if (!member_charbag(c, char_bag)) {
+      if (!bag.contains(static_cast<claspCharacter>(data[j-1])))
         break;
-      }
     }
   }
-  return strng->unsafe_subseq(i, j);
+}
+
+static String_sp string_trim0(bool left_trim, bool right_trim, T_sp char_bag, T_sp tstrng) {
+  String_sp strng = coerce::stringDesignator(tstrng);
+  CharBag bag(char_bag);
+  AbstractSimpleVector_sp bsv;
+  size_t start, end;
+  strng->asAbstractSimpleVectorRange(bsv,start,end);
+  size_t i = start;
+  size_t j = end;
+  if (gc::IsA<SimpleBaseString_sp>(bsv)) {
+    template_string_trim((const claspChar*)bsv->rowMajorAddressOfElement_(0),bag,left_trim,right_trim,i,j);
+  } else {
+    template_string_trim((const claspCharacter*)bsv->rowMajorAddressOfElement_(0),bag,left_trim,right_trim,i,j);
+  }
+  return strng->unsafe_subseq(i-start, j-start);
 }
 
 CL_LAMBDA(charbag str);
@@ -99,20 +120,43 @@ CL_DEFUN String_sp cl__string(T_sp arg) {
   return (result);
 };
 
+/*! Upcase or downcase the characters [start,end) of the simple string src into dest
+    starting at dest_start - src and dest must have the same element type and may be the same */
+static void simple_string_change_case(AbstractSimpleVector_sp src, size_t start, size_t end, AbstractSimpleVector_sp dest, size_t dest_start, bool upcase) {
+  if (gc::IsA<SimpleBaseString_sp>(src)) {
+    string_kernels::change_case((const claspChar*)src->rowMajorAddressOfElement_(start),
+                                (claspChar*)dest->rowMajorAddressOfElement_(dest_start),
+                                end-start, upcase);
+  } else {
+    string_kernels::change_case((const claspCharacter*)src->rowMajorAddressOfElement_(start),
+                                (claspCharacter*)dest->rowMajorAddressOfElement_(dest_start),
+                                end-start, upcase);
+  }
+}
+
+static SimpleString_sp string_change_case(T_sp arg, bool upcase) {
+  String_sp str = coerce::stringDesignator(arg);
+  SimpleString_sp result = gc::As_unsafe<SimpleString_sp>(core__make_vector(str->element_type(),str->length(),false));
+  AbstractSimpleVector_sp bsv;
+  size_t start, end;
+  str->asAbstractSimpleVectorRange(bsv,start,end);
+  simple_string_change_case(bsv,start,end,result,0,upcase);
+  return result;
+}
+
+static String_sp nstring_change_case(String_sp arg, bool upcase) {
+  AbstractSimpleVector_sp bsv;
+  size_t start, end;
+  arg->asAbstractSimpleVectorRange(bsv,start,end);
+  simple_string_change_case(bsv,start,end,bsv,start,upcase);
+  return arg;
+}
+
 CL_LAMBDA(arg);
 CL_DECLARE();
 CL_DOCSTRING("string_upcase");
 CL_DEFUN SimpleString_sp cl__string_upcase(T_sp arg) {
-  String_sp str = coerce::stringDesignator(arg);
-  SimpleString_sp result = gc::As_unsafe<SimpleString_sp>(core__make_vector(str->element_type(),str->length(),false));
-  for ( size_t i(0), iEnd(str->length()); i<iEnd; ++i ) {
-    T_sp cc = str->rowMajorAref(i);
-    claspCharacter c = cc.unsafe_character();
-    claspCharacter u = claspCharacter_upcase(c);
-    Character_sp cu = clasp_make_character(u);
-    result->rowMajorAset(i,clasp_make_character(u));
-  }
-  return (result);
+  return string_change_case(arg,true);
 };
 
 
@@ -120,14 +164,7 @@ CL_LAMBDA(arg);
 CL_DECLARE();
 CL_DOCSTRING("string_downcase");
 CL_DEFUN SimpleString_sp cl__string_downcase(T_sp arg) {
-  String_sp str = coerce::stringDesignator(arg);
-  SimpleString_sp result = gc::As_unsafe<SimpleString_sp>(core__make_vector(str->element_type(),str->length(),false));
-  for ( size_t i(0), iEnd(str->length()); i<iEnd; ++i ) {
-    claspCharacter c = str->rowMajorAref(i).unsafe_character();
-    claspCharacter u = claspCharacter_downcase(c);
-    result->rowMajorAset(i,clasp_make_character(u));
-  }
-  return (result);
+  return string_change_case(arg,false);
 };
 
 
@@ -135,20 +172,14 @@ CL_LAMBDA(arg);
 CL_DECLARE();
 CL_DOCSTRING("nstring_upcase");
 CL_DEFUN String_sp cl__nstring_upcase(String_sp arg) {
-  for ( cl_index i(0), iEnd(arg->length()); i<iEnd; ++i ) {
-    arg->rowMajorAset(i,clasp_make_character(claspCharacter_upcase(arg->rowMajorAref(i).unsafe_character())));
-  }
-  return arg;
+  return nstring_change_case(arg,true);
 };
 
 CL_LAMBDA(arg);
 CL_DECLARE();
 CL_DOCSTRING("nstring_downcase");
 CL_DEFUN String_sp cl__nstring_downcase(String_sp arg) {
-  for ( cl_index i(0), iEnd(arg->length()); i<iEnd; ++i ) {
-    arg->rowMajorAset(i,clasp_make_character(claspCharacter_downcase(arg->rowMajorAref(i).unsafe_character())));
-  }
-  return arg;
+  return nstring_change_case(arg,false);
 };
 
 
@@ -196,31 +227,11 @@ StringCharPointer& operator++() {
 
 template <typename T1, typename T2>
 bool template_string_equalp_bool(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2) {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
   size_t num1 = end1 - start1;
-  size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((toupper(static_cast<claspCharacter>(*cp1)) != toupper(static_cast<claspCharacter>(*cp2))))
-      goto RETURN_FALSE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 == 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2:
- RETURN_FALSE:
-  return false;
- RETURN_TRUE:
-  return true;
+  if (num1 != (end2 - start2)) return false;
+  const typename T1::simple_element_type* cp1 = (const typename T1::simple_element_type*)string1.rowMajorAddressOfElement_(start1);
+  const typename T2::simple_element_type* cp2 = (const typename T2::simple_element_type*)string2.rowMajorAddressOfElement_(start2);
+  return string_kernels::equal_ci(cp1,cp2,num1);
 }
 
 
@@ -230,31 +241,9 @@ bool template_string_equalp_bool(const T1& string1, const T2& string2, size_t st
 template <typename T1,typename T2>
 T_sp template_string_EQ_(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2)
 {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
-  size_t num1 = end1 - start1;
-  size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((static_cast<claspCharacter>(*cp1) != static_cast<claspCharacter>(*cp2)))
-      goto RETURN_FALSE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 == 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2:
- RETURN_FALSE:
+  if (template_string_EQ_equal(string1,string2,start1,end1,start2,end2))
+    return _lisp->_true();
   return _Nil<T_O>();
- RETURN_TRUE:
-  return _lisp->_true();
 }
 
 /*! bounding index designator range from 0 to the end of each string */
@@ -423,31 +412,9 @@ T_sp template_string_GE_(const T1& string1, const T2& string2, size_t start1, si
 /*! bounding index designator range from 0 to the end of each string */
 template <typename T1, typename T2>
 T_sp template_string_equal(const T1& string1, const T2& string2, size_t start1, size_t end1, size_t start2, size_t end2) {
-  StringCharPointer<T1> cp1(&string1,start1);
-  StringCharPointer<T2> cp2(&string2,start2);
-  size_t num1 = end1 - start1;
-  size_t num2 = end2 - start2;
-  while (1) {
-    if (num1 == 0)
-      goto END_STRING1;
-    if (num2 == 0)
-      goto END_STRING2;
-    if ((toupper(static_cast<claspCharacter>(*cp1)) != toupper(static_cast<claspCharacter>(*cp2))))
-      goto RETURN_FALSE;
-    --num1;
-    --num2;
-    ++cp1;
-    ++cp2;
-  }
- END_STRING1:
-  if (num2 == 0)
-    goto RETURN_TRUE;
-  goto RETURN_FALSE;
- END_STRING2:
- RETURN_FALSE:
+  if (template_string_equalp_bool(string1,string2,start1,end1,start2,end2))
+    return _lisp->_true();
   return _Nil<T_O>();
- RETURN_TRUE:
-  return _lisp->_true();
 }
 
 /*! bounding index designator range from 0 to the end of each string */
@@ -1446,17 +1413,12 @@ CL_DEFUN T_sp core__base_string_concatenate(VaList_sp vargs) {
 template <typename T1,typename T2>
 T_sp template_search_string(const T1& sub, const T2& outer, size_t sub_start, size_t sub_end, size_t outer_start, size_t outer_end)
 {
-  // The std::search convention is reversed -->  std::search(outer,sub,...)
-  const typename T2::simple_element_type* startp = (const typename T2::simple_element_type*)outer.rowMajorAddressOfElement_(0); // &outer[0];
   const typename T2::simple_element_type* cps = (const typename T2::simple_element_type*)outer.rowMajorAddressOfElement_(outer_start); //&outer[outer_start];
-  const typename T2::simple_element_type* cpe = (const typename T2::simple_element_type*)outer.rowMajorAddressOfElement_(outer_end);
   const typename T1::simple_element_type* s_cps = (const typename T1::simple_element_type*)sub.rowMajorAddressOfElement_(sub_start); //&sub[sub_start];
-  const typename T1::simple_element_type* s_cpe = (const typename T1::simple_element_type*)sub.rowMajorAddressOfElement_(sub_end);
-  const typename T2::simple_element_type* pos = std::search(cps,cpe,s_cps,s_cpe);
-  if (pos == cpe ) return _Nil<T_O>();
+  size_t pos = string_kernels::search(s_cps,sub_end-sub_start,cps,outer_end-outer_start);
+  if (pos == string_kernels::npos) return _Nil<T_O>();
   // this should return the absolute position starting from 0, not relative to outer_start
-  //now that I understood this in pointer arithmethic, compare to the beginning of the string, e.g. index 0
-  return clasp_make_fixnum(pos-startp);
+  return clasp_make_fixnum(pos+outer_start);
 }
 
 SYMBOL_EXPORT_SC_(CorePkg,search_string);
@@ -1467,6 +1429,29 @@ CL_DEFUN T_sp core__search_string(String_sp sub, size_t sub_start, size_t sub_en
 };
 
 
+SYMBOL_EXPORT_SC_(CorePkg,position_character);
+CL_LAMBDA(item str start end from-end);
+CL_DOCSTRING("Return the index of the first (or last if from-end) occurance of the character item in str between start and end or nil");
+CL_DEFUN T_sp core__position_character(Character_sp item, String_sp str, size_t start, size_t end, T_sp from_end) {
+  AbstractSimpleVector_sp bsv;
+  size_t bstart, bend;
+  str->asAbstractSimpleVectorRange(bsv,bstart,bend);
+  if (end > bend-bstart || start > end) {
+    SIMPLE_ERROR(BF("Illegal range start %lu end %lu for string %s") % start % end % _rep_(str));
+  }
+  claspCharacter c = item.unsafe_character();
+  size_t pos;
+  if (gc::IsA<SimpleBaseString_sp>(bsv)) {
+    const claspChar* data = (const claspChar*)bsv->rowMajorAddressOfElement_(bstart+start);
+    pos = from_end.notnilp() ? string_kernels::rfind_char(data,end-start,c) : string_kernels::find_char(data,end-start,c);
+  } else {
+    const claspCharacter* data = (const claspCharacter*)bsv->rowMajorAddressOfElement_(bstart+start);
+    pos = from_end.notnilp() ? string_kernels::rfind_char(data,end-start,c) : string_kernels::find_char(data,end-start,c);
+  }
+  if (pos == string_kernels::npos) return _Nil<T_O>();
+  return clasp_make_fixnum(pos+start);
+}
+
 CL_LISPIFY_NAME("core:split");
 CL_DEFUN List_sp core__split(const string& all, const string &chars) {
   vector<string> parts = split(all, chars);
@@ -473,6 +473,20 @@ CL_DEFUN void core__setf_symbolFunction(Function_sp exec, Symbol_sp symbol){
   symbol->setf_symbolFunction(exec);
 }
 
+CL_LAMBDA(cmp new-function symbol);
+CL_DECLARE();
+CL_DOCSTRING("Compare-and-swap of the global function of SYMBOL.");
+CL_DEFUN Function_sp core__cas_symbol_function(Function_sp cmp, Function_sp new_function, Symbol_sp symbol) {
+  return symbol->casSymbolFunction(cmp, new_function);
+}
+
+CL_LAMBDA(cmp new-function symbol);
+CL_DECLARE();
+CL_DOCSTRING("Compare-and-swap of the global function named (SETF SYMBOL).");
+CL_DEFUN Function_sp core__cas_setf_fdefinition(Function_sp cmp, Function_sp new_function, Symbol_sp symbol) {
+  return symbol->casSetfFdefinition(cmp, new_function);
+}
+
 string Symbol_O::symbolNameAsString() const {
   return this->_Name->get_std_string();
 }
@@ -0,0 +1,400 @@
+/*
+    File: vectorKernels.cc
+*/
+
+/*
+Copyright (c) 2014, Christian E. Schafmeister
+
+CLASP is free software; you can redistribute it and/or
+modify it under the terms of the GNU Library General Public
+License as published by the Free Software Foundation; either
+version 2 of the License, or (at your option) any later version.
+
+See directory 'clasp/licenses' for full details.
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+/* -^- */
+
+// Bulk operations on vectors specialized on numeric element types.
+// The loops work directly on the storage of the underlying simple vector
+// and are written so that the C++ compiler can vectorize them.
+// Element-wise arithmetic is only provided for float vectors - integer
+// vectors would need overflow checks on every element.
+
+#include <clasp/core/foundation.h>
+#include <clasp/core/common.h>
+#include <clasp/core/symbolTable.h>
+#include <clasp/core/numbers.h>
+#include <clasp/core/array.h>
+#include <clasp/core/sequence.h>
+#include <clasp/core/wrappers.h>
+
+namespace core {
+
+struct VectorRange {
+  AbstractSimpleVector_sp _Vector;
+  size_t _Start;
+  size_t _End;
+  VectorRange(Vector_sp vec) { vec->asAbstractSimpleVectorRange(this->_Vector,this->_Start,this->_End); };
+  VectorRange(Symbol_sp fname, Vector_sp vec, size_t start, T_sp end) {
+    size_t_pair p = sequenceStartEnd(fname,vec->length(),start,end);
+    vec->asAbstractSimpleVectorRange(this->_Vector,this->_Start,this->_End);
+    this->_End = this->_Start+p.end;
+    this->_Start += p.start;
+  };
+  size_t length() const { return this->_End-this->_Start; };
+  template <typename SimpleVectorType>
+  bool isA() const { return gc::IsA<gctools::smart_ptr<SimpleVectorType>>(this->_Vector); };
+  template <typename SimpleVectorType>
+  typename SimpleVectorType::value_type* data() const {
+    return (typename SimpleVectorType::value_type*)this->_Vector->rowMajorAddressOfElement_(this->_Start);
+  }
+};
+
+// Call fn<SimpleVectorType>(args...) for the simple vector type of range.
+#define DISPATCH_FLOAT_VECTOR(range,fn,...) \
+  if ((range).isA<SimpleVector_double_O>()) return fn<SimpleVector_double_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_float_O>()) return fn<SimpleVector_float_O>(__VA_ARGS__);
+
+#define DISPATCH_INTEGER_VECTOR(range,fn,...) \
+  if ((range).isA<SimpleVector_fixnum_O>()) return fn<SimpleVector_fixnum_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_byte8_t_O>()) return fn<SimpleVector_byte8_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_int8_t_O>()) return fn<SimpleVector_int8_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_byte16_t_O>()) return fn<SimpleVector_byte16_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_int16_t_O>()) return fn<SimpleVector_int16_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_byte32_t_O>()) return fn<SimpleVector_byte32_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_int32_t_O>()) return fn<SimpleVector_int32_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_byte64_t_O>()) return fn<SimpleVector_byte64_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_int64_t_O>()) return fn<SimpleVector_int64_t_O>(__VA_ARGS__); \
+  if ((range).isA<SimpleVector_size_t_O>()) return fn<SimpleVector_size_t_O>(__VA_ARGS__);
+
+[[noreturn]] static void vectorKernelTypeError(Symbol_sp fname, Vector_sp vec) {
+  SIMPLE_ERROR(BF("%s does not support vectors of element-type %s") % _rep_(fname) % _rep_(vec->element_type()));
+}
+
+static void vectorKernelCheckSame(Symbol_sp fname, const VectorRange& a, Vector_sp va, const VectorRange& b, Vector_sp vb) {
+  if (a._Vector->__class() != b._Vector->__class()) {
+    SIMPLE_ERROR(BF("%s requires vectors of the same element-type but got %s and %s") % _rep_(fname) % _rep_(va->element_type()) % _rep_(vb->element_type()));
+  }
+  if (a.length() != b.length()) {
+    SIMPLE_ERROR(BF("%s requires vectors of the same length but got %d and %d") % _rep_(fname) % a.length() % b.length());
+  }
+}
+
+// ------------------------------------------------------------
+//
+// Element-wise arithmetic
+//
+
+enum VectorArithmeticOp { vector_add, vector_subtract, vector_multiply };
+
+template <typename SimpleVectorType>
+void template_vector_arithmetic(VectorArithmeticOp op, const VectorRange& result, const VectorRange& a, const VectorRange& b) {
+  typedef typename SimpleVectorType::value_type value_type;
+  // The operands may alias the result, so no __restrict__ here - the
+  // compiler emits a runtime overlap check and still vectorizes.
+  value_type* r = result.data<SimpleVectorType>();
+  const value_type* x = a.data<SimpleVectorType>();
+  const value_type* y = b.data<SimpleVectorType>();
+  size_t n = result.length();
+  switch (op) {
+  case vector_add: for (size_t i=0; i<n; ++i) r[i] = x[i]+y[i]; break;
+  case vector_subtract: for (size_t i=0; i<n; ++i) r[i] = x[i]-y[i]; break;
+  case vector_multiply: for (size_t i=0; i<n; ++i) r[i] = x[i]*y[i]; break;
+  }
+}
+
+template <typename SimpleVectorType>
+void template_vector_scale(const VectorRange& result, const VectorRange& a, T_sp scalar) {
+  typedef typename SimpleVectorType::value_type value_type;
+  value_type s = SimpleVectorType::from_object(scalar);
+  value_type* r = result.data<SimpleVectorType>();
+  const value_type* x = a.data<SimpleVectorType>();
+  size_t n = result.length();
+  for (size_t i=0; i<n; ++i) r[i] = x[i]*s;
+}
+
+static void vector_arithmetic(Symbol_sp fname, VectorArithmeticOp op, Vector_sp result, Vector_sp a, Vector_sp b) {
+  VectorRange rr(result), ra(a), rb(b);
+  vectorKernelCheckSame(fname,rr,result,ra,a);
+  vectorKernelCheckSame(fname,rr,result,rb,b);
+  DISPATCH_FLOAT_VECTOR(rr,template_vector_arithmetic,op,rr,ra,rb);
+  vectorKernelTypeError(fname,result);
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_add);
+CL_LAMBDA(result a b);
+CL_DOCSTRING("Store the element-wise sum of the float vectors A and B into RESULT and return RESULT. All three vectors must have the same element-type (single-float or double-float) and length. RESULT may be A or B.");
+CL_DEFUN Vector_sp ext__vector_add(Vector_sp result, Vector_sp a, Vector_sp b) {
+  vector_arithmetic(ext::_sym_vector_add,vector_add,result,a,b);
+  return result;
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_subtract);
+CL_LAMBDA(result a b);
+CL_DOCSTRING("Store the element-wise difference A - B of the float vectors A and B into RESULT and return RESULT. All three vectors must have the same element-type (single-float or double-float) and length. RESULT may be A or B.");
+CL_DEFUN Vector_sp ext__vector_subtract(Vector_sp result, Vector_sp a, Vector_sp b) {
+  vector_arithmetic(ext::_sym_vector_subtract,vector_subtract,result,a,b);
+  return result;
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_multiply);
+CL_LAMBDA(result a b);
+CL_DOCSTRING("Store the element-wise product of the float vectors A and B into RESULT and return RESULT. All three vectors must have the same element-type (single-float or double-float) and length. RESULT may be A or B.");
+CL_DEFUN Vector_sp ext__vector_multiply(Vector_sp result, Vector_sp a, Vector_sp b) {
+  vector_arithmetic(ext::_sym_vector_multiply,vector_multiply,result,a,b);
+  return result;
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_scale);
+CL_LAMBDA(result a scalar);
+CL_DOCSTRING("Store the elements of the float vector A multiplied by SCALAR into RESULT and return RESULT. Both vectors must have the same element-type (single-float or double-float) and length and SCALAR must be of that element-type. RESULT may be A.");
+CL_DEFUN Vector_sp ext__vector_scale(Vector_sp result, Vector_sp a, T_sp scalar) {
+  VectorRange rr(result), ra(a);
+  vectorKernelCheckSame(ext::_sym_vector_scale,rr,result,ra,a);
+  if (rr.isA<SimpleVector_double_O>()) {
+    template_vector_scale<SimpleVector_double_O>(rr,ra,scalar);
+    return result;
+  }
+  if (rr.isA<SimpleVector_float_O>()) {
+    template_vector_scale<SimpleVector_float_O>(rr,ra,scalar);
+    return result;
+  }
+  vectorKernelTypeError(ext::_sym_vector_scale,result);
+}
+
+// ------------------------------------------------------------
+//
+// Reductions
+//
+// Float reductions use several independent accumulators so that the
+// loop vectorizes - the result can differ in the last bits from a
+// strict left to right summation.
+
+#define VECTOR_KERNEL_LANES 8
+
+template <typename SimpleVectorType>
+T_sp template_vector_dot(const VectorRange& a, const VectorRange& b) {
+  typedef typename SimpleVectorType::value_type value_type;
+  const value_type* __restrict__ x = a.data<SimpleVectorType>();
+  const value_type* __restrict__ y = b.data<SimpleVectorType>();
+  size_t n = a.length();
+  value_type acc[VECTOR_KERNEL_LANES] = {0};
+  size_t i = 0;
+  for (; i+VECTOR_KERNEL_LANES<=n; i+=VECTOR_KERNEL_LANES) {
+    for (size_t l=0; l<VECTOR_KERNEL_LANES; ++l) acc[l] += x[i+l]*y[i+l];
+  }
+  value_type sum = 0;
+  for (size_t l=0; l<VECTOR_KERNEL_LANES; ++l) sum += acc[l];
+  for (; i<n; ++i) sum += x[i]*y[i];
+  return SimpleVectorType::to_object(sum);
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_dot);
+CL_LAMBDA(a b);
+CL_DOCSTRING("Return the dot product of the float vectors A and B, which must have the same element-type (single-float or double-float) and length.");
+CL_DEFUN T_sp ext__vector_dot(Vector_sp a, Vector_sp b) {
+  VectorRange ra(a), rb(b);
+  vectorKernelCheckSame(ext::_sym_vector_dot,ra,a,rb,b);
+  DISPATCH_FLOAT_VECTOR(ra,template_vector_dot,ra,rb);
+  vectorKernelTypeError(ext::_sym_vector_dot,a);
+}
+
+template <typename SimpleVectorType>
+T_sp template_vector_sum_float(const VectorRange& range) {
+  typedef typename SimpleVectorType::value_type value_type;
+  const value_type* __restrict__ x = range.data<SimpleVectorType>();
+  size_t n = range.length();
+  value_type acc[VECTOR_KERNEL_LANES] = {0};
+  size_t i = 0;
+  for (; i+VECTOR_KERNEL_LANES<=n; i+=VECTOR_KERNEL_LANES) {
+    for (size_t l=0; l<VECTOR_KERNEL_LANES; ++l) acc[l] += x[i+l];
+  }
+  value_type sum = 0;
+  for (size_t l=0; l<VECTOR_KERNEL_LANES; ++l) sum += acc[l];
+  for (; i<n; ++i) sum += x[i];
+  return SimpleVectorType::to_object(sum);
+}
+
+static Integer_sp integer_from_int128(__int128 value) {
+  if (value >= INT64_MIN && value <= INT64_MAX) return Integer_O::create((int64_t)value);
+  bool negative = value < 0;
+  unsigned __int128 magnitude = negative ? -(unsigned __int128)value : (unsigned __int128)value;
+  Integer_sp high = clasp_ash(Integer_O::create((uint64_t)(magnitude >> 64)),64);
+  Integer_sp result = gc::As<Integer_sp>(contagion_add(high,Integer_O::create((uint64_t)magnitude)));
+  return negative ? gc::As<Integer_sp>(clasp_negate(result)) : result;
+}
+
+// Integer sums are exact. Elements of up to 32 bits are summed in blocks
+// into an int64_t, which vectorizes and can't overflow within a block.
+// 64 bit elements go straight into a 128 bit accumulator - a vector can't
+// have enough elements to overflow that.
+template <typename SimpleVectorType>
+T_sp template_vector_sum_integer(const VectorRange& range) {
+  typedef typename SimpleVectorType::value_type value_type;
+  const value_type* __restrict__ x = range.data<SimpleVectorType>();
+  size_t n = range.length();
+  __int128 total = 0;
+  if (sizeof(value_type) <= 4) {
+    const size_t block = 65536;
+    for (size_t start=0; start<n; start+=block) {
+      size_t end = std::min(n,start+block);
+      int64_t acc = 0;
+      for (size_t i=start; i<end; ++i) acc += x[i];
+      total += acc;
+    }
+  } else {
+    for (size_t i=0; i<n; ++i) total += x[i];
+  }
+  return integer_from_int128(total);
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_sum);
+CL_LAMBDA(vector &optional (start 0) end);
+CL_DOCSTRING("Return the sum of the elements of VECTOR between START and END. VECTOR must be specialized on fixnum, (un)signed-byte 8/16/32/64 or single/double-float. Integer sums are exact.");
+CL_DEFUN T_sp ext__vector_sum(Vector_sp vector, size_t start, T_sp end) {
+  VectorRange range(ext::_sym_vector_sum,vector,start,end);
+  DISPATCH_INTEGER_VECTOR(range,template_vector_sum_integer,range);
+  DISPATCH_FLOAT_VECTOR(range,template_vector_sum_float,range);
+  vectorKernelTypeError(ext::_sym_vector_sum,vector);
+}
+
+// NaNs are skipped unless every element is a NaN.
+template <typename SimpleVectorType>
+T_sp template_vector_extremum(const VectorRange& range, bool maximum) {
+  typedef typename SimpleVectorType::value_type value_type;
+  const value_type* __restrict__ x = range.data<SimpleVectorType>();
+  size_t n = range.length();
+  value_type best = x[0];
+  if (maximum) {
+    for (size_t i=1; i<n; ++i) best = (x[i] > best || best != best) ? x[i] : best;
+  } else {
+    for (size_t i=1; i<n; ++i) best = (x[i] < best || best != best) ? x[i] : best;
+  }
+  return SimpleVectorType::to_object(best);
+}
+
+T_sp vector_extremum(Symbol_sp fname, Vector_sp vector, size_t start, T_sp end, bool maximum) {
+  VectorRange range(fname,vector,start,end);
+  if (range.length() == 0) {
+    SIMPLE_ERROR(BF("%s requires a non-empty range of elements") % _rep_(fname));
+  }
+  DISPATCH_INTEGER_VECTOR(range,template_vector_extremum,range,maximum);
+  DISPATCH_FLOAT_VECTOR(range,template_vector_extremum,range,maximum);
+  vectorKernelTypeError(fname,vector);
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_min);
+CL_LAMBDA(vector &optional (start 0) end);
+CL_DOCSTRING("Return the smallest element of VECTOR between START and END, which must not be empty. VECTOR must be specialized on fixnum, (un)signed-byte 8/16/32/64 or single/double-float.");
+CL_DEFUN T_sp ext__vector_min(Vector_sp vector, size_t start, T_sp end) {
+  return vector_extremum(ext::_sym_vector_min,vector,start,end,false);
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_max);
+CL_LAMBDA(vector &optional (start 0) end);
+CL_DOCSTRING("Return the largest element of VECTOR between START and END, which must not be empty. VECTOR must be specialized on fixnum, (un)signed-byte 8/16/32/64 or single/double-float.");
+CL_DEFUN T_sp ext__vector_max(Vector_sp vector, size_t start, T_sp end) {
+  return vector_extremum(ext::_sym_vector_max,vector,start,end,true);
+}
+
+// Used by REDUCE - only exact reductions are done natively, so the
+// result is the same as the left to right fold.
+template <typename SimpleVectorType>
+T_mv template_native_reduce(Symbol_sp op, const VectorRange& range) {
+  if (op == cl::_sym__PLUS_) return Values(template_vector_sum_integer<SimpleVectorType>(range),_lisp->_true());
+  return Values(template_vector_extremum<SimpleVectorType>(range,op == cl::_sym_max),_lisp->_true());
+}
+
+SYMBOL_EXPORT_SC_(CorePkg,reduce_integer_vector);
+CL_LAMBDA(op vector start end);
+CL_DOCSTRING("Reduce the non-empty range START to END of an integer VECTOR with OP, one of the symbols +, min or max. Return the result and T, or NIL and NIL if VECTOR is not specialized on an integer type.");
+CL_DEFUN T_mv core__reduce_integer_vector(Symbol_sp op, Vector_sp vector, size_t start, T_sp end) {
+  if (!(op == cl::_sym__PLUS_ || op == cl::_sym_min || op == cl::_sym_max)) {
+    SIMPLE_ERROR(BF("%s is not a valid operator for reduce-integer-vector - use one of + min max") % _rep_(op));
+  }
+  VectorRange range(core::_sym_reduce_integer_vector,vector,start,end);
+  if (range.length() == 0) return Values(_Nil<T_O>(),_Nil<T_O>());
+  DISPATCH_INTEGER_VECTOR(range,template_native_reduce,op,range);
+  return Values(_Nil<T_O>(),_Nil<T_O>());
+}
+
+// ------------------------------------------------------------
+//
+// Comparisons
+//
+
+enum VectorCompareOp { compare_lt, compare_le, compare_gt, compare_ge, compare_eq, compare_ne };
+
+template <typename value_type>
+void template_vector_compare_into(VectorCompareOp op, const value_type* x, const value_type* y, size_t ystride, unsigned char* flags, size_t n) {
+  switch (op) {
+  case compare_lt: for (size_t i=0; i<n; ++i) flags[i] = x[i] < y[i*ystride]; break;
+  case compare_le: for (size_t i=0; i<n; ++i) flags[i] = x[i] <= y[i*ystride]; break;
+  case compare_gt: for (size_t i=0; i<n; ++i) flags[i] = x[i] > y[i*ystride]; break;
+  case compare_ge: for (size_t i=0; i<n; ++i) flags[i] = x[i] >= y[i*ystride]; break;
+  case compare_eq: for (size_t i=0; i<n; ++i) flags[i] = x[i] == y[i*ystride]; break;
+  case compare_ne: for (size_t i=0; i<n; ++i) flags[i] = x[i] != y[i*ystride]; break;
+  }
+}
+
+template <typename SimpleVectorType>
+SimpleBitVector_sp template_vector_compare(VectorCompareOp op, const VectorRange& a, T_sp b) {
+  typedef typename SimpleVectorType::value_type value_type;
+  size_t n = a.length();
+  const value_type* x = a.data<SimpleVectorType>();
+  value_type scalar;
+  const value_type* y;
+  size_t ystride;
+  if (gc::IsA<Vector_sp>(b)) {
+    y = VectorRange(gc::As_unsafe<Vector_sp>(b)).data<SimpleVectorType>();
+    ystride = 1;
+  } else {
+    scalar = SimpleVectorType::from_object(b);
+    y = &scalar;
+    ystride = 0;
+  }
+  SimpleBitVector_sp result = SimpleBitVector_O::make(n);
+  // Compare in chunks into a byte buffer - that loop vectorizes - and then pack the bits.
+  unsigned char flags[256];
+  for (size_t start=0; start<n; start+=sizeof(flags)) {
+    size_t chunk = std::min(n-start,sizeof(flags));
+    template_vector_compare_into<value_type>(op,x+start,y+start*ystride,ystride,flags,chunk);
+    for (size_t i=0; i<chunk; ++i) if (flags[i]) (*result)[start+i] = 1;
+  }
+  return result;
+}
+
+SYMBOL_EXPORT_SC_(ExtPkg,vector_compare);
+CL_LAMBDA(op a b);
+CL_DOCSTRING("Compare the elements of the numeric vector A with the elements of B using OP, one of the symbols <, <=, >, >=, = or /=, and return a simple-bit-vector with a 1 wherever the comparison is true. B is either a vector of the same element-type and length as A or a scalar of that element-type.");
+CL_DEFUN SimpleBitVector_sp ext__vector_compare(Symbol_sp op, Vector_sp a, T_sp b) {
+  VectorCompareOp cop;
+  if (op == cl::_sym__LT_) cop = compare_lt;
+  else if (op == cl::_sym__LE_) cop = compare_le;
+  else if (op == cl::_sym__GT_) cop = compare_gt;
+  else if (op == cl::_sym__GE_) cop = compare_ge;
+  else if (op == cl::_sym__EQ_) cop = compare_eq;
+  else if (op == cl::_sym__NE_) cop = compare_ne;
+  else SIMPLE_ERROR(BF("%s is not a valid comparison for vector-compare - use one of < <= > >= = /=") % _rep_(op));
+  VectorRange ra(a);
+  if (gc::IsA<Vector_sp>(b)) {
+    VectorRange rb(gc::As_unsafe<Vector_sp>(b));
+    vectorKernelCheckSame(ext::_sym_vector_compare,ra,a,rb,gc::As_unsafe<Vector_sp>(b));
+  }
+  DISPATCH_FLOAT_VECTOR(ra,template_vector_compare,cop,ra,b);
+  DISPATCH_INTEGER_VECTOR(ra,template_vector_compare,cop,ra,b);
+  vectorKernelTypeError(ext::_sym_vector_compare,a);
+}
+
+}; /* core */
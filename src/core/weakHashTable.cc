@@ -60,12 +60,25 @@ T_sp WeakKeyHashTable_O::hash_table_test() {
   return cl::_sym_eq;
 }
 
+SYMBOL_EXPORT_SC_(KeywordPkg, key);
+SYMBOL_EXPORT_SC_(KeywordPkg, value);
+SYMBOL_EXPORT_SC_(KeywordPkg, key_and_value);
+
+Symbol_sp WeakKeyHashTable_O::weakness() const {
+  switch (this->_HashTable._Weakness) {
+  case gctools::WeakKey: return kw::_sym_key;
+  case gctools::WeakValue: return kw::_sym_value;
+  case gctools::WeakKeyAndValue: return kw::_sym_key_and_value;
+  }
+  return _Nil<Symbol_O>();
+}
+
 
 void WeakKeyHashTable_O::describe(T_sp stream) {
   KeyBucketsType &keys = *this->_HashTable._Keys;
   ValueBucketsType &values = *this->_HashTable._Values;
   stringstream ss;
-  ss << (BF("WeakKeyHashTable   size: %zu\n") % this->_HashTable.length()).str();
+  ss << (BF("WeakKeyHashTable   size: %zu   weakness: %s\n") % this->_HashTable.length() % _rep_(this->weakness())).str();
   ss << (BF("   keys memory range:  %p  - %p \n") % &keys[0].rawRef_() % &keys[this->_HashTable.length()].rawRef_()).str();
   ss << (BF("   _HashTable.length = %d\n") % keys.length()).str();
   ss << (BF("   _HashTable.used = %d\n") % keys.used()).str();
@@ -90,6 +103,8 @@ void WeakKeyHashTable_O::describe(T_sp stream) {
       value_type val = values[i];
       if (val.sameAsKeyP()) {
         sentry << "sameAsKey!!!";
+      } else if (!val) {
+        sentry << "splatted";
       } else {
         sentry << _rep_(val);
       }
@@ -136,12 +151,22 @@ string WeakKeyHashTable_O::__repr__() const {
   return ss.str();
 }
 
-CL_LAMBDA(&optional (size 16));
+CL_LAMBDA(&optional (size 16) (weakness :key));
 CL_DECLARE();
-CL_DOCSTRING("makeWeakKeyHashTable");
-CL_DEFUN WeakKeyHashTable_sp core__make_weak_key_hash_table(Fixnum_sp size) {
+CL_DOCSTRING("Make an EQ weak hash table. WEAKNESS is :KEY, :VALUE or :KEY-AND-VALUE and says which side of an entry is held weakly - the entry goes away when any weak side of it is collected.");
+CL_DEFUN WeakKeyHashTable_sp core__make_weak_key_hash_table(Fixnum_sp size, Symbol_sp weakness) {
   int sz = unbox_fixnum(size);
-  WeakKeyHashTable_sp ht = gctools::GC<WeakKeyHashTable_O>::allocate(sz,DoubleFloat_O::create(2.0),0.5);
+  gctools::HashTableWeakness kind;
+  if (weakness == kw::_sym_key) {
+    kind = gctools::WeakKey;
+  } else if (weakness == kw::_sym_value) {
+    kind = gctools::WeakValue;
+  } else if (weakness == kw::_sym_key_and_value) {
+    kind = gctools::WeakKeyAndValue;
+  } else {
+    SIMPLE_ERROR(BF("Illegal weakness %s for a weak hash table - use :key, :value or :key-and-value") % _rep_(weakness));
+  }
+  WeakKeyHashTable_sp ht = gctools::GC<WeakKeyHashTable_O>::allocate(sz,DoubleFloat_O::create(2.0),0.5,kind);
   return ht;
 }
 
@@ -183,10 +208,9 @@ CL_LAMBDA(ht idx);
 CL_DECLARE();
 CL_DOCSTRING("weakSplat");
 CL_DEFUN void core__weak_splat(WeakKeyHashTable_sp ht, Fixnum_sp idx) {
-  T_sp splatted;     // This will be NULL
-  splatted.reset_(); // This will force it to be NULL
-  TESTING();         // Test the NULL value
-  (*ht->_HashTable._Keys).set(unbox_fixnum(idx), WeakKeyHashTable_O::value_type(splatted));
+  // Splat whichever side of the entry the collector would clear
+  gctools::tagged_pointer<KeyBucketsType> buckets = ht->_HashTable.weakKeysp() ? ht->_HashTable._Keys : ht->_HashTable._Values;
+  static_cast<gctools::WeakBucketsObjectType*>(&*buckets)->splat(unbox_fixnum(idx));
 };
 CL_LAMBDA(ht &optional sz);
 CL_DECLARE();
@@ -33,6 +33,7 @@ THE SOFTWARE.
 #include <clasp/gctools/gctoolsPackage.h>
 #ifdef USE_BOEHM // whole file #ifdef USE_BOEHM
 #include <clasp/gctools/boehmGarbageCollection.h>
+#include <clasp/gctools/gc_boot.h>
 #include <clasp/core/debugger.h>
 #include <clasp/core/compiler.h>
 
@@ -282,9 +283,163 @@ void* boehm_create_shadow_table(size_t nargs)
 };
 
 namespace gctools {
+
+BoehmCollectionStatistics global_boehm_statistics;
+bool global_boehm_incremental = false;
+BoehmStampDescriptor* global_boehm_stamp_descriptors = NULL;
+size_t global_boehm_stamp_descriptors_max = 0;
+size_t global_boehm_typed_stamps = 0;
+size_t global_boehm_atomic_stamps = 0;
+
+void BoehmCollectionStatistics::reset() {
+  this->_Collections = 0;
+  this->_TotalCollectionNanoseconds = 0;
+  this->_MaxCollectionNanoseconds = 0;
+  this->_LastCollectionNanoseconds = 0;
+  this->_Pauses = 0;
+  this->_TotalPauseNanoseconds = 0;
+  this->_MaxPauseNanoseconds = 0;
+}
+
+#ifdef CLASP_BOEHM_COLLECTION_EVENTS
+static uint64_t boehm_now_nanoseconds() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/*! Called by Boehm with the allocation lock held - it must not allocate */
+void boehm_collection_event(GC_EventType event) {
+  BoehmCollectionStatistics& stats = global_boehm_statistics;
+  switch (event) {
+  case GC_EVENT_START:
+      stats._CollectionStart = boehm_now_nanoseconds();
+      break;
+  case GC_EVENT_END: {
+      uint64_t ns = boehm_now_nanoseconds() - stats._CollectionStart;
+      stats._Collections++;
+      stats._TotalCollectionNanoseconds += ns;
+      stats._LastCollectionNanoseconds = ns;
+      if (ns > stats._MaxCollectionNanoseconds) stats._MaxCollectionNanoseconds = ns;
+    }
+      break;
+  case GC_EVENT_PRE_STOP_WORLD:
+      stats._PauseStart = boehm_now_nanoseconds();
+      break;
+  case GC_EVENT_POST_START_WORLD: {
+      uint64_t ns = boehm_now_nanoseconds() - stats._PauseStart;
+      stats._Pauses++;
+      stats._TotalPauseNanoseconds += ns;
+      if (ns > stats._MaxPauseNanoseconds) stats._MaxPauseNanoseconds = ns;
+    }
+      break;
+  default:
+      break;
+  }
+}
+#endif
+
+static size_t boehm_env_size(const char* name, size_t defaultValue) {
+  const char* cur = getenv(name);
+  if (!cur) return defaultValue;
+  return strtoul(cur,NULL,10);
+}
+
+/*! The collector is configured from the environment
+ *   CLASP_GC_MARKERS            - number of parallel marker threads (needs a Boehm built with parallel marking,
+ *                                 the default is one per core)
+ *   CLASP_GC_INCREMENTAL        - if set turn on incremental/generational collection
+ *   CLASP_GC_FREE_SPACE_DIVISOR - larger values collect more often and keep the heap smaller
+ *   CLASP_GC_INITIAL_HEAP_MB    - grow the heap to this size right away
+ *   CLASP_GC_MAX_HEAP_MB        - never grow the heap beyond this size
+ *   CLASP_GC_TYPED_ALLOCATION   - if set allocate stamps with known layouts atomically or with
+ *                                 type descriptors rather than scanning them conservatively
+ * GC_MARKERS is only read by GC_INIT so it must be set before that.
+ */
+void boehm_configure_before_init() {
+  const char* markers = getenv("CLASP_GC_MARKERS");
+  if (markers) setenv("GC_MARKERS",markers,1);
+}
+
+/*! Use the stamp layout tables (the same ones MPS scans with) to tell Boehm
+ * which stamps contain no pointers and where the pointers are in fixed size classes.
+ * Containers with pointer elements and templated stamps stay conservative.
+ * GC_make_descriptor needs an initialized collector.
+ */
+void boehm_build_stamp_descriptors() {
+  BoehmStampDescriptor* descriptors = (BoehmStampDescriptor*)malloc(sizeof(BoehmStampDescriptor)*(global_stamp_max+1));
+  memset(descriptors,0,sizeof(BoehmStampDescriptor)*(global_stamp_max+1));
+  for ( size_t stamp_index=0; stamp_index<=global_stamp_max; ++stamp_index ) {
+    const Stamp_layout& stamp_layout = global_stamp_layout[stamp_index];
+    if (!global_stamp_info[stamp_index].name) continue;
+    if (stamp_layout.layout_op == templated_op) continue;
+    if (stamp_layout.layout_op == bitunit_container_op) {
+      if (stamp_layout.number_of_fields == 0) {
+        descriptors[stamp_index]._Atomic = true;
+        ++global_boehm_atomic_stamps;
+      }
+      continue;
+    }
+    if (stamp_layout.container_layout) {
+      if (stamp_layout.number_of_fields == 0 && stamp_layout.container_layout->number_of_fields == 0) {
+        descriptors[stamp_index]._Atomic = true;
+        ++global_boehm_atomic_stamps;
+      }
+      continue;
+    }
+    if (stamp_layout.number_of_fields == 0) {
+      descriptors[stamp_index]._Atomic = true;
+      ++global_boehm_atomic_stamps;
+      continue;
+    }
+    size_t size = AlignUp(stamp_layout.size) + sizeof(Header_s);
+    size_t words = size/sizeof(GC_word);
+    std::vector<GC_word> bitmap((words+GC_WORDSZ-1)/GC_WORDSZ,0);
+    bool aligned = true;
+    const Field_layout* field_layout_cur = stamp_layout.field_layout_start;
+    for ( size_t i=0; i<stamp_layout.number_of_fields; ++i ) {
+      size_t offset = sizeof(Header_s) + field_layout_cur->field_offset;
+      if (offset%sizeof(GC_word) != 0 || offset >= size) {
+        aligned = false;
+        break;
+      }
+      GC_set_bit(bitmap.data(),offset/sizeof(GC_word));
+      ++field_layout_cur;
+    }
+    if (!aligned) continue;
+    descriptors[stamp_index]._Descriptor = GC_make_descriptor(bitmap.data(),words);
+    descriptors[stamp_index]._Size = size;
+    ++global_boehm_typed_stamps;
+  }
+  global_boehm_stamp_descriptors_max = global_stamp_max;
+  global_boehm_stamp_descriptors = descriptors;
+}
+
+void boehm_configure_after_init() {
+  if (getenv("CLASP_GC_INCREMENTAL")) {
+    GC_enable_incremental();
+    global_boehm_incremental = true;
+  }
+  size_t divisor = boehm_env_size("CLASP_GC_FREE_SPACE_DIVISOR",0);
+  if (divisor) GC_set_free_space_divisor(divisor);
+  size_t maxHeapMb = boehm_env_size("CLASP_GC_MAX_HEAP_MB",0);
+  if (maxHeapMb) GC_set_max_heap_size(maxHeapMb*1024*1024);
+  size_t initialHeapMb = boehm_env_size("CLASP_GC_INITIAL_HEAP_MB",0);
+  if (initialHeapMb) {
+    size_t heapSize = GC_get_heap_size();
+    if (initialHeapMb*1024*1024 > heapSize) GC_expand_hp(initialHeapMb*1024*1024-heapSize);
+  }
+  global_boehm_statistics.reset();
+#ifndef DEBUG_GUARD
+  if (getenv("CLASP_GC_TYPED_ALLOCATION")) boehm_build_stamp_descriptors();
+#endif
+#ifdef CLASP_BOEHM_COLLECTION_EVENTS
+  GC_set_on_collection_event(boehm_collection_event);
+#endif
+}
+
 __attribute__((noinline))
 int initializeBoehm(MainFunctionType startupFn, int argc, char *argv[], bool mpiEnabled, int mpiRank, int mpiSize) {
   GC_set_handle_fork(1);
+  boehm_configure_before_init();
   GC_INIT();
   GC_allow_register_threads();
   GC_set_java_finalization(1);
@@ -292,7 +447,7 @@ int initializeBoehm(MainFunctionType startupFn, int argc, char *argv[], bool mpi
   GC_set_all_interior_pointers(1); // tagged pointers require this
                                    //printf("%s:%d Turning on interior pointers\n",__FILE__,__LINE__);
   GC_set_warn_proc(clasp_warn_proc);
-  //  GC_enable_incremental();
+  boehm_configure_after_init();
   GC_init();
   void* topOfStack;
   // ctor sets up my_thread
@@ -976,6 +976,97 @@ CL_DEFUN void gctools__garbage_collect() {
   //        printf("Garbage collection done\n");
 };
 
+CL_DOCSTRING("Return the number of threads that mark in parallel during a collection.");
+CL_DEFUN size_t gctools__gc_marker_threads() {
+#ifdef USE_BOEHM
+  // GC_get_parallel returns the number of helper threads
+  return GC_get_parallel()+1;
+#else
+  return 1;
+#endif
+}
+
+CL_DOCSTRING("Return T if the collector runs in incremental/generational mode - set CLASP_GC_INCREMENTAL to turn it on.");
+CL_DEFUN bool gctools__gc_incremental_p() {
+#ifdef USE_BOEHM
+  return global_boehm_incremental;
+#else
+  return false;
+#endif
+}
+
+CL_DOCSTRING("Return the Boehm free space divisor or NIL for other collectors.  Larger values collect more often and keep the heap smaller.");
+CL_DEFUN core::T_sp gctools__gc_free_space_divisor() {
+#ifdef USE_BOEHM
+  return core::make_fixnum(GC_get_free_space_divisor());
+#else
+  return _Nil<core::T_O>();
+#endif
+}
+
+CL_LAMBDA(divisor);
+CL_DOCSTRING("Set the Boehm free space divisor.");
+CL_DEFUN void gctools__set_gc_free_space_divisor(size_t divisor) {
+  if (divisor == 0) {
+    SIMPLE_ERROR(BF("The free space divisor must be positive"));
+  }
+#ifdef USE_BOEHM
+  GC_set_free_space_divisor(divisor);
+#endif
+}
+
+CL_LAMBDA(bytes);
+CL_DOCSTRING("Grow the heap by BYTES now rather than collecting repeatedly while it grows.  Return T if the heap was expanded.");
+CL_DEFUN bool gctools__gc_expand_heap(size_t bytes) {
+#ifdef USE_BOEHM
+  return GC_expand_hp(bytes) != 0;
+#else
+  return false;
+#endif
+}
+
+CL_LAMBDA(bytes);
+CL_DOCSTRING("Never grow the heap beyond BYTES - 0 means no limit.");
+CL_DEFUN void gctools__gc_set_max_heap_size(size_t bytes) {
+#ifdef USE_BOEHM
+  GC_set_max_heap_size(bytes);
+#endif
+}
+
+CL_DOCSTRING("Return (values collections total-seconds max-seconds last-seconds pauses total-pause-seconds max-pause-seconds) for the collections since startup or the last reset-gc-pause-statistics.  Collection times run from the start to the end of a collection, pauses are the times the world was stopped.  Only Boehm collections are timed; with other collectors all seven values are zero.");
+CL_DEFUN core::T_mv gctools__gc_pause_statistics() {
+#ifdef USE_BOEHM
+  BoehmCollectionStatistics& stats = global_boehm_statistics;
+  return Values(core::make_fixnum(stats._Collections.load()),
+                core::DoubleFloat_O::create(stats._TotalCollectionNanoseconds.load()/1.0e9),
+                core::DoubleFloat_O::create(stats._MaxCollectionNanoseconds.load()/1.0e9),
+                core::DoubleFloat_O::create(stats._LastCollectionNanoseconds.load()/1.0e9),
+                core::make_fixnum(stats._Pauses.load()),
+                core::DoubleFloat_O::create(stats._TotalPauseNanoseconds.load()/1.0e9),
+                core::DoubleFloat_O::create(stats._MaxPauseNanoseconds.load()/1.0e9));
+#else
+  core::T_sp zero = core::DoubleFloat_O::create(0.0);
+  return Values(core::make_fixnum(0), zero, zero, zero,
+                core::make_fixnum(0), zero, zero);
+#endif
+}
+
+CL_DEFUN void gctools__reset_gc_pause_statistics() {
+#ifdef USE_BOEHM
+  global_boehm_statistics.reset();
+#endif
+}
+
+CL_DOCSTRING("Return (values typed-stamps atomic-stamps), the number of stamps that Boehm allocates with type descriptors and without any pointers.  Both are zero unless CLASP_GC_TYPED_ALLOCATION was set at startup.");
+CL_DEFUN core::T_mv gctools__gc_typed_allocation_stamps() {
+#ifdef USE_BOEHM
+  return Values(core::make_fixnum(global_boehm_typed_stamps),
+                core::make_fixnum(global_boehm_atomic_stamps));
+#else
+  return Values(core::make_fixnum(0),core::make_fixnum(0));
+#endif
+}
+
 CL_DEFUN void gctools__register_stamp_name(const std::string& name,size_t stamp_num)
 {
   register_stamp_name(name,stamp_num);
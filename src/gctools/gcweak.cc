@@ -1,6 +1,6 @@
 /* NOTES:
 
-(1) _deleted is not being used or updated properly.
+(1) _deleted is now maintained for entries that Boehm splats, but the MPS scanner still turns them into deleted entries without counting them.
 (2) There is something wrong with WeakKeyHashTable - weak pointers end up pointing to memory that is not the start of an object
 (3) The other weak objects (weak pointer, weak mapping) are doing allocations in their constructors.
 
@@ -93,8 +93,16 @@ void WeakKeyHashTable::initialize() {
   size_t l;
   for (l = 1; l < length; l *= 2)
     ;
-  this->_Keys = KeyBucketsAllocatorType::allocate(l);
-  this->_Values = ValueBucketsAllocatorType::allocate(l);
+  if (this->weakKeysp()) {
+    this->_Keys = WeakBucketsAllocatorType::allocate(l);
+  } else {
+    this->_Keys = StrongBucketsAllocatorType::allocate(l);
+  }
+  if (this->weakValuesp()) {
+    this->_Values = WeakBucketsAllocatorType::allocate(l);
+  } else {
+    this->_Values = StrongBucketsAllocatorType::allocate(l);
+  }
   this->_Keys->dependent = this->_Values;
   //  GCTOOLS_ASSERT((reinterpret_cast<uintptr_t>(this->_Keys->dependent) & 0x3) == 0);
   this->_Values->dependent = this->_Keys;
@@ -113,6 +121,18 @@ uint WeakKeyHashTable::sxhashKey(const value_type &key) {
   return core::lisp_hash(reinterpret_cast<uintptr_t>(lisp_badge(key)));
 }
 
+bool WeakKeyHashTable::reap_not_safe(gctools::tagged_pointer<KeyBucketsType> keys, size_t idx) {
+  value_type &k = (*keys)[idx];
+  if (k.unboundp() || k.deletedp()) return false;
+  value_type &v = (*keys->dependent)[idx];
+  if (k.raw_() && v.raw_() && !v.deletedp()) return false;
+  // Write the key first so that lock free readers stop matching this entry
+  WeakKeyHashTable::setBucket(keys, idx, value_type(gctools::make_tagged_deleted<core::T_O*>()));
+  WeakKeyHashTable::setBucket(keys->dependent, idx, value_type(gctools::make_tagged_unbound<core::T_O*>()));
+  keys->setDeleted(keys->deleted() + 1);
+  return true;
+}
+
 /*! Return 0 if there is no more room in the sequence of entries for the key
 	  Return 1 if the element is found or an unbound or deleted entry is found.
 	  Return the entry index in (b)
@@ -145,24 +165,16 @@ size_t WeakKeyHashTable::find_no_lock(gctools::tagged_pointer<KeyBucketsType> ke
       *reportP << "  i = " << i << "   k = " << (void *)(k.raw_()) << std::endl;
     }
 #endif
-    if (k.unboundp() || k == key) {
+    if (k.unboundp()) {
       b = i;
-#ifdef DEBUG_FIND
-      if (debugFind && k != key) {
-        *reportP << "find  returning 1 b= " << b << " k = " << k.raw_() << std::endl;
-      }
-#endif
       return 1;
     }
-#ifdef USE_BOEHM
-    // Handle splatting
-    if (!k.raw_()) {
-      auto deleted = value_type(gctools::make_tagged_deleted<core::T_O*>());
-      keys->set(i, deleted);
-      ValueBucketsType *values = dynamic_cast<ValueBucketsType *>(&*keys->dependent);
-      (*values)[i] = value_type(gctools::make_tagged_unbound<core::T_O*>());
+    // Handle splatting of the key or the value
+    WeakKeyHashTable::reap_not_safe(keys, i);
+    if (k == key) {
+      b = i;
+      return 1;
     }
-#endif
     if (result == 0 && (k.deletedp())) {
       b = i;
       result = 1;
@@ -171,10 +183,52 @@ size_t WeakKeyHashTable::find_no_lock(gctools::tagged_pointer<KeyBucketsType> ke
   } while (i != h);
   return result;
 }
+
+bool WeakKeyHashTable::find_lock_free(gctools::tagged_pointer<KeyBucketsType> keys, const value_type &key, size_t &b) {
+  unsigned long i, h, probe;
+  unsigned long l = keys->length() - 1;
+  h = WeakKeyHashTable::sxhashKey(key);
+  probe = (h >> 8) | 1;
+  h &= l;
+  i = h;
+  do {
+    value_type k = keys->load(i);
+    if (k.unboundp()) return false;
+    if (k == key) {
+      b = i;
+      return true;
+    }
+    // Splatted and deleted entries are skipped - only writers reclaim them
+    i = (i + probe) & l;
+  } while (i != h);
+  return false;
+}
+
+/*! Check the next (batch) entries for keys or values that the collector cleared.
+    Spreading this over calls to set() keeps stale entries from piling up
+    without ever scanning the whole table at once. */
+void WeakKeyHashTable::sweep_not_safe(size_t batch) {
+  size_t len = this->_Keys->length();
+  size_t i = this->_SweepIndex;
+  if (i >= len) i = 0;
+  for (size_t n(0); n < batch && n < len; ++n) {
+    WeakKeyHashTable::reap_not_safe(this->_Keys, i);
+    if (++i >= len) i = 0;
+  }
+  this->_SweepIndex = i;
+}
+
 int WeakKeyHashTable::rehash_not_safe(const value_type &key, size_t &key_bucket) {
   HT_WRITE_LOCK(this);
   size_t newLength;
-  if (this->_RehashSize.fixnump()) {
+  size_t live = 0;
+  for (size_t i(0), iEnd(this->_Keys->length()); i < iEnd; ++i) {
+    if (liveEntryp((*this->_Keys)[i], (*this->_Values)[i])) ++live;
+  }
+  if (live < (this->_RehashThreshold * this->_Keys->length()) / 2) {
+    // Mostly collected or removed entries - compact in place rather than growing
+    newLength = this->_Keys->length();
+  } else if (this->_RehashSize.fixnump()) {
     newLength = this->_Keys->length() + this->_RehashSize.unsafe_fixnum();
   } else if (gc::IsA<core::Float_sp>(this->_RehashSize)) {
     double size = core::clasp_to_double(this->_RehashSize);
@@ -188,15 +242,12 @@ int WeakKeyHashTable::rehash_not_safe(const value_type &key, size_t &key_bucket)
 		// buckets_t new_keys, new_values;
   result = 0;
   length = this->_Keys->length();
-  MyType newHashTable(newLength,this->_RehashSize,this->_RehashThreshold);
+  MyType newHashTable(newLength,this->_RehashSize,this->_RehashThreshold,this->_Weakness);
   newHashTable.initialize();
-		//new_keys = make_buckets(newLength, this->key_ap);
-		//new_values = make_buckets(newLength, this->value_ap);
-		//new_keys->dependent = new_values;
-		//new_values->dependent = new_keys;
   for (i = 0; i < length; ++i) {
-    value_type& old_key = (*this->_Keys)[i];
-    if (!old_key.unboundp() && !old_key.deletedp() && old_key.raw_() ) {
+    value_type old_key = (*this->_Keys)[i];
+    value_type old_value = (*this->_Values)[i];
+    if (liveEntryp(old_key, old_value)) {
       size_t found;
       size_t b;
       found = WeakKeyHashTable::find_no_lock(newHashTable._Keys, old_key, b);
@@ -205,7 +256,7 @@ int WeakKeyHashTable::rehash_not_safe(const value_type &key, size_t &key_bucket)
         printf("%s:%d About to copy key: %12p   at index %zu    to newHashTable at index: %zu\n", __FILE__, __LINE__,
                old_key.raw_(), i, b );
         printf("Key = %s\n", core::lisp_rep(old_key).c_str());
-        printf("    original value@%p = %s\n", (*this->_Values)[i].raw_(), core::lisp_rep((*this->_Values)[i]).c_str());
+        printf("    original value@%p = %s\n", old_value.raw_(), core::lisp_rep(old_value).c_str());
         printf("newHashTable value@%p = %s\n", (*newHashTable._Values)[b].raw_(), core::lisp_rep((*newHashTable._Values)[b]).c_str());
         printf("--------- Original table\n");
         printf("%s\n", this->dump("Original").c_str());
@@ -213,8 +264,8 @@ int WeakKeyHashTable::rehash_not_safe(const value_type &key, size_t &key_bucket)
         printf("%s\n", newHashTable.dump("Copy").c_str());
       }
       GCTOOLS_ASSERT((*newHashTable._Keys)[b].unboundp()); /* shouldn't be in new table */
-      newHashTable._Keys->set(b,old_key);
-      (*newHashTable._Values)[b] = (*this->_Values)[i];
+      WeakKeyHashTable::setBucket(newHashTable._Values, b, old_value);
+      WeakKeyHashTable::setBucket(newHashTable._Keys, b, old_key);
       if (key && old_key == key ) {
         key_bucket = b;
         result = 1;
@@ -240,82 +291,43 @@ int WeakKeyHashTable::rehash( const value_type &key, size_t &key_bucket) {
 int WeakKeyHashTable::trySet(core::T_sp tkey, core::T_sp value) {
   HT_WRITE_LOCK(this);
   GCWEAK_LOG(BF("Entered trySet with key %p") % tkey.raw_());
+  this->sweep_not_safe(SweepBatch);
   size_t b;
+  value_type key(WeakKeyHashTable::encode(tkey));
+  value_type val;
   if (tkey == value) {
-    value = gctools::make_tagged_sameAsKey<core::T_O>();
-  }
-  value_type key(tkey);
-#ifdef DEBUG_TRYSET
-  stringstream report;
-  report << "About to trySet with the key " << tkey.raw_() << std::endl;
-  report << this->dump("trySet-incoming WeakKeyHashTable: ") << std::endl;
-  // Count the number of times the key is in the table
-  int alreadyThere = 0;
-  int firstOtherIndex = 0;
-  for (int i(0); i < (*this->_Keys).length(); ++i) {
-    if ((*this->_Keys)[i] == tkey) {
-      firstOtherIndex = i;
-      ++alreadyThere;
-    }
+    val = gctools::make_tagged_sameAsKey<core::T_O>();
+  } else {
+    val = WeakKeyHashTable::encode(value);
   }
-#endif
   size_t result = WeakKeyHashTable::find_no_lock(this->_Keys, key, b);
-  if ((!result || (*this->_Keys)[b] != key)) {
-    GCWEAK_LOG(BF("then case - Returned from find with result = %d     (*this->_Keys)[b=%d] = %p") % result % b % (*this->_Keys)[b].raw_());
-#ifdef DEBUG_TRYSET
-    if (alreadyThere) {
-      report << "Could not find the key @" << key.raw_() << std::endl;
-      if (!result) {
-        report << " because find return result = " << result << " - which means that the hash table was searched and the key was not found before the hash list was exhausted" << std::endl;
-      }
-      if ((*this->_Keys)[b] != key) {
-        report << " because find hit an empty (unbound or deleted) slot before it found the key" << std::endl;
-      }
-      report << " ...  about to check if mps_ld_isstale" << std::endl;
-    }
-#endif
-
-  } else {
-    GCWEAK_LOG(BF("else case - Returned from find with result = %d     (*this->_Keys)[b=%d] = %p") % result % b % (*this->_Keys)[b].raw_());
-    GCWEAK_LOG(BF("Calling mps_ld_add for key: %p") % (void *)key.raw_());
+  if (!result) {
+    GCWEAK_LOG(BF("No room for the key"));
+    return 0;
   }
+  // The value is written before the key so that a lock free reader that
+  // sees the key also sees its value.
   if ((*this->_Keys)[b].unboundp()) {
     GCWEAK_LOG(BF("Writing key over unbound entry"));
-    this->_Keys->set(b, key);
+    WeakKeyHashTable::setBucket(this->_Values, b, val);
+    WeakKeyHashTable::setBucket(this->_Keys, b, key);
     (*this->_Keys).setUsed((*this->_Keys).used() + 1);
 #ifdef DEBUG_GCWEAK
     printf("%s:%d key was unboundp at %zu  used = %d\n", __FILE__, __LINE__, b, this->_Keys->used());
 #endif
   } else if ((*this->_Keys)[b].deletedp()) {
     GCWEAK_LOG(BF("Writing key over deleted entry"));
-    this->_Keys->set(b, key);
+    WeakKeyHashTable::setBucket(this->_Values, b, val);
+    WeakKeyHashTable::setBucket(this->_Keys, b, key);
     GCTOOLS_ASSERT((*this->_Keys).deleted() > 0);
     (*this->_Keys).setDeleted((*this->_Keys).deleted() - 1);
 #ifdef DEBUG_GCWEAK
     printf("%s:%d key was deletedp at %zu  deleted = %d\n", __FILE__, __LINE__, b, (*this->_Keys).deleted());
 #endif // DEBUG_GCWEAK
+  } else {
+    GCWEAK_LOG(BF("Setting value at b = %d") % b);
+    WeakKeyHashTable::setBucket(this->_Values, b, val);
   }
-  GCWEAK_LOG(BF("Setting value at b = %d") % b);
-  (*this->_Values).set(b, value_type(value));
-#ifdef DEBUG_TRYSET
-  // Count the number of times the key is in the table
-  int count = 0;
-  int otherIndex;
-  for (int i(0); i < (*this->_Keys).length(); ++i) {
-    if ((*this->_Keys)[i] == tkey) {
-      if (i != b) {
-        otherIndex = i;
-      }
-      ++count;
-    }
-  }
-  if (count > 1) {
-    printf("Found %d duplicate keys %p in hash table\n", count, tkey.raw_());
-    printf("Log of trySet action:\n%s\n", report.str().c_str());
-    printf("The new key is at %zu and another instance of the key is at %d\n", b, otherIndex);
-    printf("%s\n", this->dump("Final trySet table").c_str());
-  }
-#endif
   GCWEAK_LOG(BF("Leaving trySet"));
   return 1;
 }
@@ -345,31 +357,34 @@ string WeakKeyHashTable::dump(const string &prefix) {
 // ----------------------------------------------------------------------
 // ----------------------------------------------------------------------
 
+/*! Lookups don't take the lock.  Writers publish a new bucket array through
+    _Values and then _Keys and write values before keys, so a reader that
+    finds the key sees its value.  The value buckets are loaded from the
+    table rather than through the key buckets, whose header the collector
+    doesn't scan, and a reader that catches a rehash between the two loads
+    tries again.  The key is read again after the value to catch an entry
+    that was removed (and maybe reused) while we were looking at it. */
 core::T_mv WeakKeyHashTable::gethash(core::T_sp tkey, core::T_sp defaultValue) {
-  core::T_mv result_mv;
-  safeRun<void()>([&result_mv, this, tkey, defaultValue]() -> void {
-      HT_READ_LOCK(this);
-      value_type key(tkey);
-      size_t pos;
-      size_t result = gctools::WeakKeyHashTable::find_no_lock(this->_Keys,key ,pos);
-      if (result) { // WeakKeyHashTable::find(this->_Keys,key,false,pos)) { //buckets_find(tbl, this->keys, key, NULL, &b)) {
-        value_type& k = (*this->_Keys)[pos];
-        GCWEAK_LOG(BF("gethash find successful pos = %d  k= %p k.unboundp()=%d k.base_ref().deletedp()=%d k.NULLp()=%d") % pos % k.raw_() % k.unboundp() % k.deletedp() % (bool)k );
-        if ( k.raw_() && !k.unboundp() && !k.deletedp() ) {
-          GCWEAK_LOG(BF("Returning success!"));
-          core::T_sp value = smart_ptr<core::T_O>((*this->_Values)[pos]);
-          if ( value.sameAsKeyP() ) {
-            value = smart_ptr<core::T_O>(k);
-          }
-          result_mv = Values(value,core::lisp_true());
-          return;
-        }
-        GCWEAK_LOG(BF("Falling through"));
+  value_type key(WeakKeyHashTable::encode(tkey));
+  gctools::tagged_pointer<KeyBucketsType> keys;
+  gctools::tagged_pointer<ValueBucketsType> values;
+  do {
+    keys = this->loadKeys();
+    values = this->loadValues();
+  } while (reinterpret_cast<void *>(values->dependent.raw_()) != reinterpret_cast<void *>(keys.raw_()));
+  size_t pos;
+  if (WeakKeyHashTable::find_lock_free(keys, key, pos)) {
+    value_type value = values->load(pos);
+    if (value.raw_() && !value.unboundp() && !value.deletedp() && keys->load(pos) == key) {
+      GCWEAK_LOG(BF("Returning success!"));
+      if (value.sameAsKeyP()) {
+        return Values(tkey, core::lisp_true());
       }
-      result_mv = Values(defaultValue,_Nil<core::T_O>());
-      return;
-    });
-  return result_mv;
+      return Values(WeakKeyHashTable::decode(value), core::lisp_true());
+    }
+    GCWEAK_LOG(BF("Falling through"));
+  }
+  return Values(defaultValue, _Nil<core::T_O>());
 }
 
 void WeakKeyHashTable::set(core::T_sp key, core::T_sp value) {
@@ -385,23 +400,24 @@ void WeakKeyHashTable::set(core::T_sp key, core::T_sp value) {
   });
 }
 
+/*! Iterate over a snapshot of the buckets without taking the lock.  As in
+    gethash, the keys and values are loaded until they belong to the same
+    rehash, so the values are never read past the end of their buckets. */
 #define HASH_TABLE_ITER(table_type,tablep, key, value) \
   gctools::tagged_pointer<table_type::KeyBucketsType> iter_Keys; \
   gctools::tagged_pointer<table_type::ValueBucketsType> iter_Values; \
+  do { \
+    iter_Keys = tablep->loadKeys(); \
+    iter_Values = tablep->loadValues(); \
+  } while (reinterpret_cast<void *>(iter_Values->dependent.raw_()) != reinterpret_cast<void *>(iter_Keys.raw_())); \
   core::T_sp key; \
   core::T_sp value; \
-  {\
-    HT_READ_LOCK(tablep);\
-    iter_Keys = tablep->_Keys; \
-    iter_Values = tablep->_Values; \
-  }\
   for (size_t it(0), itEnd(iter_Keys->length()); it < itEnd; ++it) {\
-  { \
-    HT_READ_LOCK(tablep);\
-    key = (*iter_Keys)[it]; \
-    value = (*iter_Values)[it]; \
-  } \
-  if (key.raw_()&&!key.unboundp()&&!key.deletedp())
+  table_type::value_type iter_key = iter_Keys->load(it); \
+  table_type::value_type iter_value = iter_Values->load(it); \
+  key = table_type::decode(iter_key); \
+  value = iter_value.sameAsKeyP() ? key : table_type::decode(iter_value); \
+  if (table_type::liveEntryp(iter_key,iter_value))
 
 #define HASH_TABLE_ITER_END }
 
@@ -430,26 +446,14 @@ bool WeakKeyHashTable::remhash(core::T_sp tkey) {
   safeRun<void()>([this, tkey, &bresult]() -> void {
       HT_WRITE_LOCK(this);
 		size_t b;
-		value_type key(tkey);
+		value_type key(WeakKeyHashTable::encode(tkey));
 		size_t result = gctools::WeakKeyHashTable::find_no_lock(this->_Keys, key, b);
-		if( ! result ||
-                    !((*this->_Keys)[b]).raw_() ||
-		    (*this->_Keys)[b].unboundp() ||
-		    (*this->_Keys)[b].deletedp() )
-		    {
-                      if(!this->rehash( key, b)) {
-                        bresult = false;
-                        return;
-                      }
-		    }
-		if( (*this->_Keys)[b].raw_() &&
-                    !(*this->_Keys)[b].unboundp() &&
-		    !(*this->_Keys)[b].deletedp() )
+		if( result && (*this->_Keys)[b] == key )
 		    {
                       auto deleted = value_type(gctools::make_tagged_deleted<core::T_O*>());
-                      this->_Keys->set(b, deleted);
+                      WeakKeyHashTable::setBucket(this->_Keys, b, deleted);
                       (*this->_Keys).setDeleted((*this->_Keys).deleted()+1);
-                      (*this->_Values)[b] = value_type(gctools::make_tagged_unbound<core::T_O*>());
+                      WeakKeyHashTable::setBucket(this->_Values, b, value_type(gctools::make_tagged_unbound<core::T_O*>()));
                       bresult = true;
                       return;
 		    }
@@ -463,8 +467,8 @@ void WeakKeyHashTable::clrhash() {
       HT_WRITE_LOCK(this);
 		size_t len = (*this->_Keys).length();
 		for ( size_t i(0); i<len; ++i ) {
-                  this->_Keys->set(i,value_type(gctools::make_tagged_deleted<core::T_O*>()));
-                  (*this->_Values)[i] = value_type(gctools::make_tagged_unbound<core::T_O*>());
+                  WeakKeyHashTable::setBucket(this->_Keys, i, value_type(gctools::make_tagged_unbound<core::T_O*>()));
+                  WeakKeyHashTable::setBucket(this->_Values, i, value_type(gctools::make_tagged_unbound<core::T_O*>()));
 		}
 		(*this->_Keys).setUsed(0);
 		(*this->_Keys).setDeleted(0);
@@ -473,18 +477,12 @@ void WeakKeyHashTable::clrhash() {
 
 
 CL_DEFUN core::Vector_sp weak_key_hash_table_pairs(const WeakKeyHashTable& ht) {
-  size_t len = (*ht._Keys).length();
+  size_t len = ht.loadKeys()->length();
   core::ComplexVector_T_sp keyvalues = core::ComplexVector_T_O::make(len*2,_Nil<core::T_O>(),core::make_fixnum(0));
-  size_t idx(0);
-  HT_READ_LOCK(&ht);
-  for ( size_t i(0); i<len; ++i ) {
-    if ( (*ht._Keys)[i].raw_() &&
-         !(*ht._Keys)[i].unboundp() &&
-         !(*ht._Keys)[i].deletedp() ) {
-      keyvalues->vectorPushExtend((*ht._Keys)[i],16);
-      keyvalues->vectorPushExtend((*ht._Values)[i],16);
-    }
-  }
+  HASH_TABLE_ITER(WeakKeyHashTable,(&ht),key,value) {
+    keyvalues->vectorPushExtend(key,16);
+    keyvalues->vectorPushExtend(value,16);
+  } HASH_TABLE_ITER_END;
   return keyvalues;
 };
 }
@@ -6,6 +6,10 @@
   )
 
 (defparameter *number-of-jobs* 1)
+;;; How a parallel build compiles files: :fork compiles them in forked
+;;; child processes, :threads compiles them in this process. :threads
+;;; is only used for cclasp and has to be asked for.
+(defparameter *parallel-build-driver* :fork)
 
 #+(or)
 (progn
@@ -549,18 +553,189 @@ Return files."
                                (incf child-count))))))))
            (if (> child-count 0) (go top)))))))
 
+(defun build-file-dependencies (files file-order reload)
+  "Return a hash-table that maps each entry in FILES to the entries that must be
+compiled (and reloaded) before it can be compiled.  Without RELOAD the files are
+compiled against an environment that is already loaded and are independent of each
+other.  With RELOAD each file has to see the file before it in FILE-ORDER loaded."
+  (let ((dependencies (make-hash-table :test #'eq))
+        previous)
+    (dolist (entry (sort (copy-list files) #'<
+                         :key #'(lambda (entry) (gethash (entry-filename entry) file-order))))
+      (core:hash-table-setf-gethash dependencies entry (if (and reload previous) (list previous) nil))
+      (setq previous entry))
+    dependencies))
+
+(defun compile-system-threaded (files &key reload (output-type core:*clasp-build-mode*) total-files (parallel-jobs *number-of-jobs*) batch-min batch-max file-order)
+  "Compile FILES on up to PARALLEL-JOBS threads of this process so that every file
+sees the environment that is already loaded.  The order of FILES is the scheduling
+priority; the output of each file is captured and printed in FILE-ORDER so the
+build log is the same from run to run.  Files that fail are reported individually
+and then an error is signaled."
+  (declare (ignore batch-min batch-max))
+  (mmsg "compile-system-threaded files %s%N" files)
+  (let* ((total (or total-files (length files)))
+         (lock (mp:make-lock :name "compile-system-threaded"))
+         (changed (mp:make-condition-variable :name "compile-system-threaded"))
+         (dependencies (build-file-dependencies files file-order reload))
+         (ordered (sort (copy-list files) #'<
+                        :key #'(lambda (entry) (gethash (entry-filename entry) file-order))))
+         (unreported ordered)
+         (states (make-hash-table :test #'eq))
+         (outputs (make-hash-table :test #'eq))
+         (failures (make-hash-table :test #'eq))
+         (threads (make-hash-table :test #'eq))
+         (running 0)
+         ;; New threads only see global values - pass along what the caller bound.
+         (binding-symbols (list '*package* '*readtable* '*features* '*target-backend*
+                                '*default-pathname-defaults* 'core:*defun-inline-hook*))
+         (binding-values (mapcar #'symbol-value binding-symbols)))
+    (labels ((entry-position (entry)
+               (let ((pos (gethash (entry-filename entry) file-order)))
+                 (if pos
+                     nil
+                     (error "Could not get position of ~s in file-order" (entry-filename entry)))
+                 pos))
+             (entry-state (entry) (gethash entry states))
+             (setf-entry-state (entry state) (core:hash-table-setf-gethash states entry state))
+             (compile-one (entry)
+               ;; Runs in a worker thread
+               (let ((output (make-string-output-stream))
+                     failure)
+                 (progv binding-symbols binding-values
+                   (let ((*standard-output* output)
+                         (*error-output* output))
+                     (block compile
+                       (handler-bind
+                           ((serious-condition
+                              #'(lambda (condition)
+                                  (setq failure (format nil "~a: ~a" (type-of condition) condition))
+                                  (return-from compile))))
+                         (compile-kernel-file entry :reload nil :output-type output-type :position (entry-position entry) :total-files total :silent t :verbose t)))))
+                 (mp:get-lock lock)
+                 (unwind-protect
+                      (progn
+                        (core:hash-table-setf-gethash outputs entry (get-output-stream-string output))
+                        (if failure (core:hash-table-setf-gethash failures entry failure))
+                        (setf-entry-state entry :finished)
+                        (mp:condition-variable-broadcast changed))
+                   (mp:giveup-lock lock))))
+             (start-one (entry)
+               (setf-entry-state entry :running)
+               (incf running)
+               (core:hash-table-setf-gethash
+                threads entry
+                (mp:process-run-function (format nil "compile-system-~d" (1+ (entry-position entry)))
+                                         #'(lambda () (compile-one entry))
+                                         nil)))
+             (dependencies-state (entry)
+               ;; :ready, :blocked if a dependency failed, otherwise :waiting
+               (let ((result :ready))
+                 (dolist (dependency (gethash entry dependencies))
+                   (let ((state (entry-state dependency)))
+                     (if (or (eq state :failed) (eq state :skipped))
+                         (setq result :blocked)
+                         (if (and (not (eq state :done)) (eq result :ready))
+                             (setq result :waiting)))))
+                 result))
+             (collect-finished ()
+               (dolist (entry ordered)
+                 (if (eq (entry-state entry) :finished)
+                     (progn
+                       (mp:process-join (gethash entry threads))
+                       (decf running)
+                       (if (gethash entry failures)
+                           (setf-entry-state entry :failed)
+                           (progn
+                             (if reload
+                                 (load-kernel-file (build-pathname (entry-filename entry) output-type) :silent t))
+                             (setf-entry-state entry :done)))))))
+             (start-ready ()
+               ;; Dependencies always precede an entry in ORDERED so one pass propagates skips
+               (dolist (entry ordered)
+                 (if (and (eq (entry-state entry) :waiting)
+                          (eq (dependencies-state entry) :blocked))
+                     (setf-entry-state entry :skipped)))
+               (dolist (entry files)
+                 (if (and (< running parallel-jobs)
+                          (eq (entry-state entry) :waiting)
+                          (eq (dependencies-state entry) :ready))
+                     (start-one entry))))
+             (report-one (entry)
+               (let ((state (entry-state entry))
+                     (source-path (build-pathname (entry-filename entry) :lisp))
+                     (output-path (build-pathname (entry-filename entry) output-type)))
+                 (format t "~%Compiled [~d of ~d] ~s~%    to ~s~a~%"
+                         (1+ (entry-position entry)) total source-path output-path
+                         (cond
+                           ((eq state :failed) " - FAILED")
+                           ((eq state :skipped) " - SKIPPED because a file it depends on failed")
+                           (t "")))
+                 (write-string (gethash entry outputs "") *standard-output*)
+                 (if (eq state :failed)
+                     (format t "~a~%" (gethash entry failures)))
+                 (finish-output)))
+             (report-in-order ()
+               (tagbody
+                top
+                  (if (and unreported
+                           (member (entry-state (car unreported)) '(:done :failed :skipped)))
+                      (progn
+                        (report-one (car unreported))
+                        (setq unreported (cdr unreported))
+                        (go top))))))
+      (dolist (entry files)
+        (setf-entry-state entry :waiting))
+      (format t "Compiling ~d files on up to ~d threads~%" (length files) parallel-jobs)
+      (mp:get-lock lock)
+      (unwind-protect
+           (tagbody
+            top
+              (collect-finished)
+              (start-ready)
+              (report-in-order)
+              (if (null unreported) (go done))
+              (if (= running 0)
+                  (error "compile-system-threaded cannot make progress - unfinished files: ~a" unreported))
+              (mp:condition-variable-wait changed lock)
+              (go top)
+            done)
+        (mp:giveup-lock lock))
+      (let (failed)
+        (dolist (entry ordered)
+          (if (gethash entry failures)
+              (setq failed (cons entry failed))))
+        (if failed
+            (progn
+              (setq failed (nreverse failed))
+              (format *error-output* "~d of ~d files failed to compile:~%" (length failed) (length files))
+              (dolist (entry failed)
+                (format *error-output* "  [~d of ~d] ~s~%      ~a~%"
+                        (1+ (entry-position entry)) total
+                        (build-pathname (entry-filename entry) :lisp)
+                        (gethash entry failures)))
+              (error "~d kernel files failed to compile" (length failed))))))))
+
 (defun parallel-build-p ()
   (and core:*use-parallel-build* (> *number-of-jobs* 1)))
 
+(defun threaded-build-p ()
+  ;; The aclasp and bclasp stages share unsynchronized compiler caches
+  ;; (e.g. core:*cache-macroexpand*) so only cclasp compiles on threads.
+  (and (eq *parallel-build-driver* :threads)
+       (member :cclasp *features*)))
+
 (defun compile-system (&rest args)
   (let ((compile-function (if (parallel-build-p)
-                              'compile-system-parallel
+                              (if (threaded-build-p)
+                                  'compile-system-threaded
+                                  'compile-system-parallel)
                               'compile-system-serial)))
     (format t "Compiling with ~a / core:*use-parallel-build* -> ~a  core:*number-of-jobs* -> ~a~%" compile-function core:*use-parallel-build* *number-of-jobs*)
     
     (apply compile-function args)))
 
-(export '(compile-system-serial compile-system compile-system-parallel))
+(export '(compile-system-serial compile-system compile-system-parallel compile-system-threaded))
 
 (defun select-trailing-source-files (after-file &key system)
   (or system (error "You must provide :system to select-trailing-source-files"))
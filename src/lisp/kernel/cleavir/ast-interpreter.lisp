@@ -3,6 +3,7 @@
   (:export #:interpret)
   (:export #:cannot-interpret #:cannot-interpret-ast)
   (:export #:can-interpret-ast-p)
+  (:export #:*tier-up-threshold* #:*tier-up-hook*)
   (:shadow #:variable))
 
 ;;;; NOTE: Some methods in this file must be compiled with cleavir,
@@ -185,18 +186,84 @@
   ;; TODO: aokp check blabla
   (values))
 
+;;; Tiering.
+;;; When *TIER-UP-THRESHOLD* is an integer, a closure made from a
+;;; FUNCTION-AST with no free variables counts its calls. The call that
+;;; reaches the threshold passes the AST and the closure itself to the
+;;; *TIER-UP-HOOK* that was current when the closure was made, which
+;;; should arrange for it to be compiled and return a cons. Once the car
+;;; of that cons is a function, calls go to it instead of the
+;;; interpreter. The hook may also replace the closure as the global
+;;; definition, in which case this only matters to callers that kept
+;;; the closure itself. The count is atomic, so
+;;; only one call reaches the threshold even if the closure is called
+;;; from several threads.
+(defvar *tier-up-threshold* nil)
+(defvar *tier-up-hook* nil)
+
+;;; Can FUNCTION-AST be compiled without the interpreter's environment?
+(defun closed-function-ast-p (function-ast)
+  (let ((inside (make-hash-table :test #'eq))
+        (needed nil))
+    (flet ((bind-lambda-list (lambda-list)
+             (dolist (item lambda-list)
+               (if (consp item)
+                   (dolist (var item) (setf (gethash var inside) t))
+                   (setf (gethash item inside) t)))))
+      (cleavir-ast:map-ast-depth-first-preorder
+       (lambda (ast)
+         (typecase ast
+           ((or cleavir-ast:block-ast cleavir-ast:tag-ast)
+            (setf (gethash ast inside) t))
+           (cleavir-ast:function-ast
+            (bind-lambda-list (cleavir-ast:lambda-list ast)))
+           (cc-ast:bind-va-list-ast
+            (bind-lambda-list (cleavir-ast:lambda-list ast)))
+           (cleavir-ast:lexical-bind-ast
+            (setf (gethash (cleavir-ast:lexical-variable ast) inside) t))
+           ((or cleavir-ast:lexical-ast cleavir-ast:setq-ast)
+            (push (cleavir-ast:lexical-variable ast) needed))
+           (cleavir-ast:multiple-value-setq-ast
+            (setf needed (append (cleavir-ast:lexical-variables ast) needed)))
+           (cleavir-ast:return-from-ast
+            (push (cleavir-ast:block-ast ast) needed))
+           (cleavir-ast:go-ast
+            (push (cleavir-ast:tag-ast ast) needed))))
+       function-ast))
+    (every (lambda (thing) (gethash thing inside)) needed)))
+
 (defcan cleavir-ast:function-ast)
 (defmethod interpret-ast ((ast cleavir-ast:function-ast) env)
   (let ((body (cleavir-ast:body-ast ast))
-        (ll (cleavir-ast:lambda-list ast)))
+        (ll (cleavir-ast:lambda-list ast))
+        (threshold (and *tier-up-threshold* *tier-up-hook*
+                        (closed-function-ast-p ast)
+                        *tier-up-threshold*))
+        ;; The closure may be called from other threads, which don't
+        ;; see our bindings.
+        (hook *tier-up-hook*)
+        ;; The car of each is updated atomically.
+        (calls (list 0))
+        (compiled (list nil))
+        (closure nil))
     (multiple-value-bind (required optional rest va-rest-p keyp key aok-p)
         (parse-lambda-list ll)
-      (lambda (core:&va-rest arguments)
-        (declare (core:lambda-name ast-interpreted-closure))
-        (bind-list arguments env
-                   required optional rest va-rest-p keyp key aok-p)
-        ;; ok body now
-        (interpret-ast body env)))))
+      (setf closure
+            (lambda (core:&va-rest arguments)
+              (declare (core:lambda-name ast-interpreted-closure))
+              (let* ((cell (mp:atomic (car compiled)))
+                     (function (and cell (mp:atomic (car cell)))))
+                (cond (function (apply function arguments))
+                      (t
+                       (when (and threshold (null cell)
+                                  (= (mp:atomic-incf (car calls)) threshold))
+                         (setf (mp:atomic (car compiled))
+                               (funcall hook ast closure)))
+                       (bind-list arguments env
+                                  required optional rest va-rest-p keyp key aok-p)
+                       ;; ok body now
+                       (interpret-ast body env)))))))
+    closure))
 
 (defcan cleavir-ast:progn-ast)
 (defmethod interpret-ast ((ast cleavir-ast:progn-ast) env)
@@ -293,14 +360,14 @@
   (eval (cleavir-ast:form ast)))
 
 ;; Turns out the AST interpreter is much slower once we start
-;; introducing more complex expressions like this....
-#+(or)
-(progn
-  (defcan cleavir-ast:if-ast)
-  (defmethod interpret-ast ((ast cleavir-ast:if-ast) env)
-    (if (interpret-boolean-ast (cleavir-ast:test-ast ast) env)
-        (interpret-ast (cleavir-ast:then-ast ast) env)
-        (interpret-ast (cleavir-ast:else-ast ast) env))))
+;; introducing more complex expressions like this, so we only do it
+;; when hot functions are going to be compiled anyway.
+(defmethod can-interpret-p ((ast cleavir-ast:if-ast))
+  (and *tier-up-threshold* *tier-up-hook* t))
+(defmethod interpret-ast ((ast cleavir-ast:if-ast) env)
+  (if (interpret-boolean-ast (cleavir-ast:test-ast ast) env)
+      (interpret-ast (cleavir-ast:then-ast ast) env)
+      (interpret-ast (cleavir-ast:else-ast ast) env)))
 
 (defcan cleavir-ast:multiple-value-call-ast)
 (defmethod interpret-ast ((ast cleavir-ast:multiple-value-call-ast) env)
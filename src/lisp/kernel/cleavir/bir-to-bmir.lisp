@@ -99,3 +99,198 @@
 
 (defun reduce-module-primops (module)
   (cleavir-set:mapset nil #'reduce-primops (bir:functions module)))
+
+;;; Representation selection.
+;;; All BIR data are boxed objects. The primops in *UNBOXED-PRIMOPS* work
+;;; on unboxed double-floats and 64 bit integers instead, so their outputs
+;;; get that rtype. Phis, THEs and local variables get it too when all of
+;;; their incoming data agree (constants of the right type agree with
+;;; anything), so loop variables stay in registers. Finally casts are
+;;; inserted wherever a datum meets a use that wants another rtype, which
+;;; means boxing only happens where a value escapes.
+
+(defparameter *unboxed-primops*
+  ;; (name output-rtypes input-rtypes)
+  '((core::double-float-add (:double-float) (:double-float :double-float))
+    (core::double-float-sub (:double-float) (:double-float :double-float))
+    (core::double-float-mul (:double-float) (:double-float :double-float))
+    (core::double-float-div (:double-float) (:double-float :double-float))
+    (core::double-float-vref (:double-float) (:object :object))
+    (core::double-float-vset () (:double-float :object :object))
+    (core::ub64-logand (:ub64) (:ub64 :ub64))
+    (core::ub64-logior (:ub64) (:ub64 :ub64))
+    (core::ub64-logxor (:ub64) (:ub64 :ub64))
+    (core::ub64-vref (:ub64) (:object :object))
+    (core::ub64-vset () (:ub64 :object :object))
+    (core::sb64-vref (:sb64) (:object :object))
+    (core::sb64-vset () (:sb64 :object :object))))
+
+(defun unboxed-rtype-p (rtype)
+  (member rtype '(:double-float :ub64 :sb64)))
+
+(defun rtype-lisp-type (rtype)
+  (ecase rtype
+    ((:double-float) 'double-float)
+    ((:ub64) 'ext:byte64)
+    ((:sb64) 'ext:integer64)))
+
+(defun unboxed-primop-info (instruction)
+  (and (typep instruction '(or bir:primop bir:vprimop))
+       (rest (assoc (cleavir-primop-info:name (bir:info instruction))
+                    *unboxed-primops*))))
+
+(defun map-module-instructions (function module)
+  (bir:do-functions (bir-function module)
+    (bir:map-local-instructions function bir-function)))
+
+;;; Lattice values are :TOP (nothing known yet), an unboxed rtype, a list
+;;; of the unboxed rtypes a constant could have, or :OBJECT.
+(defun meet-rtypes (a b)
+  (cond ((eq a :top) b)
+        ((eq b :top) a)
+        ((or (eq a :object) (eq b :object)) :object)
+        ((and (listp a) (listp b)) (or (intersection a b) :object))
+        ((listp a) (if (member b a) b :object))
+        ((listp b) (if (member a b) a :object))
+        ((eq a b) a)
+        (t :object)))
+
+(defun constant-rtypes (datum)
+  (let ((definition (and (typep datum 'bir:output) (bir:definition datum))))
+    (if (typep definition 'bir:constant-reference)
+        (let ((value (bir:constant-value (first (bir:inputs definition)))))
+          (or (loop for rtype in '(:double-float :ub64 :sb64)
+                    when (typep value (rtype-lisp-type rtype))
+                      collect rtype)
+              :object))
+        :object)))
+
+(defun select-module-representations (module)
+  (let (;; phi, THE output or variable -> list of incoming data
+        (incoming (make-hash-table :test #'eq))
+        ;; data and variables that must stay boxed
+        (opaque (make-hash-table :test #'eq))
+        ;; variables bound by a LETI
+        (binders (make-hash-table :test #'eq))
+        ;; readvar output -> variable
+        (reads (make-hash-table :test #'eq))
+        (lattice (make-hash-table :test #'eq)))
+    ;; Seed the unboxed primops and collect what flows into what.
+    (map-module-instructions
+     (lambda (instruction)
+       (let ((info (unboxed-primop-info instruction)))
+         (cond
+           (info
+            (loop for output in (bir:outputs instruction)
+                  for rtype in (first info)
+                  do (reinitialize-instance output :rtype rtype)))
+           ((typep instruction 'bir:jump)
+            (loop for input in (bir:inputs instruction)
+                  for phi in (bir:outputs instruction)
+                  do (push input (gethash phi incoming))))
+           ((typep instruction 'bir:thei)
+            (push (first (bir:inputs instruction))
+                  (gethash (first (bir:outputs instruction)) incoming)))
+           ((typep instruction 'bir:writevar)
+            (let ((variable (first (bir:outputs instruction))))
+              (when (typep instruction 'bir:leti)
+                (setf (gethash variable binders) t))
+              ;; Closed over variables live in cells, which hold objects.
+              (unless (eq (bir:extent variable) :local)
+                (setf (gethash variable opaque) t))
+              (push (first (bir:inputs instruction))
+                    (gethash variable incoming))))
+           ((typep instruction 'bir:readvar)
+            (let ((variable (first (bir:inputs instruction))))
+              (setf (gethash (first (bir:outputs instruction)) reads)
+                    variable)))
+           (t
+            ;; Phis defined by anything but a local jump (e.g. a nonlocal
+            ;; exit) stay boxed.
+            (dolist (output (bir:outputs instruction))
+              (when (typep output 'bir:phi)
+                (setf (gethash output opaque) t)))))))
+     module)
+    ;; Variables without a LETI are bound by a lambda list.
+    (maphash (lambda (variable data)
+               (declare (ignore data))
+               (when (and (typep variable 'bir:variable)
+                          (not (gethash variable binders)))
+                 (setf (gethash variable opaque) t)))
+             incoming)
+    (maphash (lambda (datum data)
+               (declare (ignore data))
+               (unless (gethash datum opaque)
+                 (setf (gethash datum lattice) :top)))
+             incoming)
+    ;; Optimistic fixpoint, so that loops can stay unboxed.
+    (flet ((datum-value (datum)
+             (let ((variable (gethash datum reads)))
+               (cond (variable (gethash variable lattice :object))
+                     ((nth-value 1 (gethash datum lattice))
+                      (gethash datum lattice))
+                     ((unboxed-rtype-p (cc-bmir:rtype datum))
+                      (cc-bmir:rtype datum))
+                     (t (constant-rtypes datum))))))
+      (loop for changed = nil
+            do (maphash (lambda (datum old)
+                          (let ((new (reduce #'meet-rtypes
+                                             (gethash datum incoming)
+                                             :key #'datum-value
+                                             :initial-value :top)))
+                            (unless (equal new old)
+                              (setf (gethash datum lattice) new
+                                    changed t))))
+                        lattice)
+            while changed))
+    (let ((variable-rtypes (make-hash-table :test #'eq)))
+      (maphash (lambda (datum value)
+                 (when (unboxed-rtype-p value)
+                   (if (typep datum 'bir:variable)
+                       (setf (gethash datum variable-rtypes) value)
+                       (reinitialize-instance datum :rtype value))))
+               lattice)
+      (maphash (lambda (output variable)
+                 (let ((rtype (gethash variable variable-rtypes)))
+                   (when rtype
+                     (reinitialize-instance output :rtype rtype))))
+               reads)
+      (insert-casts module variable-rtypes))))
+
+(defun wanted-input-rtypes (instruction variable-rtypes)
+  (let ((info (unboxed-primop-info instruction)))
+    (cond (info (second info))
+          ((typep instruction 'bir:writevar)
+           (list (gethash (first (bir:outputs instruction)) variable-rtypes
+                          :object)))
+          ((typep instruction 'bir:jump)
+           (mapcar #'cc-bmir:rtype (bir:outputs instruction)))
+          ((typep instruction 'bir:thei)
+           (list (cc-bmir:rtype (first (bir:outputs instruction)))))
+          (t nil))))
+
+(defun insert-cast (instruction index datum rtype)
+  (let ((new (make-instance 'bir:output :rtype rtype))
+        (inputs (copy-list (bir:inputs instruction))))
+    (setf (nth index inputs) new
+          (bir:inputs instruction) inputs)
+    (bir:insert-instruction-before
+     (make-instance 'cc-bmir:cast :inputs (list datum) :outputs (list new))
+     instruction)))
+
+(defun insert-casts (module variable-rtypes)
+  (let ((casts '()))
+    (map-module-instructions
+     (lambda (instruction)
+       (loop with wanted = (wanted-input-rtypes instruction variable-rtypes)
+             for input in (bir:inputs instruction)
+             for index from 0
+             for want = (or (nth index wanted) :object)
+             for have = (cc-bmir:rtype input)
+             when (and (not (eq want have))
+                       (or (unboxed-rtype-p want) (unboxed-rtype-p have)))
+               do (push (list instruction index input want) casts)))
+     module)
+    ;; Insert after walking so the walk doesn't see the casts.
+    (loop for (instruction index input want) in casts
+          do (insert-cast instruction index input want))))
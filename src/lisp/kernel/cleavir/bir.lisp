@@ -359,7 +359,25 @@
   (defprimop core:rack-set (:object :object :object) ())
 
   (defprimop core:vaslist-pop (:object) (:object))
-  (defprimop core:vaslist-length (:object) (:object)))
+  (defprimop core:vaslist-length (:object) (:object))
+
+  ;; These are introduced by transforms (see transform.lisp) and work on
+  ;; unboxed values once representation selection has run
+  ;; (see cc-bir-to-bmir:select-module-representations).
+  (defprimop core::double-float-add (:object :object) (:object))
+  (defprimop core::double-float-sub (:object :object) (:object))
+  (defprimop core::double-float-mul (:object :object) (:object))
+  (defprimop core::double-float-div (:object :object) (:object))
+  (defprimop core::double-float-vref (:object :object) (:object))
+  (defprimop core::double-float-vset (:object :object :object) ())
+
+  (defprimop core::ub64-logand (:object :object) (:object))
+  (defprimop core::ub64-logior (:object :object) (:object))
+  (defprimop core::ub64-logxor (:object :object) (:object))
+  (defprimop core::ub64-vref (:object :object) (:object))
+  (defprimop core::ub64-vset (:object :object :object) ())
+  (defprimop core::sb64-vref (:object :object) (:object))
+  (defprimop core::sb64-vset (:object :object :object) ()))
 
 (macrolet ((defprimop (name (&rest in) (&rest out) ast &rest readers)
              `(progn
@@ -21,3 +21,21 @@
 
 (defclass cas (cc-bir:atomic cleavir-bir:one-output cleavir-bir:instruction)
   ())
+
+;;; Representation selection (see bir-to-bmir.lisp) gives data the rtype
+;;; :double-float, :ub64 or :sb64 when they can be kept unboxed.
+;;; A CAST converts its input to the rtype of its output.
+(defclass cast (cleavir-bir:one-input cleavir-bir:one-output
+                cleavir-bir:instruction)
+  ())
+
+(defun rtype (datum)
+  (if (typep datum '(or cleavir-bir:output cleavir-bir:phi))
+      (cleavir-bir:rtype datum)
+      :object))
+
+;;; A list made in the current frame, because escape analysis
+;;; (see escape.lisp) showed it does not outlive it. The inputs are the
+;;; elements, or with STARP, the elements and then the final tail.
+(defclass dx-list (cleavir-bir:one-output cleavir-bir:instruction)
+  ((%starp :initarg :starp :reader starp)))
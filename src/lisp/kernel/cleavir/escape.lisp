@@ -0,0 +1,164 @@
+(in-package #:cc-bir-to-bmir)
+
+;;; Escape analysis for lists.
+;;; Cleavir already decides the extent of closures and closure cells
+;;; (see determine-closure-extents and determine-variable-extents).
+;;; Here we do the same for &rest lists and for fresh lists made by
+;;; calls to LIST, LIST* and CONS: if nothing derived from the list can
+;;; outlive the frame that made it, it can be allocated on the stack.
+;;; A list "escapes" if it, or a tail of it, reaches anything but the
+;;; uses below. Elements (CARs) are not the list's storage, so they may
+;;; go anywhere.
+
+;;; Functions that only look at the list or its elements.
+(defparameter *list-reading-functions*
+  '(car first second third fourth fifth nth length list-length
+    endp null consp listp atom eq eql equal equalp assoc
+    copy-list reverse values-list core:cons-length
+    mapcar every some notany notevery position count))
+
+;;; Functions that can return some of their arguments, such as the
+;;; default of GETF, the item FIND found or the :INITIAL-VALUE of
+;;; REDUCE. A list is only safe as the arguments listed here, counting
+;;; from 1.
+(defparameter *list-reading-argument-positions*
+  '((getf 1) (find 2) (reduce 2)))
+
+;;; Functions that return a tail of the list.
+(defparameter *list-tail-functions*
+  '(cdr rest cddr nthcdr last member mapc))
+
+;;; Functions that spread their last argument into arguments, which a
+;;; callee with a &rest parameter conses up afresh.
+(defparameter *list-spreading-functions*
+  '(core:apply0 core:apply1 core:apply2 core:apply3 core:apply4))
+
+(defun call-function-name (call)
+  ;; If CALL is a call to a global function, return its name.
+  (let* ((callee (first (bir:inputs call)))
+         (fdef (and (typep callee 'bir:output) (bir:definition callee))))
+    (when (and (typep fdef 'bir:vprimop)
+               (eq (cleavir-primop-info:name (bir:info fdef)) 'fdefinition))
+      (let* ((name (first (bir:inputs fdef)))
+             (ref (and (typep name 'bir:output) (bir:definition name))))
+        (when (typep ref 'bir:constant-reference)
+          (let ((value (bir:constant-value (first (bir:inputs ref)))))
+            (and (symbolp value) value)))))))
+
+(defun function-uses (function)
+  ;; Return two hash tables: datum -> list of (instruction . input index),
+  ;; and variable -> list of readvar outputs.
+  (let ((uses (make-hash-table :test #'eq))
+        (reads (make-hash-table :test #'eq)))
+    (bir:map-local-instructions
+     (lambda (instruction)
+       (loop for input in (bir:inputs instruction)
+             for index from 0
+             do (push (cons instruction index) (gethash input uses)))
+       (when (typep instruction 'bir:readvar)
+         (push (first (bir:outputs instruction))
+               (gethash (first (bir:inputs instruction)) reads))))
+     function)
+    (values uses reads)))
+
+;;; Does the list DATUM escape? USES and READS are from FUNCTION-USES.
+;;; If LOOP-CARRY-P is false, the list must also not flow around a loop,
+;;; since then it could outlive the storage of a list made at the same
+;;; program point on a later iteration.
+(defun list-escapes-p (datum uses reads loop-carry-p)
+  (let ((seen (make-hash-table :test #'eq))
+        (worklist (list datum))
+        (cdr-offset (- cmp:+cons-cdr-offset+ cmp:+cons-tag+)))
+    (flet ((derive (datum)
+             (unless (gethash datum seen)
+               (setf (gethash datum seen) t)
+               (push datum worklist))))
+      (loop for datum = (pop worklist)
+            while datum
+            do (loop for (instruction . index) in (gethash datum uses)
+                     do (typecase instruction
+                          ((or bir:conditional-test bir:ifi))
+                          (bir:thei (derive (first (bir:outputs instruction))))
+                          (bir:multiple-to-fixed
+                           (let ((primary (first (bir:outputs instruction))))
+                             (when primary (derive primary))))
+                          (bir:writevar
+                           (let ((variable (first (bir:outputs instruction))))
+                             (unless (and (eq (bir:extent variable) :local)
+                                          (or loop-carry-p
+                                              (bir:immutablep variable)))
+                               (return-from list-escapes-p t))
+                             (mapc #'derive (gethash variable reads))))
+                          (bir:jump
+                           (if loop-carry-p
+                               (derive (nth index (bir:outputs instruction)))
+                               (return-from list-escapes-p t)))
+                          (cc-bmir:memref2
+                           ;; CAR or CDR (or RPLACA/RPLACD, which only
+                           ;; store into the list).
+                           (let ((address (first (bir:outputs instruction))))
+                             (loop for (use . use-index) in (gethash address uses)
+                                   do (typecase use
+                                        (cc-bmir:load
+                                         (when (= (cc-bmir:offset instruction)
+                                                  cdr-offset)
+                                           (derive (first (bir:outputs use)))))
+                                        (cc-bmir:store
+                                         (unless (= use-index 1)
+                                           (return-from list-escapes-p t)))
+                                        (t (return-from list-escapes-p t))))))
+                          (bir:call
+                           (let ((name (call-function-name instruction))
+                                 (nargs (length (rest (bir:inputs instruction)))))
+                             (cond ((zerop index)
+                                    (return-from list-escapes-p t))
+                                   ((member name *list-reading-functions*))
+                                   ((member index
+                                            (rest (assoc name *list-reading-argument-positions*))))
+                                   ((member name *list-tail-functions*)
+                                    (derive (first (bir:outputs instruction))))
+                                   ((and (member name *list-spreading-functions*)
+                                         (= index nargs)
+                                         (> index 1)))
+                                   (t (return-from list-escapes-p t)))))
+                          (t (return-from list-escapes-p t)))))
+      nil)))
+
+;;; Return DYNAMIC-EXTENT if FUNCTION's &rest list can live in the frame
+;;; of whatever builds it (the XEP, or the caller of a local call), or
+;;; IGNORE if it is not used at all, or NIL.
+(defun rest-alloc (function)
+  (multiple-value-bind (req opt rest-var key-flag keys aok aux varest-p)
+      (cmp::process-cleavir-lambda-list (bir:lambda-list function))
+    (declare (ignore req opt keys aok aux))
+    (cond ((or (null rest-var) varest-p) nil)
+          ((bir:unused-p rest-var) 'ignore)
+          ;; Keyword parsing reads the same arguments; keep it simple.
+          (key-flag nil)
+          ((multiple-value-bind (uses reads) (function-uses function)
+             (list-escapes-p rest-var uses reads t))
+           nil)
+          (t 'dynamic-extent))))
+
+;;; Turn calls to LIST, LIST* and CONS whose result does not escape into
+;;; DX-LIST instructions.
+(defun stack-allocate-local-lists (function)
+  (multiple-value-bind (uses reads) (function-uses function)
+    (bir:map-local-instructions
+     (lambda (instruction)
+       (when (typep instruction 'bir:call)
+         (let ((name (call-function-name instruction))
+               (args (rest (bir:inputs instruction))))
+           (when (and (member name '(list list* cons))
+                      args
+                      (or (eq name 'list) (rest args))
+                      (not (and (eq name 'cons) (/= (length args) 2)))
+                      (not (list-escapes-p (first (bir:outputs instruction))
+                                           uses reads nil)))
+             (change-class instruction 'cc-bmir:dx-list
+                           :inputs () :starp (not (eq name 'list)))
+             (setf (bir:inputs instruction) args)))))
+     function)))
+
+(defun stack-allocate-module-lists (module)
+  (cleavir-set:mapset nil #'stack-allocate-local-lists (bir:functions module)))
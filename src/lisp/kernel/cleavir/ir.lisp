@@ -106,6 +106,13 @@
 (defun %fdiv (x y &optional (label "") fast-math-flags)
   (llvm-sys:create-fdiv cmp:*irbuilder* x y label fast-math-flags))
 
+(defun %and (x y &optional (label ""))
+  (llvm-sys:create-and-value-value cmp:*irbuilder* x y label))
+(defun %or (x y &optional (label ""))
+  (llvm-sys:create-or-value-value cmp:*irbuilder* x y label))
+(defun %xor (x y &optional (label ""))
+  (llvm-sys:create-xor-value-value cmp:*irbuilder* x y label))
+
 (defun %fcmp-olt (x y &optional (label "") fast-math-flags)
   (llvm-sys:create-fcmp-olt cmp:*irbuilder* x y label fast-math-flags))
 (defun %fcmp-ole (x y &optional (label "") fast-math-flags)
@@ -101,11 +101,16 @@
   (:use #:cl)
   (:local-nicknames (#:bir #:cleavir-bir))
   (:export #:reduce-module-typeqs)
-  (:export #:reduce-module-primops))
+  (:export #:reduce-module-primops)
+  (:export #:select-module-representations)
+  (:export #:rest-alloc #:stack-allocate-module-lists)
+  (:export #:call-function-name))
 
 (defpackage #:clasp-cleavir-bmir
   (:nicknames #:cc-bmir)
   (:shadow #:characterp #:consp #:load)
   (:export #:fixnump #:characterp #:consp #:single-float-p #:generalp
            #:headerq #:info)
-  (:export #:memref2 #:offset #:load #:store #:cas))
+  (:export #:memref2 #:offset #:load #:store #:cas)
+  (:export #:cast #:rtype)
+  (:export #:dx-list #:starp))
@@ -31,7 +31,9 @@
     (do-type-inference boolean t)
     (do-dx-analysis boolean t)
     (type-check-ftype-arguments boolean t)
-    (type-check-ftype-return-values boolean t)))
+    (type-check-ftype-return-values boolean t)
+    (direct-calls boolean nil)
+    (call-site-caches boolean nil)))
 ;;; FIXME: Can't just punt like normal since it's an APPEND method combo.
 (defmethod cleavir-policy:policy-qualities append ((env null))
   '((save-register-args boolean t)
@@ -41,7 +43,9 @@
     (do-type-inference boolean t)
     (do-dx-analysis boolean t)
     (type-check-ftype-arguments boolean t)
-    (type-check-ftype-return-values boolean t)))
+    (type-check-ftype-return-values boolean t)
+    (direct-calls boolean nil)
+    (call-site-caches boolean nil)))
 
 ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 ;;;
@@ -117,8 +121,45 @@
     (and (zerop safety)
          (> (cleavir-policy:optimize-value optimize 'speed) safety))))
 
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;
+;;; Policy DIRECT-CALLS
+;;;
+;;; When file compiling, may calls to functions DEFUNed earlier in
+;;; the file jump straight to the callee's internal entry point?
+;;; See *DIRECT-CALL-TARGETS* in translate.lisp. This is allowed
+;;; by CLHS 3.2.2.3, but it means redefining or tracing the callee
+;;; later does not affect these callers, so only do it when speed
+;;; matters more than debuggability.
+
+(defmethod cleavir-policy:compute-policy-quality
+    ((quality (eql 'direct-calls))
+     optimize
+     (environment clasp-global-environment))
+  (> (cleavir-policy:optimize-value optimize 'speed)
+     (cleavir-policy:optimize-value optimize 'debug)))
+
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;
+;;; Policy CALL-SITE-CACHES
+;;;
+;;; Should calls to generic functions check a cache of their own
+;;; before calling the generic function? See clos/call-site-cache.lisp.
+;;; The check is inlined at every call, so only do it when speed
+;;; matters more than code size.
+
+(defmethod cleavir-policy:compute-policy-quality
+    ((quality (eql 'call-site-caches))
+     optimize
+     (environment clasp-global-environment))
+  (> (cleavir-policy:optimize-value optimize 'speed)
+     (cleavir-policy:optimize-value optimize 'space)))
+
 ;;;
 
 (defun environment-has-policy-p (environment quality)
   (cleavir-policy:policy-value
    (cleavir-env:policy (cleavir-env:optimize-info environment)) quality))
+
+(defun call-site-caches-p (environment)
+  (environment-has-policy-p environment 'call-site-caches))
@@ -225,7 +225,10 @@
        (make-instance 'env:global-function-info
          :name function-name
          :type (global-ftype function-name)
-         :compiler-macro (compiler-macro-function function-name)
+         :compiler-macro (or (compiler-macro-function function-name)
+                             (clos::sealed-generic-function-compiler-macro function-name)
+                             (clos::call-site-cache-compiler-macro
+                              function-name #'call-site-caches-p))
          :inline inline-status
          :ast cleavir-ast
          :attributes attr
@@ -0,0 +1,64 @@
+(in-package :clasp-cleavir)
+
+;;; Tiered evaluation.
+;;; When INTERPRET-AST:*TIER-UP-THRESHOLD* is an integer, EVAL in the
+;;; null lexical environment interprets what the AST interpreter can
+;;; handle instead of compiling it first. Interpreted functions that are
+;;; called that many times are compiled by a background thread, so EVAL
+;;; never waits for LLVM.
+;;; When the compiled function is ready it goes in the car of the cell
+;;; TIER-UP returns, and the interpreted closure forwards to it (see the
+;;; FUNCTION-AST method in ast-interpreter.lisp). If the function is
+;;; named and its global definition is still the interpreted closure,
+;;; the compiled function is also swapped into the function cell with a
+;;; CAS, so later calls skip the closure entirely. A redefinition made
+;;; meanwhile makes the CAS fail and is left alone.
+;;; If compiling fails, the condition goes in the cdr of the cell and
+;;; the function stays interpreted.
+;;; This is loaded after mp-queue.lsp, which it needs.
+
+(defvar *tier-up-queue* nil)
+(defvar *tier-up-lock* (mp:make-lock :name "tier-up"))
+
+(defun install-tiered-function (name interpreted compiled)
+  (cond ((and (symbolp name) (fboundp name))
+         (core:cas-symbol-function interpreted compiled name))
+        ((and (consp name) (eq (first name) 'setf)
+              (symbolp (second name)) (null (cddr name))
+              (fboundp name))
+         (core:cas-setf-fdefinition interpreted compiled (second name)))))
+
+(defun tier-up-loop (queue)
+  (loop for (ast interpreted . cell) = (mp:dequeue queue)
+        do (handler-case
+               (let ((function
+                       (handler-bind ((warning #'muffle-warning))
+                         (cclasp-eval-with-env `(cleavir-primop:ast ,ast) nil))))
+                 (cond ((functionp function)
+                        (setf (mp:atomic (car cell)) function)
+                        (install-tiered-function (cleavir-ast:name ast)
+                                                 interpreted function))
+                       (t (setf (cdr cell) function))))
+             (error (condition)
+               (setf (cdr cell) condition)))))
+
+(defun tier-up-queue ()
+  (mp:with-lock (*tier-up-lock*)
+    (or *tier-up-queue*
+        (let ((queue (mp:make-queue :name 'tier-up)))
+          (mp:process-run-function "tier-up-compiler"
+                                   (lambda () (tier-up-loop queue))
+                                   nil)
+          (setf *tier-up-queue* queue)))))
+
+(defun tier-up (function-ast interpreted)
+  (let ((cell (list nil)))
+    (mp:enqueue (tier-up-queue) (list* function-ast interpreted cell))
+    cell))
+
+(setf interpret-ast:*tier-up-hook* 'tier-up)
+
+(defun tiered-eval-with-env (form env)
+  (if (null env)
+      (ast-interpret-cst (cst:cst-from-expression form) *clasp-env*)
+      (cclasp-eval-with-env form env)))
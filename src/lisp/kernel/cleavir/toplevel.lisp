@@ -211,4 +211,6 @@
   (cclasp-eval-with-env form (core:get-parent-environment env)))
 
 (defun cclasp-eval (form &optional env)
-  (simple-eval form env #'cclasp-eval-with-env))
+  (simple-eval form env (if interpret-ast:*tier-up-threshold*
+                            'tiered-eval-with-env
+                            #'cclasp-eval-with-env)))
@@ -129,7 +129,9 @@
         (loop
           (multiple-value-bind (present types transformer) (next)
             (if present
-                (when (every (lambda (at ty) (subtypep at ty env)) argtypes types)
+                (when (and (= (length argtypes) (length types))
+                           (every (lambda (at ty) (subtypep at ty env))
+                                  argtypes types))
                   (let ((res (apply transformer args)))
                     (when res (return `(,res ,@args)))))
                 (return form))))))))
@@ -226,6 +228,58 @@
 (deftransform plusp ((number fixnum))
   '(lambda (n) (if (cleavir-primop:fixnum-greater n 0) t nil)))
 
+;;; These primops are translated to unboxed arithmetic and memory accesses,
+;;; with boxing inserted only where the values escape.
+(deftransform core:two-arg-+ ((x double-float) (y double-float))
+  'core::double-float-add)
+(deftransform core:two-arg-- ((x double-float) (y double-float))
+  'core::double-float-sub)
+(deftransform core:two-arg-* ((x double-float) (y double-float))
+  'core::double-float-mul)
+(deftransform core:two-arg-/ ((x double-float) (y double-float))
+  'core::double-float-div)
+
+(deftransform core:logand-2op ((x ext:byte64) (y ext:byte64))
+  'core::ub64-logand)
+(deftransform core:logior-2op ((x ext:byte64) (y ext:byte64))
+  'core::ub64-logior)
+(deftransform core:logxor-2op ((x ext:byte64) (y ext:byte64))
+  'core::ub64-logxor)
+
+;;; The vref/vset primops don't check the index, so the transforms below
+;;; put in a check wherever the policy asks for bounds checks. The lambda
+;;; they return is converted at the call site, so this sees its policy.
+(defmacro vector-bounds-check (vector index &environment env)
+  (if (environment-has-policy-p env 'core::insert-array-bounds-checks)
+      `(core:check-index ,index (core::vector-length ,vector) 0)
+      nil))
+
+(macrolet ((def-unboxed-vector-access (element-type ref set)
+             `(progn
+                (deftransform row-major-aref
+                    ((a (simple-array ,element-type (*))) (index fixnum))
+                  '(lambda (a index)
+                    (vector-bounds-check a index)
+                    (,ref a index)))
+                (deftransform core:row-major-aset
+                    ((a (simple-array ,element-type (*))) (index fixnum)
+                     (value ,element-type))
+                  '(lambda (a index value)
+                    (vector-bounds-check a index)
+                    (,set value a index)
+                    value))
+                (deftransform (setf aref)
+                    ((value ,element-type) (a (simple-array ,element-type (*)))
+                     (index fixnum))
+                  '(lambda (value a index)
+                    (vector-bounds-check a index)
+                    (,set value a index)
+                    value)))))
+  (def-unboxed-vector-access double-float
+    core::double-float-vref core::double-float-vset)
+  (def-unboxed-vector-access ext:byte64 core::ub64-vref core::ub64-vset)
+  (def-unboxed-vector-access ext:integer64 core::sb64-vref core::sb64-vset))
+
 (deftransform array-total-size ((a (simple-array * (*)))) 'core::vector-length)
 ;;(deftransform array-total-size ((a core:mdarray)) 'core::%array-total-size)
 
@@ -12,7 +12,9 @@
    (%xep-function :initarg :xep-function :reader xep-function)
    (%xep-function-description :initarg :xep-function-description :reader xep-function-description)
    (%main-function :initarg :main-function :reader main-function)
-   (%main-function-description :initarg :main-function-description :reader main-function-description)))
+   (%main-function-description :initarg :main-function-description :reader main-function-description)
+   ;; How the &rest list is allocated; see cc-bir-to-bmir:rest-alloc.
+   (%rest-alloc :initarg :rest-alloc :reader rest-alloc)))
 
 (defun lambda-list-too-hairy-p (lambda-list)
   (multiple-value-bind (reqargs optargs rest-var
@@ -82,6 +84,7 @@
           :main-function-description function-description
           :xep-function xep-function
           :xep-function-description xep-function-description
+          :rest-alloc (cc-bir-to-bmir:rest-alloc function)
           :arguments arguments)))))
 
 ;;; Return value is unspecified/irrelevant.
@@ -450,7 +453,8 @@
 ;; LETI is a subclass of WRITEVAR, so we use a :before to bind the var.
 (defmethod translate-simple-instruction :before ((instruction bir:leti) abi)
   (declare (ignore abi))
-  (bind-variable (first (bir:outputs instruction))))
+  (bind-variable (first (bir:outputs instruction))
+                 (cc-bmir:rtype (first (bir:inputs instruction)))))
 
 (defmethod translate-simple-instruction ((instruction bir:writevar)
                                          abi)
@@ -465,17 +469,88 @@
 
 (defun gen-rest-list (present-arguments)
   ;; Generate a call to cc_list.
-  ;; TODO: DX &rest lists.
   (%intrinsic-invoke-if-landing-pad-or-call
    "cc_list" (list* (%size_t (length present-arguments))
                     (mapcar #'in present-arguments))))
 
+;;; Build a list of ELEMENTS ending in TAIL in conses allocated in the
+;;; function's frame. Each call site gets its own storage, so the caller
+;;; must know the list is dead before the site is reached again.
+(defun gen-dx-list (elements &optional (tail (%nil)))
+  (if (null elements)
+      tail
+      (let* ((nconses (length elements))
+             (storage (cmp:alloca cmp::%cons% nconses "dx-list"))
+             (conses
+               (loop for i below nconses
+                     collect (cmp:irc-bit-cast
+                              (cmp:irc-gep
+                               (cmp:irc-bit-cast (cmp:irc-gep storage (list i))
+                                                 cmp:%i8*%)
+                               (list cmp:+cons-tag+))
+                              cmp:%t*%))))
+        (llvm-sys:set-alignment storage cmp:+alignment+)
+        (loop for (cons . more) on conses
+              for element in elements
+              do (cmp:irc-store element
+                                (cmp::gen-memref-address
+                                 cons (- cmp:+cons-car-offset+ cmp:+cons-tag+)))
+                 (cmp:irc-store (if more (first more) tail)
+                                (cmp::gen-memref-address
+                                 cons (- cmp:+cons-cdr-offset+ cmp:+cons-tag+))))
+        (first conses))))
+
+(defmethod translate-simple-instruction ((inst cc-bmir:dx-list) abi)
+  (declare (ignore abi))
+  (let* ((inputs (mapcar #'in (bir:inputs inst)))
+         (output (first (bir:outputs inst)))
+         (list (if (cc-bmir:starp inst)
+                   (gen-dx-list (butlast inputs) (first (last inputs)))
+                   (gen-dx-list inputs))))
+    ;; The instruction was a call, so its output may want all values.
+    (out (if (eq (bir:rtype output) :multiple-values)
+             (cmp:irc-make-tmv (%size_t 1) list)
+             list)
+         output)))
+
+;;; If DATUM is the output of a constant reference, return its value
+;;; and true, else NIL NIL.
+(defun constant-datum-value (datum)
+  (let ((definition (and (typep datum 'bir:output) (bir:definition datum))))
+    (if (typep definition 'bir:constant-reference)
+        (values (bir:constant-value (first (bir:inputs definition))) t)
+        (values nil nil))))
+
+;;; Can a call to CALLEE, which has &key, with ARGUMENTS be made
+;;; directly to its main function? That needs the keywords to be known
+;;; now and acceptable to CALLEE, so that nothing is left for the
+;;; runtime keyword parser to check.
+(defun keyword-call-resolvable-p (callee arguments)
+  (multiple-value-bind (req opt rest key-flag keys aok aux varest-p)
+      (cmp::process-cleavir-lambda-list (bir:lambda-list callee))
+    (declare (ignore rest aux))
+    (let ((keyargs (nthcdr (+ (car req) (car opt)) arguments)))
+      (and key-flag
+           (not varest-p)
+           (>= (length arguments) (car req))
+           (evenp (length keyargs))
+           (loop for (key) on keyargs by #'cddr
+                 always (multiple-value-bind (keyword constantp)
+                            (constant-datum-value key)
+                          (and constantp
+                               (symbolp keyword)
+                               (not (eq keyword :allow-other-keys))
+                               (or aok
+                                   (loop for (k) on (cdr keys) by #'cddddr
+                                         thereis (eq k keyword))))))))))
+
 ;; Create the argument list for a local call by parsing the callee's
 ;; lambda list and filling in the correct values at compile time. We
 ;; assume that we have already checked the validity of this call.
-(defun parse-local-call-arguments (callee present-arguments)
+(defun parse-local-call-arguments (callee present-arguments
+                                   &optional (callee-info
+                                              (find-llvm-function-info callee)))
   (let* ((lambda-list (bir:lambda-list callee))
-         (callee-info (find-llvm-function-info callee))
          (environment (environment callee-info))
          (state :required)
          (arguments '()))
@@ -494,11 +569,23 @@
                     (push (cmp:irc-undef-value-get cmp:%t*%) arguments)
                     (push (%nil) arguments))))
             (&key
-             (error "I don't know how to do this."))
+             ;; See KEYWORD-CALL-RESOLVABLE-P. The leftmost value for a
+             ;; keyword is the one used.
+             (let ((value (loop for (key value) on present-arguments by #'cddr
+                                when (eq (constant-datum-value key) (first item))
+                                  return value)))
+               (cond (value
+                      (push (in value) arguments)
+                      (push (cmp::irc-t) arguments))
+                     (t
+                      (push (cmp:irc-undef-value-get cmp:%t*%) arguments)
+                      (push (%nil) arguments)))))
             (&rest
-             (push (if (bir:unused-p item) ; unused &rest
-                       (cmp:irc-undef-value-get cmp:%t*%)
-                       (gen-rest-list present-arguments))
+             (push (cond ((bir:unused-p item) ; unused &rest
+                          (cmp:irc-undef-value-get cmp:%t*%))
+                         ((eq (rest-alloc callee-info) 'dynamic-extent)
+                          (gen-dx-list (mapcar #'in present-arguments)))
+                         (t (gen-rest-list present-arguments)))
                    arguments)))))
     ;; Augment the environment values to the arguments of the
     ;; call. Make sure to get the variable location and not
@@ -557,7 +644,8 @@
          (callee (bir:callee instruction))
          (callee-info (find-llvm-function-info callee))
          (lisp-arguments (rest (bir:inputs instruction))))
-    (cond ((lambda-list-too-hairy-p (bir:lambda-list callee))
+    (cond ((and (lambda-list-too-hairy-p (bir:lambda-list callee))
+                (not (keyword-call-resolvable-p callee lisp-arguments)))
            ;; Has &key or something, so use the normal call protocol.
            ;; We allocate a fresh closure for every call. Hopefully this
            ;; isn't too expensive. We can always use stack allocation since
@@ -581,12 +669,107 @@
              (llvm-sys:set-calling-conv result-in-registers 'llvm-sys:fastcc)
              (out result-in-registers output))))))
 
+;;; Direct calls within a file.
+;;; While file compiling, this maps the names of functions defined by
+;;; top level DEFUNs earlier in the file to (bir-function . llvm-function-info),
+;;; or :REDEFINED if there was more than one.
+;;; The whole file is one LLVM module, so as CLHS 3.2.2.3 allows, a
+;;; later call to one of these can go straight to its main function,
+;;; like a local call, skipping the function cell, the argument count
+;;; check and argument parsing. The DIRECT-CALLS policy controls this.
+(defvar *direct-call-targets*)
+
+(defun setf-fdefinition-callee-p (datum)
+  ;; Is DATUM #'(SETF FDEFINITION)?
+  (let ((definition (and (typep datum 'bir:output) (bir:definition datum))))
+    (and (typep definition 'bir:vprimop)
+         (eq (cleavir-primop-info:name (bir:info definition))
+             'cc-bir::setf-fdefinition)
+         (eq (constant-datum-value (first (bir:inputs definition))) 'fdefinition))))
+
+;;; Is FUNCTION the one that a DEFUN of NAME in TOPLEVEL, the top level
+;;; function of the module, installs? DEFUN expands into
+;;;  (funcall #'(setf fdefinition) #'(lambda ...) 'name)
+;;; so that's a call in TOPLEVEL with FUNCTION's enclose as argument.
+;;; Local functions and DEFUNs that aren't at top level don't count.
+(defun defun-installed-function-p (function name toplevel)
+  (let ((enclose (bir:enclose function)))
+    (when (and enclose toplevel (eq (bir:function enclose) toplevel))
+      (let ((closure (first (bir:outputs enclose))))
+        (bir:map-local-instructions
+         (lambda (instruction)
+           (when (typep instruction 'bir:call)
+             (let ((inputs (bir:inputs instruction)))
+               (when (and (= (length inputs) 3)
+                          (eq (second inputs) closure)
+                          (setf-fdefinition-callee-p (first inputs))
+                          (multiple-value-bind (value constantp)
+                              (constant-datum-value (third inputs))
+                            (and constantp (equal value name))))
+                 (return-from defun-installed-function-p t)))))
+         toplevel)))
+    nil))
+
+(defun maybe-register-direct-call-target (function function-info toplevel)
+  (let* ((name (bir:name function))
+         (def (and (boundp '*direct-call-targets*)
+                   (eq cst-to-ast:*compiler* 'cl:compile-file)
+                   (core:valid-function-name-p name)
+                   (cmp:known-function-p name))))
+    (when (and def
+               (eq (cmp::global-function-def-type def) 'defun)
+               (null (environment function-info))
+               ;; &key is OK; see KEYWORD-CALL-RESOLVABLE-P.
+               (not (nth-value 7 (cmp::process-cleavir-lambda-list
+                                  (bir:lambda-list function))))
+               (defun-installed-function-p function name toplevel))
+      ;; If the file defines NAME more than once, later calls can't know
+      ;; which definition they'll get, so they go through the function
+      ;; cell. The entry is never replaced by another function.
+      (setf (gethash name *direct-call-targets*)
+            (if (nth-value 1 (gethash name *direct-call-targets*))
+                :redefined
+                (cons function function-info))))))
+
+(defun direct-call-target (instruction)
+  (when (and (boundp '*direct-call-targets*)
+             (eq cst-to-ast:*compiler* 'cl:compile-file)
+             (cleavir-policy:policy-value
+              (bir:policy (bir:function (bir:iblock instruction)))
+              'direct-calls))
+    (let* ((name (cc-bir-to-bmir:call-function-name instruction))
+           (target (and name (gethash name *direct-call-targets*)))
+           (nargs (length (rest (bir:inputs instruction)))))
+      (when (and (consp target)
+                 (not (eq (core:global-inline-status name) 'notinline)))
+        (multiple-value-bind (req opt rest key-flag)
+            (cmp::process-cleavir-lambda-list (bir:lambda-list (car target)))
+          ;; With the wrong number of arguments, or keywords that need
+          ;; checking, go through the function cell so the runtime
+          ;; parser gets them.
+          (when (if key-flag
+                    (keyword-call-resolvable-p (car target)
+                                               (rest (bir:inputs instruction)))
+                    (and (>= nargs (car req))
+                         (or rest (<= nargs (+ (car req) (car opt))))))
+            target))))))
+
 (defmethod translate-simple-instruction ((instruction bir:call) abi)
   (declare (ignore abi))
   (let ((inputs (bir:inputs instruction))
-        (output (first (bir:outputs instruction))))
-    (out (closure-call-or-invoke
-          (in (first inputs)) (mapcar #'in (rest inputs)))
+        (output (first (bir:outputs instruction)))
+        (target (direct-call-target instruction)))
+    (out (if target
+             (destructuring-bind (callee . callee-info) target
+               (let ((result-in-registers
+                       (cmp::irc-call-or-invoke
+                        (main-function callee-info)
+                        (parse-local-call-arguments callee (rest inputs)
+                                                    callee-info))))
+                 (llvm-sys:set-calling-conv result-in-registers 'llvm-sys:fastcc)
+                 result-in-registers))
+             (closure-call-or-invoke
+              (in (first inputs)) (mapcar #'in (rest inputs))))
          output)))
 
 (defun general-mv-local-call (callee-info tmv)
@@ -940,6 +1123,42 @@
                     (in (second (bir:inputs inst)))
                     (in (third (bir:inputs inst)))))
 
+
+(macrolet ((def-binary-primop (name op)
+             `(defmethod translate-primop ((name (eql ',name)) inst)
+                (out (,op (in (first (bir:inputs inst)))
+                          (in (second (bir:inputs inst))))
+                     (first (bir:outputs inst))))))
+  (def-binary-primop core::double-float-add %fadd)
+  (def-binary-primop core::double-float-sub %fsub)
+  (def-binary-primop core::double-float-mul %fmul)
+  (def-binary-primop core::double-float-div %fdiv)
+  (def-binary-primop core::ub64-logand %and)
+  (def-binary-primop core::ub64-logior %or)
+  (def-binary-primop core::ub64-logxor %xor))
+
+;;; The index is a fixnum and the array is boxed; only the element is unboxed.
+(macrolet ((def-vector-access (ref set element-type)
+             `(progn
+                (defmethod translate-primop ((name (eql ',ref)) inst)
+                  (let ((inputs (bir:inputs inst)))
+                    (out (cmp:irc-load
+                          (gen-vector-effective-address
+                           (in (first inputs)) (in (second inputs))
+                           ',element-type cmp:%i64%))
+                         (first (bir:outputs inst)))))
+                (defmethod translate-primop ((name (eql ',set)) inst)
+                  (let ((inputs (bir:inputs inst)))
+                    (cmp:irc-store
+                     (in (first inputs))
+                     (gen-vector-effective-address
+                      (in (second inputs)) (in (third inputs))
+                      ',element-type cmp:%i64%)))))))
+  (def-vector-access core::double-float-vref core::double-float-vset
+    double-float)
+  (def-vector-access core::ub64-vref core::ub64-vset ext:byte64)
+  (def-vector-access core::sb64-vref core::sb64-vset ext:integer64))
+
 (defmethod translate-primop ((name cons) inst) ; FIXME
   (cond ((equal name '(setf symbol-value))
          (%intrinsic-invoke-if-landing-pad-or-call
@@ -1010,6 +1229,38 @@
           (in (first inputs)) (in (second inputs)))
          (first (bir:outputs inst)))))
 
+(defun box (value rtype)
+  (%intrinsic-invoke-if-landing-pad-or-call
+   (ecase rtype
+     ((:double-float) "to_object_double")
+     ((:ub64) "to_object_uint64")
+     ((:sb64) "to_object_int64"))
+   (list value)))
+
+(defun unbox (value rtype)
+  (%intrinsic-invoke-if-landing-pad-or-call
+   (ecase rtype
+     ((:double-float) "from_object_double")
+     ((:ub64) "from_object_uint64")
+     ((:sb64) "from_object_int64"))
+   (list value)))
+
+(defun translate-cast (value inrt outrt)
+  (cond ((eq inrt outrt) value)
+        ((eq inrt :object) (unbox value outrt))
+        ((eq outrt :object) (box value inrt))
+        ;; Between two unboxed representations, e.g. a ub64 stored into
+        ;; an sb64 vector; go through an object so range errors are caught.
+        (t (unbox (box value inrt) outrt))))
+
+(defmethod translate-simple-instruction ((inst cc-bmir:cast) abi)
+  (declare (ignore abi))
+  (let ((input (first (bir:inputs inst)))
+        (output (first (bir:outputs inst))))
+    (out (translate-cast (in input) (cc-bmir:rtype input)
+                         (cc-bmir:rtype output))
+         output)))
+
 (defun values-collect-multi (inst)
   (loop with seen-non-save = nil
         for input in (bir:inputs inst)
@@ -1153,9 +1404,7 @@
       (let ((ndefinitions (+ (cleavir-set:size (bir:predecessors iblock))
                              (cleavir-set:size (bir:entrances iblock)))))
         (loop for phi in phis
-              for llvm-type = (if (eq (bir:rtype phi) :multiple-values)
-                                  cmp::%tmv%
-                                  cmp:%t*%)
+              for llvm-type = (rtype->llvm-type (bir:rtype phi))
               do (setf (gethash phi *datum-values*)
                        (cmp:irc-phi llvm-type ndefinitions)))))))
 
@@ -1195,6 +1444,26 @@
         (string-downcase (symbol-name name))
         "iblock")))
 
+;;; Import cells from the closure and tail call the main function with
+;;; them and ARGUMENTS, as a local call would.
+(defun xep-call-main-function (the-function llvm-function-info arguments)
+  (let* ((closure-vec (first (llvm-sys:get-argument-list the-function)))
+         (environment-values
+           (loop for import in (environment llvm-function-info)
+                 for i from 0
+                 for offset = (cmp:%closure-with-slots%.offset-of[n]/t* i)
+                 collect (cmp:irc-load-atomic
+                          (cmp::gen-memref-address closure-vec offset)))))
+    (cmp:with-debug-info-source-position
+        ((core:make-source-pos-info "no-source-info-available" 999905 999905 999905))
+      (cmp:irc-ret
+       (let ((c
+               (cmp:irc-create-call
+                (main-function llvm-function-info)
+                (nconc environment-values arguments))))
+         (llvm-sys:set-calling-conv c 'llvm-sys:fastcc)
+         c)))))
+
 (defun layout-xep-function* (the-function ir calling-convention abi)
   (declare (ignore abi))
   (cmp:with-irbuilder (cmp:*irbuilder-function-alloca*)
@@ -1202,29 +1471,86 @@
     (cmp:compile-lambda-list-code (bir:lambda-list ir)
                                   calling-convention
                                   :argument-out #'out)
-    ;; Import cells.
-    (let* ((closure-vec (first (llvm-sys:get-argument-list the-function)))
-           (llvm-function-info (find-llvm-function-info ir))
-           (environment-values
-             (loop for import in (environment llvm-function-info)
-                   for i from 0
-                   for offset = (cmp:%closure-with-slots%.offset-of[n]/t* i)
-                   collect (cmp:irc-load-atomic
-                            (cmp::gen-memref-address closure-vec offset)))))
-      ;; Tail call the real function.
-      (cmp:with-debug-info-source-position
-          ((core:make-source-pos-info "no-source-info-available" 999905 999905 999905))
-        (cmp:irc-ret
-         (let ((c
-                 (cmp:irc-create-call
-                  (main-function llvm-function-info)
-                  ;; Augment the environment lexicals as a local call would.
-                  (nconc environment-values
-                         (mapcar #'in (arguments llvm-function-info))))))
-           (llvm-sys:set-calling-conv c 'llvm-sys:fastcc)
-           c)))))
+    (let ((llvm-function-info (find-llvm-function-info ir)))
+      (xep-call-main-function the-function llvm-function-info
+                              (mapcar #'in (arguments llvm-function-info)))))
   the-function)
 
+;;; Fast entries.
+;;; A lambda list with only required and optional parameters that fit
+;;; in registers is parsed straight from the registers. With &rest or
+;;; &key, though, the general parser spills the registers and walks a
+;;; va_list, which is a lot of work for a call like (format nil "x")
+;;; or (make-foo) with no keywords. For such functions, the XEP starts
+;;; by switching on the argument count. Each count that fits in
+;;; registers, and for &key passes no keyword arguments, gets its own
+;;; entry that calls the main function directly; any other count falls
+;;; through to the general parser.
+
+;;; Return the argument counts that get a fast entry.
+(defun xep-fast-arities (lambda-list)
+  (multiple-value-bind (req opt rest key-flag keys aok aux varest-p)
+      (cmp::process-cleavir-lambda-list lambda-list)
+    (declare (ignore keys aok aux))
+    (when (and (or rest key-flag) (not varest-p))
+      (let ((nreq (car req)) (nfixed (+ (car req) (car opt))))
+        (loop for nargs from nreq
+                to (min cmp::+args-in-registers+
+                        (if key-flag nfixed cmp::+args-in-registers+))
+              collect nargs)))))
+
+;;; Main function arguments for a call passing exactly REGISTERS.
+(defun xep-fast-entry-arguments (lambda-list llvm-function-info registers)
+  (let ((state :required) (arguments '()))
+    (dolist (item lambda-list)
+      (if (symbolp item)
+          (setq state item)
+          (ecase state
+            (:required (push (pop registers) arguments))
+            (&optional
+             (cond (registers
+                    (push (pop registers) arguments)
+                    (push (cmp::irc-t) arguments))
+                   (t
+                    (push (cmp:irc-undef-value-get cmp:%t*%) arguments)
+                    (push (%nil) arguments))))
+            (&rest
+             (push (cond ((bir:unused-p item)
+                          (cmp:irc-undef-value-get cmp:%t*%))
+                         ((null registers) (%nil))
+                         ((eq (rest-alloc llvm-function-info) 'dynamic-extent)
+                          (gen-dx-list registers))
+                         (t (%intrinsic-call
+                             "cc_list" (list* (%size_t (length registers))
+                                              registers))))
+                   arguments))
+            ;; Only reached with no keyword arguments passed.
+            (&key
+             (push (cmp:irc-undef-value-get cmp:%t*%) arguments)
+             (push (%nil) arguments)))))
+    (nreverse arguments)))
+
+;;; Lay out the fast entries and leave the builder in the block where
+;;; the general entry should go.
+(defun layout-xep-fast-entries (the-function ir arities)
+  (let* ((fn-args (llvm-sys:get-argument-list the-function))
+         (nargs (second fn-args))
+         (registers (subseq (nthcdr 2 fn-args) 0 cmp::+args-in-registers+))
+         (lambda-list (bir:lambda-list ir))
+         (llvm-function-info (find-llvm-function-info ir))
+         (general (cmp:irc-basic-block-create "general-entry"))
+         (sw (cmp:irc-switch nargs general (length arities))))
+    (dolist (n arities)
+      (let ((block (cmp:irc-basic-block-create
+                    (core:bformat nil "entry-%d-arguments" n))))
+        (cmp:irc-add-case sw (%size_t n) block)
+        (cmp:irc-begin-block block)
+        (xep-call-main-function
+         the-function llvm-function-info
+         (xep-fast-entry-arguments lambda-list llvm-function-info
+                                   (subseq registers 0 n)))))
+    (cmp:irc-begin-block general)))
+
 (defun layout-main-function* (the-function ir
                               body-irbuilder body-block
                               abi &key (linkage 'llvm-sys:internal-linkage))
@@ -1282,15 +1608,22 @@
         (cmp:with-debug-info-source-position (source-pos-info)
           (let* ((fn-args (llvm-sys:get-argument-list xep-function))
                  (lambda-list (bir:lambda-list function))
-                 (calling-convention
-                   (cmp:setup-calling-convention
-                    fn-args
-                    :debug-on
-                    (cleavir-policy:policy-value
-                     (bir:policy function)
-                     'save-register-args)
-                    :cleavir-lambda-list lambda-list)))
-            (layout-xep-function* xep-function function calling-convention abi)))))))
+                 (debug-on (cleavir-policy:policy-value
+                            (bir:policy function)
+                            'save-register-args))
+                 (arities (and (not debug-on) (xep-fast-arities lambda-list))))
+            ;; With DEBUG-ON, every call must save its register arguments
+            ;; for backtraces, so only the general entry is used.
+            (when arities
+              (layout-xep-fast-entries xep-function function arities))
+            (let ((calling-convention
+                    (cmp:setup-calling-convention
+                     fn-args
+                     :debug-on debug-on
+                     :rest-alloc (rest-alloc function-info)
+                     :cleavir-lambda-list lambda-list)))
+              (layout-xep-function* xep-function function
+                                    calling-convention abi))))))))
 
 (defun layout-main-function (function lambda-name abi
                              &aux (linkage 'llvm-sys:private-linkage))
@@ -1377,7 +1710,8 @@
             (literal:load-time-value-from-thunk
              (compile-form form *clasp-env*))))))
 
-(defun layout-module (module abi &key (linkage 'llvm-sys:internal-linkage))
+(defun layout-module (module abi &key (linkage 'llvm-sys:internal-linkage)
+                                      toplevel)
   ;; Create llvm IR functions for each BIR function.
   (bir:do-functions (function module)
     ;; Assign IDs to unwind destinations.
@@ -1385,8 +1719,10 @@
       (cleavir-set:doset (entrance (bir:entrances function))
         (setf (gethash entrance *unwind-ids*) i)
         (incf i)))
-    (setf (gethash function *function-info*)
-          (allocate-llvm-function-info function :linkage linkage)))
+    (let ((function-info
+            (allocate-llvm-function-info function :linkage linkage)))
+      (setf (gethash function *function-info*) function-info)
+      (maybe-register-direct-call-target function function-info toplevel)))
   (allocate-module-constants module)
   (bir:do-functions (function module)
     (layout-procedure function (get-or-create-lambda-name function)
@@ -1396,7 +1732,7 @@
   (let* ((*unwind-ids* (make-hash-table :test #'eq))
          (*function-info* (make-hash-table :test #'eq))
          (*constant-values* (make-hash-table :test #'eq)))
-    (layout-module (bir:module bir) abi :linkage linkage)
+    (layout-module (bir:module bir) abi :linkage linkage :toplevel bir)
     (cmp::potentially-save-module)
     (xep-function (find-llvm-function-info bir))))
 
@@ -1497,6 +1833,9 @@ COMPILE-FILE will use the default *clasp-env*."
   (bir-transformations:determine-function-environments module)
   (bir-transformations:determine-closure-extents module)
   (bir-transformations:determine-variable-extents module)
+  ;; Needs variable extents, and changes no control flow either.
+  (cc-bir-to-bmir:select-module-representations module)
+  (cc-bir-to-bmir:stack-allocate-module-lists module)
   (when *dis* (cleavir-bir-disassembler:display module))
   (values))
 
@@ -1559,7 +1898,8 @@ COMPILE-FILE will use the default *clasp-env*."
         (eclector.reader:*client* *cst-client*)
         (eclector.readtable:*readtable* cl:*readtable*)
         (cst-to-ast:*compiler* 'cl:compile-file)
-        (core:*use-cleavir-compiler* t))
+        (core:*use-cleavir-compiler* t)
+        (*direct-call-targets* (make-hash-table :test #'equal)))
     (loop
       ;; Required to update the source pos info. FIXME!?
       (peek-char t source-sin nil)
@@ -36,14 +36,26 @@
                          :readably nil
                          :pretty nil))))
 
-(defun bind-variable (var)
+(defun rtype->llvm-type (rtype)
+  (case rtype
+    ((:multiple-values) cmp::%tmv%)
+    ((:double-float) cmp:%double%)
+    ((:ub64 :sb64) cmp:%i64%)
+    (otherwise cmp:%t*%)))
+
+;;; RTYPE is the representation chosen for the variable by
+;;; cc-bir-to-bmir:select-module-representations.
+(defun bind-variable (var &optional (rtype :object))
   (if (bir:immutablep var)
       ;; This should get initialized eventually.
       nil
       (setf (gethash var *datum-values*)
             (ecase (bir:extent var)
-              ((:local :dynamic)
+              ((:local)
                ;; just an alloca
+               (cmp:alloca (rtype->llvm-type rtype) 1
+                           (datum-name-as-string var)))
+              ((:dynamic)
                (cmp:alloca-t* (datum-name-as-string var)))
               ((:indefinite)
                ;; make a cell
@@ -0,0 +1,191 @@
+(in-package "CLOS")
+
+;;; Call site caches.
+;;; A generic function's discriminating function is shared by every
+;;; caller and decides among the whole call history, but most call sites
+;;; only ever see one or a few classes. When *CALL-SITE-CACHES* is true,
+;;; cclasp compiles a call to a global standard generic function with a
+;;; few arguments into a check against a cache owned by that call site
+;;; alone (see ENV:FUNCTION-INFO in cleavir/setup.lisp). The check is
+;;; inlined at every such call, so it is only done where the
+;;; CALL-SITE-CACHES policy is true, i.e. SPEED is greater than SPACE.
+;;; The cache holds up to +CALL-SITE-CACHE-SIZE+ entries, each a vector
+;;; of instance stamps for the arguments (NIL for unspecialized ones)
+;;; paired with an outcome from the call history. On a hit the outcome
+;;; is performed directly. On a miss the generic function is called
+;;; normally, and then the cache is refilled from the call history.
+;;; A site that sees more classes than that is marked megamorphic, and
+;;; just calls the generic function from then on. So is a site whose
+;;; cache stays empty: with EQL specializers nothing can be cached, and
+;;; after +CALL-SITE-CACHE-MAX-EMPTY-MISSES+ misses that cached nothing
+;;; (say, a site that's only ever passed NIL) we stop trying.
+;;;
+;;; A cache remembers the call history it was filled from. Everything
+;;; that changes how a generic function dispatches (adding or removing
+;;; methods, redefining classes, reinitializing the generic function)
+;;; replaces the call history list with a fresh one, so comparing it
+;;; with EQ is all the invalidation caches need.
+
+;;; Turned on once the system is built; see lsp/epilogue-cclasp.lisp.
+;;; It has to be off while CLOS itself is compiled.
+(defvar *call-site-caches* nil)
+
+(defconstant +call-site-cache-size+ 4)
+(defconstant +call-site-cache-max-arguments+ 3)
+(defconstant +call-site-cache-max-empty-misses+ 8)
+
+;;; A cache is a cons whose car is NIL or a state vector
+;;; #(generic-function call-history entries megamorphicp empty-misses).
+;;; States are never modified, only replaced, so the fast path can read
+;;; the car once and not worry about other threads.
+(defun make-call-site-cache () (list nil))
+
+(defun make-call-site-cache-state (generic-function call-history
+                                   entries megamorphicp
+                                   &optional (empty-misses 0))
+  (vector generic-function call-history entries megamorphicp empty-misses))
+
+(defmacro stamp-matches (stamp argument)
+  (let ((s (gensym "STAMP")))
+    `(let ((,s ,stamp))
+       (or (null ,s) (eql ,s (core:instance-stamp ,argument))))))
+
+;;; Like PERFORM-OUTCOME, but without consing an argument list.
+;;; Slot readers and writers can only be cached at call sites with the
+;;; right number of arguments, so only those cases are generated.
+(defmacro perform-cached-outcome (outcome &rest arguments)
+  (let ((o (gensym "OUTCOME")))
+    `(let ((,o ,outcome))
+       (cond
+         ,@(when (= (length arguments) 1)
+             `(((optimized-slot-reader-p ,o)
+                (let ((value (standard-location-access
+                              ,(first arguments)
+                              (optimized-slot-reader-index ,o))))
+                  (if (si:sl-boundp value)
+                      value
+                      (values (slot-unbound (optimized-slot-reader-class ,o)
+                                            ,(first arguments)
+                                            (optimized-slot-reader-slot-name ,o))))))))
+         ,@(when (= (length arguments) 2)
+             `(((optimized-slot-writer-p ,o)
+                (setf (standard-location-access
+                       ,(second arguments) (optimized-slot-writer-index ,o))
+                      ,(first arguments)))))
+         (t (funcall (effective-method-outcome-function ,o) ,@arguments))))))
+
+;;; The code emitted at each call site. ARGUMENTS must be variables.
+(defmacro call-site-cache-dispatch (cache function &rest arguments)
+  (let ((c (gensym "CACHE")) (f (gensym "FUNCTION"))
+        (state (gensym "STATE")) (stamps (gensym "STAMPS"))
+        (outcome (gensym "OUTCOME")) (done (gensym "DONE")))
+    `(let* ((,c ,cache) (,f ,function) (,state (car ,c)))
+       (block ,done
+         (when (and ,state
+                    (eq (svref ,state 0) ,f)
+                    (eq (svref ,state 1) (mp:atomic (safe-gf-call-history ,f))))
+           (when (svref ,state 3)
+             (return-from ,done (funcall ,f ,@arguments)))
+           (loop for (,stamps . ,outcome) in (svref ,state 2)
+                 when (and ,@(loop for argument in arguments
+                                   for i from 0
+                                   collect `(stamp-matches (svref ,stamps ,i)
+                                                           ,argument)))
+                   do (return-from ,done
+                        (perform-cached-outcome ,outcome ,@arguments))))
+         (call-site-cache-miss ,c ,f ,@arguments)))))
+
+;;; Return an entry for the cache if this call can be cached, or NIL.
+(defun call-site-cache-entry (call-history specializer-profile arguments)
+  (when (and specializer-profile
+             (<= (length specializer-profile) (length arguments))
+             ;; EQL specializers would need the objects, not their stamps.
+             (notany #'consp specializer-profile))
+    (let* ((classes (mapcar #'class-of
+                            (subseq arguments 0 (length specializer-profile))))
+           (key (coerce classes 'simple-vector))
+           (entry (find key call-history :key #'car
+                                         :test #'specializer-key-match))
+           (outcome (cdr entry))
+           (stamps (make-array (length arguments) :initial-element nil)))
+      (when (and entry
+                 (cond ((optimized-slot-reader-p outcome)
+                        (= (length arguments) 1))
+                       ((optimized-slot-writer-p outcome)
+                        (= (length arguments) 2))
+                       ((effective-method-outcome-p outcome)
+                        (effective-method-outcome-function outcome))))
+        (loop for spec across specializer-profile
+              for class in classes
+              for argument in arguments
+              for i from 0
+              when spec
+                do (let ((stamp (core:class-stamp-for-instances class)))
+                     ;; An obsolete instance still has its old stamp;
+                     ;; let it go through the generic function.
+                     ;; NIL has the same stamp as other symbols but a
+                     ;; different class, so stamps can't tell them apart.
+                     (unless (and (eql stamp (core:instance-stamp argument))
+                                  (not (eql stamp (core:instance-stamp nil))))
+                       (return-from call-site-cache-entry nil))
+                     (setf (svref stamps i) stamp)))
+        (cons stamps outcome)))))
+
+(defun update-call-site-cache (cache generic-function arguments)
+  (let* ((call-history (mp:atomic (safe-gf-call-history generic-function)))
+         (state (car cache))
+         (current (and state
+                       (eq (svref state 0) generic-function)
+                       (eq (svref state 1) call-history)))
+         (entries (and current (svref state 2)))
+         (empty-misses (if current (svref state 4) 0)))
+    (unless (and current (svref state 3))
+      (let* ((profile (safe-gf-specializer-profile generic-function))
+             (entry (call-site-cache-entry call-history profile arguments)))
+        (cond ((and (null entry) entries))
+              ((null entry)
+               (setf (car cache)
+                     (if (or (and profile (some #'consp profile))
+                             (>= (1+ empty-misses)
+                                 +call-site-cache-max-empty-misses+))
+                         (make-call-site-cache-state generic-function call-history
+                                                     nil t)
+                         (make-call-site-cache-state generic-function call-history
+                                                     nil nil (1+ empty-misses)))))
+              ((< (length entries) +call-site-cache-size+)
+               (setf (car cache)
+                     (make-call-site-cache-state generic-function call-history
+                                                 (append entries (list entry))
+                                                 nil)))
+              (t
+               (setf (car cache)
+                     (make-call-site-cache-state generic-function call-history
+                                                 nil t))))))))
+
+(defun call-site-cache-miss (cache function &rest arguments)
+  (multiple-value-prog1 (apply function arguments)
+    ;; Only standard generic functions are known to dispatch from their
+    ;; call history. FUNCTION may not even be generic any more.
+    (when (eq (class-of function) (find-class 'standard-generic-function))
+      (update-call-site-cache cache function arguments))))
+
+;;; Return a compiler macro function for calls to the generic function
+;;; named NAME, or NIL if there should be none. POLICYP is called with
+;;; the environment of a call and says whether to cache it; the policy
+;;; lives in the compiler, which is loaded after CLOS.
+(defun call-site-cache-compiler-macro (name policyp)
+  (when (and *call-site-caches*
+             (fboundp name)
+             (typep (fdefinition name) 'standard-generic-function))
+    (lambda (form env)
+      (let ((arguments (if (eq (first form) 'funcall) (cddr form) (rest form))))
+        (if (and (funcall policyp env)
+                 (core:proper-list-p arguments)
+                 (<= 1 (length arguments) +call-site-cache-max-arguments+))
+            (let ((temps (loop repeat (length arguments)
+                               collect (gensym "ARG"))))
+              `(let (,@(mapcar #'list temps arguments))
+                 (call-site-cache-dispatch
+                  (load-time-value (make-call-site-cache))
+                  #',name ,@temps)))
+            form)))))
@@ -209,13 +209,15 @@
 ;;; CLASS REDEFINITION PROTOCOL
 
 (defmethod reinitialize-instance :before ((class class) &rest initargs &key)
-  (declare (ignore initargs))
   (let ((name (class-name class)))
     (when (member name '(CLASS BUILT-IN-CLASS) :test #'eq)
       (error "The kernel CLOS class ~S cannot be changed." name)))
 
-  ;; remove previous defined accessor methods
-  (when (class-finalized-p class)
+  ;; remove previous defined accessor methods. A sealed class can only be
+  ;; redefined identically, so its accessor methods are just replaced
+  ;; when they're generated again.
+  (when (and (not (check-class-redefinition class initargs))
+             (class-finalized-p class))
     (remove-optional-slot-accessors class)))
 
 (defun slots-unchanged-p (old-slots new-slots)
@@ -0,0 +1,125 @@
+(in-package "CLOS")
+
+;;; Dispatch profiles.
+;;; A generic function's call history records which classes it has
+;;; actually been called with. SAVE-DISPATCH-PROFILE writes that down
+;;; for every generic function in the image, e.g. after a service has
+;;; been running under a representative load. Code compiled later can
+;;; then contain (SATIATE-FROM-DISPATCH-PROFILE pathname), which
+;;; compiles the effective methods for the recorded classes into the
+;;; FASL and installs them when it's loaded, so that the service
+;;; doesn't have to go through dispatch misses to get back to where it
+;;; was.
+;;;
+;;; The file holds one list per generic function,
+;;;  (name (specializer-designator ...) ...)
+;;; with the same designators as SATIATE. Entries with classes that
+;;; have no proper name, or EQL specializers on objects that can't be
+;;; written readably, are left out.
+;;;
+;;; Only the classes each generic function was called with are
+;;; recorded. Nothing is recorded per call site, and the profile is not
+;;; used for branch weights, hot/cold splitting or inlining decisions.
+;;; Call-site instrumentation would need counters in every generic
+;;; function call the compiler emits, which costs on every call.
+
+(defun map-generic-functions (function)
+  (let ((seen (make-hash-table :test #'eq)))
+    (flet ((maybe (name)
+             (when (fboundp name)
+               (let ((f (fdefinition name)))
+                 (when (and (typep f 'standard-generic-function)
+                            (not (gethash f seen)))
+                   (setf (gethash f seen) t)
+                   (funcall function f))))))
+      (dolist (package (list-all-packages))
+        (do-symbols (symbol package)
+          (maybe symbol)
+          (maybe `(setf ,symbol)))))))
+
+(defun profile-eql-designator (object)
+  (and (typep object '(or symbol number character))
+       (or (not (symbolp object)) (symbol-package object))
+       `(eql ,object)))
+
+;;; Return a specializer designator for an element of a call history
+;;; key, or NIL if it can't be written out. Keys hold EQL specializers
+;;; as one element lists.
+(defun profile-specializer-designator (specializer)
+  (cond ((eql-specializer-p specializer)
+         (profile-eql-designator (eql-specializer-object specializer)))
+        ((consp specializer)
+         (profile-eql-designator (first specializer)))
+        ((typep specializer 'class)
+         (let ((name (class-name specializer)))
+           (and name
+                (symbol-package name)
+                (eq (find-class name nil) specializer)
+                name)))
+        (t nil)))
+
+(defun generic-function-dispatch-profile (generic-function)
+  (loop for (key) in (mp:atomic (safe-gf-call-history generic-function))
+        for designators = (map 'list #'profile-specializer-designator key)
+        unless (member nil designators)
+          collect designators))
+
+(defun save-dispatch-profile (pathname)
+  "Write the classes that each generic function has been called with so
+far to PATHNAME, for SATIATE-FROM-DISPATCH-PROFILE to use later."
+  (let ((profile nil))
+    (map-generic-functions
+     (lambda (generic-function)
+       (let ((name (generic-function-name generic-function))
+             (entries (generic-function-dispatch-profile generic-function)))
+         (when entries
+           (push (cons name entries) profile)))))
+    (with-open-file (stream pathname :direction :output :if-exists :supersede)
+      (with-standard-io-syntax
+        (let ((*package* (find-package "KEYWORD")))
+          (dolist (entry profile)
+            (prin1 entry stream)
+            (terpri stream)))))
+    pathname))
+
+(defun load-dispatch-profile (pathname)
+  (with-open-file (stream pathname)
+    (with-standard-io-syntax
+      (let ((*read-eval* nil))
+        (loop for entry = (read stream nil stream)
+              until (eq entry stream)
+              collect entry)))))
+
+;;; Can the entries be satiated in this compilation environment?
+;;; Like %SATIATE, this needs the generic function and its methods.
+(defun profile-satiable-entries (name entries)
+  (when (and (fboundp name)
+             (typep (fdefinition name) 'standard-generic-function))
+    (let ((nspec (length (safe-gf-specializer-profile (fdefinition name)))))
+      (remove-if-not
+       (lambda (designators)
+         (and (= (length designators) nspec)
+              (every (lambda (d) (or (consp d) (find-class d nil)))
+                     designators)))
+       entries))))
+
+;;; Like %SATIATE, but the discriminating function is left to be
+;;; computed at load time, since class stamps of user classes aren't
+;;; the same in the compiling and loading images.
+(defmacro %satiate-from-profile (generic-function-name &rest lists-of-specializer-names)
+  (let ((generic-function (fdefinition generic-function-name)))
+    (let ((call-history (apply #'compile-time-call-history generic-function
+                               lists-of-specializer-names)))
+      `(let ((gf (fdefinition ',generic-function-name)))
+         (append-generic-function-call-history
+          gf ,(call-history-producer call-history (gf-arg-info generic-function)))
+         (invalidate-discriminating-function gf)))))
+
+(defmacro satiate-from-dispatch-profile (pathname)
+  "Read a dispatch profile written by SAVE-DISPATCH-PROFILE at compile time,
+and satiate the generic functions in it that are defined at compile time."
+  `(progn
+     ,@(loop for (name . entries) in (load-dispatch-profile pathname)
+             for satiable = (profile-satiable-entries name entries)
+             when satiable
+               collect `(%satiate-from-profile ,name ,@satiable))))
@@ -289,6 +289,7 @@
   ;; during boot it's a structure accessor
   (declare (notinline method-qualifiers remove-method))
   (declare (notinline reinitialize-instance)) ; bootstrap stuff
+  (check-method-addition gf method)
   ;;
   ;; 1) The method must not be already installed in another generic function.
   ;;
@@ -321,7 +322,8 @@ and cannot be added to ~A." method other-gf gf)))
 	   (specializers (method-specializers method))
 	   (found (find-method gf method-qualifiers specializers nil)))
       (when found
-	(remove-method gf found))))
+	(let ((*replaced-method* found))
+	  (remove-method gf found)))))
   ;;
   ;; Per AMOP's description of ADD-METHOD, we install the method by:
   ;;  i) Adding it to the list of methods.
@@ -340,6 +342,7 @@ and cannot be added to ~A." method other-gf gf)))
   gf)
 
 (defun remove-method (gf method)
+  (check-method-removal gf method)
   (setf (%generic-function-methods gf)
 	(delete method (generic-function-methods gf))
 	(%method-generic-function method) nil)
@@ -93,7 +93,7 @@
       (finalized :initform nil :reader class-finalized-p
                  :accessor %class-finalized-p :location 11)
       (docstring :initarg :documentation :initform nil :location 12)
-      (size :accessor class-size)
+      (size :accessor class-size :location 13)
       (prototype)
       (dependents :initform nil :accessor class-dependents :location 15)
       (valid-initargs :accessor class-valid-initargs)
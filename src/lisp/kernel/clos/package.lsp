@@ -146,6 +146,10 @@
           satiate
           satiate-initialization
           apply-method
+          seal-class
+          seal-generic-function
+          save-dispatch-profile
+          satiate-from-dispatch-profile
           ))
 
 #+clasp
@@ -0,0 +1,286 @@
+(in-package "CLOS")
+
+;;; Sealing.
+;;; A sealed class can't be redefined and can't get new subclasses, and
+;;; its superclasses are frozen (they can't be redefined either, since
+;;; that would change the sealed class's slots and precedence list).
+;;; A sealed generic function can't have methods added or removed.
+;;; For a call to a sealed generic function that specializes one
+;;; argument, the class of that argument is then all that decides the
+;;; effective method, and for a sealed class it can never change. So the
+;;; compiler can compile such a call into a test of the argument's class
+;;; against each sealed class the methods apply to, reading or writing
+;;; slots at fixed locations and calling effective methods directly,
+;;; with a normal call for any other class.
+;;;
+;;; Sealing is done in the compilation environment with EVAL-WHEN, e.g.
+;;;  (eval-when (:compile-toplevel :load-toplevel :execute)
+;;;    (seal-class 'point)
+;;;    (seal-generic-function 'point-x))
+;;; and the compiled code checks at load time that the same classes are
+;;; sealed and laid out the same way.
+
+;;; Class -> :SEALED or :FROZEN.
+(defvar *sealed-classes* (make-hash-table :test #'eq :thread-safe t))
+;;; Generic function -> T.
+(defvar *sealed-generic-functions* (make-hash-table :test #'eq :thread-safe t))
+
+;;; More classes than this and we just call the generic function.
+(defconstant +sealed-dispatch-max-classes+ 8)
+
+;;; Superclasses that sealing a class never freezes. Everything inherits
+;;; from them, and redefining them isn't a user's business anyway.
+(defparameter *unfreezable-class-names*
+  '(t standard-object funcallable-standard-object structure-object))
+
+(defun sealed-class-p (class)
+  (eq (gethash class *sealed-classes*) :sealed))
+
+(defun sealed-generic-function-p (generic-function)
+  (values (gethash generic-function *sealed-generic-functions*)))
+
+(defun seal-class (class)
+  "Seal CLASS and all of its subclasses: none of them can be redefined or
+get new subclasses afterwards. Their superclasses can't be redefined."
+  (let ((class (if (symbolp class) (find-class class) class)))
+    (labels ((seal (class)
+               (unless (sealed-class-p class)
+                 (unless (class-finalized-p class)
+                   (finalize-inheritance class))
+                 (setf (gethash class *sealed-classes*) :sealed)
+                 (dolist (super (class-precedence-list class))
+                   (unless (or (gethash super *sealed-classes*)
+                               (member (class-name super) *unfreezable-class-names*
+                                       :test #'eq))
+                     (setf (gethash super *sealed-classes*) :frozen)))
+                 (mapc #'seal (class-direct-subclasses class)))))
+      (seal class))
+    class))
+
+(defun seal-generic-function (generic-function)
+  "Seal GENERIC-FUNCTION: no methods can be added to or removed from it
+afterwards."
+  (let ((generic-function (if (functionp generic-function)
+                              generic-function
+                              (fdefinition generic-function))))
+    (unless (typep generic-function 'standard-generic-function)
+      (error "Cannot seal ~s: only standard generic functions can be sealed."
+             generic-function))
+    (setf (gethash generic-function *sealed-generic-functions*) t)
+    generic-function))
+
+;;; Called from the places that would change a sealed domain.
+;;; Loading a file that was just compiled in the same image evaluates
+;;; its DEFCLASS and DEFMETHOD forms again, so redefining things exactly
+;;; as they were is allowed: a method can replace one of the same kind
+;;; with the same qualifiers and specializers, and a class can be reinitialized with
+;;; the same superclasses and slot layout and accessors.
+
+;;; The method ADD-METHOD is replacing, which it's therefore allowed
+;;; to remove.
+(defvar *replaced-method* nil)
+
+;;; Is NEW a reload of OLD? It must be of the same class, and an
+;;; accessor method must access the same slot. A reinitialized class
+;;; gets fresh slot definitions, so those are compared by name and
+;;; allocation.
+(defun identical-method-replacement-p (old new)
+  (and (eq (class-of old) (class-of new))
+       (or (not (typep new 'standard-accessor-method))
+           (let ((old-slotd (accessor-method-slot-definition old))
+                 (new-slotd (accessor-method-slot-definition new)))
+             (and (eq (slot-definition-name old-slotd)
+                      (slot-definition-name new-slotd))
+                  (eq (slot-definition-allocation old-slotd)
+                      (slot-definition-allocation new-slotd)))))))
+
+(defun check-method-addition (generic-function method)
+  (when (sealed-generic-function-p generic-function)
+    (let ((old (find-method generic-function (method-qualifiers method)
+                            (method-specializers method) nil)))
+      (cond ((null old)
+             (error "Cannot add ~s to ~s: it has been sealed." method generic-function))
+            ((not (identical-method-replacement-p old method))
+             (error "Cannot replace ~s with ~s in ~s: it has been sealed."
+                    old method generic-function))))))
+
+(defun check-method-removal (generic-function method)
+  (when (and (sealed-generic-function-p generic-function)
+             (not (eq method *replaced-method*)))
+    (error "Cannot remove ~s from ~s: it has been sealed." method generic-function)))
+
+(defun normalize-direct-superclasses (class superclasses)
+  (or (mapcar (lambda (c) (if (symbolp c) (find-class c nil) c)) superclasses)
+      (class-direct-superclasses class)))
+
+;;; Do the DIRECT-SLOTS (canonical slot plists) and DIRECT-SUPERCLASSES
+;;; reinitialization arguments describe the class as it is? Initforms,
+;;; documentation and such may differ, since they don't affect layout or
+;;; dispatch.
+(defun identical-class-redefinition-p (class initargs)
+  (destructuring-bind (&key (direct-superclasses nil direct-superclasses-p)
+                         (direct-slots nil direct-slots-p)
+                       &allow-other-keys)
+      initargs
+    (flet ((same-set-p (a b)
+             (and (subsetp a b :test #'equal) (subsetp b a :test #'equal))))
+      (and (or (not direct-superclasses-p)
+               (equal (normalize-direct-superclasses class direct-superclasses)
+                      (class-direct-superclasses class)))
+           (or (not direct-slots-p)
+               (let ((old (class-direct-slots class)))
+                 (and (= (length old) (length direct-slots))
+                      (every (lambda (slotd plist)
+                               (and (eq (slot-definition-name slotd) (getf plist :name))
+                                    (eq (slot-definition-allocation slotd)
+                                        (getf plist :allocation :instance))
+                                    (same-set-p (slot-definition-readers slotd)
+                                                (getf plist :readers))
+                                    (same-set-p (slot-definition-writers slotd)
+                                                (getf plist :writers))))
+                             old direct-slots))))))))
+
+;;; Called before CLASS is reinitialized with INITARGS. Returns true if
+;;; CLASS is sealed or frozen, in which case the redefinition is
+;;; identical and the accessor methods will just be replaced.
+(defun check-class-redefinition (class initargs)
+  (let ((state (gethash class *sealed-classes*)))
+    (when (and state (not (identical-class-redefinition-p class initargs)))
+      (ecase state
+        ((:sealed) (error "Cannot redefine ~s: it has been sealed." class))
+        ((:frozen) (error "Cannot redefine ~s: it is a superclass of a sealed class."
+                          class))))
+    state))
+
+(defun check-subclass-allowed (class subclass)
+  (when (and (sealed-class-p class)
+             (not (member subclass (class-direct-subclasses class))))
+    (error "Cannot define ~s as a subclass of ~s: it has been sealed."
+           subclass class)))
+
+;;; Load time.
+
+;;; Return the class named NAME, checking that it is still sealed and
+;;; that the slots in SLOT-LOCATIONS, an alist (name . location), are
+;;; where they were at compile time.
+(defun find-sealed-class (name slot-locations)
+  (let ((class (find-class name)))
+    (unless (sealed-class-p class)
+      (error "Code was compiled with ~s sealed, but it isn't." class))
+    (loop for (slot-name . location) in slot-locations
+          for slotd = (find slot-name (class-slots class)
+                            :key #'slot-definition-name)
+          unless (and slotd (eql (slot-definition-location slotd) location))
+            do (error "The layout of the sealed class ~s has changed since compile time."
+                      class))
+    class))
+
+(defun sealed-outcome-function (name class-name index)
+  (let ((generic-function (fdefinition name)))
+    (unless (sealed-generic-function-p generic-function)
+      (error "Code was compiled with ~s sealed, but it isn't." generic-function))
+    (effective-method-outcome-function
+     (sealed-outcome generic-function (find-class class-name) index))))
+
+;;; Compile time.
+
+;;; The outcome of calling GENERIC-FUNCTION with an instance of CLASS as
+;;; the argument at INDEX, which is the only specialized one.
+(defun sealed-outcome (generic-function class index)
+  (let ((specializers
+          (loop for i below (length (safe-gf-specializer-profile generic-function))
+                collect (if (= i index) class (find-class t)))))
+    (outcome generic-function
+             (generic-function-method-combination generic-function)
+             (compute-applicable-methods-using-specializers generic-function
+                                                            specializers)
+             specializers)))
+
+;;; The sealed classes that methods of GENERIC-FUNCTION specialize on at
+;;; INDEX, and their subclasses. Methods on T apply to everything, so
+;;; they don't add any classes. Return NIL if there are EQL specializers.
+(defun sealed-domain (generic-function index)
+  (let ((classes nil))
+    (labels ((walk (class)
+               (when (sealed-class-p class)
+                 (pushnew class classes))
+               (mapc #'walk (class-direct-subclasses class))))
+      (dolist (method (generic-function-methods generic-function))
+        (let ((specializer (nth index (method-specializers method))))
+          (cond ((eql-specializer-p specializer)
+                 (return-from sealed-domain nil))
+                ((eq specializer (find-class t)))
+                (t (walk specializer))))))
+    (nreverse classes)))
+
+;;; The form for calling GENERIC-FUNCTION when the argument variable at
+;;; INDEX holds an instance of CLASS, and the slot locations it relies
+;;; on, or NIL if there's nothing better than a normal call.
+(defun sealed-outcome-form (generic-function name class index arguments)
+  (let ((outcome (sealed-outcome generic-function class index)))
+    (cond ((and (optimized-slot-reader-p outcome)
+                (fixnump (optimized-slot-reader-index outcome))
+                (= (length arguments) 1))
+           (let ((slot-name (optimized-slot-reader-slot-name outcome))
+                 (location (optimized-slot-reader-index outcome)))
+             (values `(let ((value (core:instance-ref ,(first arguments) ',location)))
+                        (if (cleavir-primop:eq value (core:unbound))
+                            (slot-unbound (class-of ,(first arguments))
+                                          ,(first arguments) ',slot-name)
+                            value))
+                     (list (cons slot-name location)))))
+          ((and (optimized-slot-writer-p outcome)
+                (fixnump (optimized-slot-writer-index outcome))
+                (= (length arguments) 2))
+           (let ((slot-name (optimized-slot-writer-slot-name outcome))
+                 (location (optimized-slot-writer-index outcome)))
+             (values `(si:instance-set ,(second arguments) ,location ,(first arguments))
+                     (list (cons slot-name location)))))
+          ((and (effective-method-outcome-p outcome)
+                (outcome-methods outcome))
+           (values `(funcall (load-time-value
+                              (sealed-outcome-function ',name ',(class-name class) ,index))
+                             ,@arguments)
+                   nil))
+          (t nil))))
+
+(defun sealed-call-expansion (generic-function name arguments)
+  (let* ((profile (safe-gf-specializer-profile generic-function))
+         (index (and profile (position-if-not #'null profile))))
+    (when (and index
+               (= (count-if-not #'null profile) 1)
+               (< index (length arguments)))
+      (let ((classes (sealed-domain generic-function index))
+            (temps (loop repeat (length arguments) collect (gensym "ARG")))
+            (class (gensym "CLASS"))
+            (clauses nil))
+        (when (<= 1 (length classes) +sealed-dispatch-max-classes+)
+          (dolist (c classes)
+            (multiple-value-bind (form slot-locations)
+                (and (eq (find-class (class-name c) nil) c)
+                     (sealed-outcome-form generic-function name c index temps))
+              (when form
+                (push `((eq ,class (load-time-value
+                                    (find-sealed-class ',(class-name c)
+                                                       ',slot-locations)))
+                        ,form)
+                      clauses))))
+          (when clauses
+            `(let (,@(mapcar #'list temps arguments))
+               (let ((,class (class-of ,(nth index temps))))
+                 (cond ,@(nreverse clauses)
+                       (t (locally (declare (notinline ,name))
+                            (funcall #',name ,@temps))))))))))))
+
+;;; Return a compiler macro function for calls to the generic function
+;;; named NAME if it is sealed, or NIL.
+(defun sealed-generic-function-compiler-macro (name)
+  (when (fboundp name)
+    (let ((generic-function (fdefinition name)))
+      (when (sealed-generic-function-p generic-function)
+        (lambda (form env)
+          (declare (ignore env))
+          (let ((arguments (if (eq (first form) 'funcall) (cddr form) (rest form))))
+            (or (and (core:proper-list-p arguments)
+                     (sealed-call-expansion generic-function name arguments))
+                form)))))))
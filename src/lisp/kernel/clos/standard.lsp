@@ -287,6 +287,7 @@
      #'(lambda (dep) (apply #'update-dependent object dep initargs)))))
 
 (defmethod add-direct-subclass ((parent class) child)
+  (check-subclass-allowed parent child)
   (pushnew child (%class-direct-subclasses parent)))
 
 (defmethod remove-direct-subclass ((parent class) child)
@@ -290,7 +290,23 @@
   (link-bitcode-modules-impl output-pathname part-pathnames
                              :clasp-build-mode :fasoll))
 
-(export '(link-bitcode-modules link-fasoll-modules link-fasobc-modules))
+(defun link-fasobc-modules-to-faso (output-pathname part-pathnames)
+  "Link the fasobc files of a system, optimize them as a whole, and write
+a faso with a single object to OUTPUT-PATHNAME. Code and constants shared
+by the files are optimized together, but calls between Lisp functions still
+go through their function cells, so nothing is inlined across them."
+  (let ((module (link-bitcode-modules-together (namestring output-pathname) part-pathnames
+                                               :clasp-build-mode :fasobc)))
+    (optimize-module-for-lto module)
+    (irc-verify-module-safe module)
+    (core:write-faso output-pathname
+                     (list (generate-obj-asm-stream module :simple-vector-byte8
+                                                    'llvm-sys:code-gen-file-type-object-file
+                                                    (reloc-model))))
+    output-pathname))
+
+(export '(link-bitcode-modules link-fasoll-modules link-fasobc-modules
+          link-fasobc-modules-to-faso))
 
 
 
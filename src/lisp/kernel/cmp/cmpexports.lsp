@@ -17,6 +17,7 @@
             *compile-debug-dump-module* ;; Dump intermediate modules
             *default-linkage*
             *compile-file-parallel-write-bitcode*
+            *compile-file-lto*
             *default-compile-linkage*
             quick-module-dump
             write-bitcode
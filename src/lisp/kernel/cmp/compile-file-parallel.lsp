@@ -24,7 +24,8 @@
   form-counter ; Counts from zero
   module
   (serious-condition nil) (warnings nil) (other-conditions nil)
-  current-source-pos-info startup-function-name form-output-path)
+  current-source-pos-info startup-function-name form-output-path
+  cache-key)
 
 
 (defun compile-from-module (job &key
@@ -122,36 +123,361 @@
                            :intermediate-output-type intermediate-output-type
                            :write-bitcode write-bitcode))
 
-(defun wait-for-ast-job (queue &key compile-func optimize optimize-level intermediate-output-type write-bitcode)
-  (unwind-protect
-       (loop for ast-job = (core:dequeue queue :timeout 1.0 :timeout-val nil)
-             until (eq ast-job :quit)
-             do (if ast-job
-                    (progn
-                      (cfp-log "Thread ~a compiling form~%" (mp:process-name mp:*current-process*))
-                      (block nil
-                        (handler-bind
-                            ((serious-condition
-                               (lambda (e)
-                                 (setf (ast-job-serious-condition ast-job) e)
-                                 ;; Cannot continue with this job
-                                 (return)))
-                             (warning
-                               (lambda (w)
-                                 (push w (ast-job-warnings ast-job))
-                                 ;; Will be reported in the main thread instead.
-                                 (muffle-warning w)))
-                             ((not (or serious-condition warning))
-                               (lambda (c)
-                                 (push c (ast-job-other-conditions ast-job)))))
-                          (funcall compile-func ast-job
-                                   :optimize optimize
-                                   :optimize-level optimize-level
-                                   :intermediate-output-type intermediate-output-type
-                                   :write-bitcode write-bitcode)))
-                      (cfp-log "Thread ~a done with form~%" (mp:process-name mp:*current-process*)))
-                    (cfp-log "Thread ~a timed out during dequeue - trying again~%" (mp:process-name mp:*current-process*))))
-    (cfp-log "Leaving thread ~a~%" (mp:process-name mp:*current-process*))))
+;;; Form-level compilation cache.
+;;; When *compile-file-parallel-cache-directory* is set, the object code of
+;;; each toplevel form is stored there under a key that hashes the printed
+;;; form, the layout of its source relative to where the form starts, its
+;;; ordinal in the file (its startup function is registered under it), the
+;;; compiler policy, *features*, and a fingerprint of each global definition
+;;; outside the implementation that the form refers to.  Nothing in the key
+;;; depends on where the form is in the file, so editing one form doesn't
+;;; invalidate the forms after it unless they use what it defines.
+;;; The object is stored with the line and file position it was compiled at.
+;;; When it's used for a form somewhere else, its debug information and
+;;; function descriptions are relocated with
+;;; llvm-sys:relocate-object-source-positions; if that isn't possible the
+;;; form is compiled again.
+;;; A definition made by an earlier form in the file is fingerprinted by the
+;;; key of that form.  Other definitions are fingerprinted by the source file,
+;;; position and write date of the function that implements them, or by
+;;; their value; a form using a definition that can't be fingerprinted that
+;;; way isn't cached.
+;;; When the key is found, the form is still converted to an AST, so that its
+;;; compile-time side effects happen, but the object is taken from the cache.
+;;; Forms that signalled any condition while compiling are never stored, so
+;;; a cache hit can't hide a diagnostic.
+
+(defvar *compile-file-parallel-cache-directory* nil
+  "NIL, or a directory pathname in which compile-file-parallel caches the object code of toplevel forms.")
+
+(defparameter *form-cache-version* 3)
+
+;;; Definitions in these packages change only with the implementation,
+;;; whose version is part of the key.
+(defparameter *form-cache-implementation-packages*
+  '("COMMON-LISP" "KEYWORD" "CORE" "EXT" "CLOS" "MP" "GCTOOLS" "CMP"
+    "SEQUENCE" "GRAY" "CLASP-FFI" "LITERAL" "CLASP-CLEAVIR"))
+
+;;; Bound by cclasp-loop2 to a table from symbols to (definitions . fingerprint)
+;;; for each symbol whose definitions have been fingerprinted in this file.
+(defvar *form-cache-definitions*)
+
+(defun form-cache-symbols (form)
+  "Return the symbols in FORM that aren't the implementation's own."
+  (let ((seen (make-hash-table :test #'eq))
+        (symbols nil)
+        (implementation-packages
+          (remove nil (mapcar #'find-package *form-cache-implementation-packages*))))
+    (labels ((walk (x)
+               (cond ((symbolp x)
+                      (unless (or (gethash x seen)
+                                  (member (symbol-package x) implementation-packages))
+                        (setf (gethash x seen) t)
+                        (push x symbols)))
+                     ((and (consp x) (not (gethash x seen)))
+                      (setf (gethash x seen) t)
+                      (walk (car x))
+                      (walk (cdr x))))))
+      (walk form)
+      (nreverse symbols))))
+
+(defun symbol-definitions (symbol)
+  "Return an alist of the global definitions of SYMBOL that change how code using it compiles."
+  (let ((definitions nil))
+    (flet ((note (kind object)
+             (when object (push (cons kind object) definitions))))
+      (note :macro (macro-function symbol))
+      (note :compiler-macro (compiler-macro-function symbol))
+      (note :setf-expander (ext:setf-expander symbol))
+      (note :symbol-macro (ext:symbol-macro symbol nil))
+      (note :type (ext:type-expander symbol))
+      (note :class (find-class symbol nil))
+      (note :special (ext:specialp symbol))
+      (note :inline (and (core::declared-global-inline-p symbol)
+                         (or (clasp-cleavir::inline-ast symbol) t)))
+      (note :setf-inline (core::declared-global-inline-p `(setf ,symbol)))
+      (multiple-value-bind (ftype found) (gethash symbol clasp-cleavir::*ftypes*)
+        (when found (note :ftype ftype)))
+      (when (constantp symbol)
+        (push (cons :constant (symbol-value symbol)) definitions)))
+    definitions))
+
+(defun same-definitions-p (definitions1 definitions2)
+  (and (= (length definitions1) (length definitions2))
+       (every (lambda (definition1 definition2)
+                (and (eq (car definition1) (car definition2))
+                     (eql (cdr definition1) (cdr definition2))))
+              definitions1 definitions2)))
+
+(defun function-fingerprint (function)
+  "Return where FUNCTION was defined, or :UNKNOWN if that can't identify it.
+Functions defined in the file being compiled are :UNKNOWN, since the definition
+they came from may not be the one in the file now."
+  (multiple-value-bind (pathname filepos lineno)
+      (and (functionp function) (ignore-errors (ext:compiled-function-file function)))
+    (let ((date (and pathname (ignore-errors (file-write-date pathname)))))
+      (if (and date
+               (not (equal (ignore-errors (truename pathname)) *compile-file-truename*)))
+          (list (namestring pathname) filepos lineno date)
+          :unknown))))
+
+(defun definition-fingerprint (symbol kind object)
+  "Return a fingerprint of a definition of SYMBOL made outside the file being compiled."
+  (case kind
+    ((:macro :compiler-macro :setf-expander :symbol-macro :type)
+     (function-fingerprint object))
+    (:inline
+     (if (fboundp symbol) (function-fingerprint (fdefinition symbol)) :unknown))
+    (:class
+     (list (class-name object)
+           (mapcar #'class-name (clos:class-direct-superclasses object))
+           (mapcar #'clos:slot-definition-name (clos:class-direct-slots object))))
+    (otherwise object)))
+
+(defun definitions-fingerprint (symbol definitions)
+  "Return the fingerprint of DEFINITIONS, the current definitions of SYMBOL."
+  (let ((entry (gethash symbol *form-cache-definitions*)))
+    (if (and entry (same-definitions-p (car entry) definitions))
+        (cdr entry)
+        (let* ((fingerprints (loop for (kind . object) in definitions
+                                   collect (cons kind (definition-fingerprint symbol kind object))))
+               (fingerprint (if (find :unknown fingerprints :key #'cdr)
+                                :unknown
+                                fingerprints)))
+          (setf (gethash symbol *form-cache-definitions*) (cons definitions fingerprint))
+          fingerprint))))
+
+(defun form-cache-dependencies (symbols before)
+  "Fingerprint what SYMBOLS were defined as before the current form was converted, which
+BEFORE lists, and what they are defined as now.  Return the fingerprint, or :UNKNOWN,
+and the symbols the form redefined."
+  (loop with unknown = nil
+        for symbol in symbols
+        for old in before
+        for new = (symbol-definitions symbol)
+        for old-fingerprint = (and old (definitions-fingerprint symbol old))
+        when (eq old-fingerprint :unknown)
+          do (setf unknown t)
+        if (not (same-definitions-p old new))
+          collect symbol into changed
+          and collect (list symbol old-fingerprint :redefined) into fingerprint
+        else when old
+          collect (list symbol old-fingerprint) into fingerprint
+        finally (return (values (if unknown :unknown fingerprint) changed))))
+
+(defun note-form-cache-definitions (symbols key)
+  "Record that the form with KEY defined SYMBOLS as they are now."
+  (dolist (symbol symbols)
+    (setf (gethash symbol *form-cache-definitions*)
+          (cons (symbol-definitions symbol) (or key :unknown)))))
+
+(defun form-cache-layout (cst start)
+  "Return the source positions in CST relative to START, the position of the form."
+  (let ((seen (make-hash-table :test #'eq))
+        (layout nil)
+        (start-lineno (core:source-pos-info-lineno start))
+        (start-filepos (core:source-pos-info-filepos start)))
+    (labels ((relative (source)
+               (cond ((consp source)
+                      (cons (relative (car source)) (relative (cdr source))))
+                     ((typep source 'core:source-pos-info)
+                      (list (- (core:source-pos-info-lineno source) start-lineno)
+                            (core:source-pos-info-column source)
+                            (- (core:source-pos-info-filepos source) start-filepos)))))
+             (walk (cst)
+               (unless (gethash cst seen)
+                 (setf (gethash cst seen) t)
+                 (push (relative (cst:source cst)) layout)
+                 (when (typep cst 'cst:cons-cst)
+                   (walk (cst:first cst))
+                   (walk (cst:rest cst))))))
+      (walk cst)
+      (nreverse layout))))
+
+(defun form-cache-key (form form-counter layout dependencies optimize optimize-level)
+  "Return the cache key of FORM as a string, or NIL if FORM can't be printed."
+  (let ((text (ignore-errors
+               (with-standard-io-syntax
+                 (let ((*package* (find-package "KEYWORD"))
+                       (*print-readably* nil)
+                       (*print-circle* t))
+                   (prin1-to-string
+                    (list *form-cache-version*
+                          (lisp-implementation-version)
+                          (core:lisp-implementation-id)
+                          *default-object-type*
+                          clasp-cleavir::*global-optimize*
+                          optimize optimize-level
+                          *features*
+                          (and (boundp '*compile-file-source-debug-pathname*)
+                               (namestring *compile-file-source-debug-pathname*))
+                          form-counter layout dependencies form)))))))
+    (when text
+      (core:digest-sha256 (list (core:serialize-to-octets text))))))
+
+(defun form-cache-pathname (key)
+  (merge-pathnames (make-pathname :name key :type "o")
+                   *compile-file-parallel-cache-directory*))
+
+;;; A cache file holds the line and file position the form was compiled at,
+;;; as two little-endian 64-bit integers, followed by the object code.
+(defconstant +form-cache-header-size+ 16)
+
+(defun load-cached-form-object (key source-pos-info)
+  "Return the cached object code for KEY relocated to SOURCE-POS-INFO, or NIL."
+  (let ((pathname (form-cache-pathname key)))
+    (when (probe-file pathname)
+      (with-open-file (fin pathname :element-type '(unsigned-byte 8))
+        (let ((header (make-array +form-cache-header-size+ :element-type '(unsigned-byte 8)))
+              (octets (make-array (max 0 (- (file-length fin) +form-cache-header-size+))
+                                  :element-type '(unsigned-byte 8))))
+          (flet ((header-integer (start)
+                   (loop for index below 8
+                         sum (ash (aref header (+ start index)) (* 8 index)))))
+            (when (and (plusp (length octets))
+                       (= (read-sequence header fin) +form-cache-header-size+)
+                       (= (read-sequence octets fin) (length octets))
+                       (llvm-sys:relocate-object-source-positions
+                        octets
+                        (- (core:source-pos-info-lineno source-pos-info) (header-integer 0))
+                        (- (core:source-pos-info-filepos source-pos-info) (header-integer 8))))
+              octets)))))))
+
+(defun store-cached-form-objects (ast-jobs)
+  (dolist (job ast-jobs)
+    (when (and (ast-job-cache-key job)
+               (null (ast-job-serious-condition job))
+               (null (ast-job-warnings job))
+               (null (ast-job-other-conditions job))
+               (typep (ast-job-output-object job) '(simple-array (unsigned-byte 8) (*))))
+      (let ((pathname (form-cache-pathname (ast-job-cache-key job)))
+            (header (make-array +form-cache-header-size+ :element-type '(unsigned-byte 8)))
+            (source-pos-info (ast-job-current-source-pos-info job)))
+        (loop for index below 8
+              do (setf (aref header index)
+                       (ldb (byte 8 (* 8 index)) (core:source-pos-info-lineno source-pos-info))
+                       (aref header (+ 8 index))
+                       (ldb (byte 8 (* 8 index)) (core:source-pos-info-filepos source-pos-info))))
+        (ensure-directories-exist pathname)
+        (with-atomic-file-rename (temp-pathname pathname)
+          (with-open-file (fout temp-pathname :direction :output :if-exists :supersede
+                                              :element-type '(unsigned-byte 8))
+            (write-sequence header fout)
+            (write-sequence (ast-job-output-object job) fout)))))))
+
+;;; Compile jobs run in a pool of worker threads that is started on first
+;;; use and shared by every compile-file-parallel call, so building many
+;;; files doesn't pay for thread creation each time.  Workers block in
+;;; DEQUEUE; each unit of work is a closure that carries the dynamic
+;;; environment of the compile-file call that submitted it.
+
+(defvar *compile-worker-pool* nil
+  "The queue of the persistent compile-file-parallel worker pool, or NIL if it hasn't been started.")
+(defvar *compile-worker-threads* nil)
+(defvar *compile-worker-pool-lock* (mp:make-lock :name "compile-worker-pool"))
+
+(defun compile-worker-loop (queue)
+  (loop for work = (mp:dequeue queue)
+        until (eq work :quit)
+        do (funcall work)))
+
+(defun compile-worker-pool ()
+  "Return the job queue of the compile worker pool, starting the workers if necessary."
+  (mp:with-lock (*compile-worker-pool-lock*)
+    (or *compile-worker-pool*
+        (let ((queue (mp:make-queue :name 'compile-file-parallel)))
+          (setf *compile-worker-threads*
+                (loop for thread-num below (core:num-logical-processors)
+                      collect (mp:process-run-function
+                               (format nil "compile-file-parallel-~a" thread-num)
+                               (lambda () (compile-worker-loop queue))
+                               nil))
+                *compile-worker-pool* queue)))))
+
+(defun shutdown-compile-worker-pool ()
+  "Stop the compile worker threads and wait for them to exit. The pool restarts on the next parallel compile."
+  (mp:with-lock (*compile-worker-pool-lock*)
+    (when *compile-worker-pool*
+      (dolist (thread *compile-worker-threads*)
+        (declare (ignore thread))
+        (mp:enqueue *compile-worker-pool* :quit))
+      (mapc #'mp:process-join *compile-worker-threads*)
+      (setf *compile-worker-pool* nil
+            *compile-worker-threads* nil))))
+
+(defvar *compile-file-parallel-max-pending-jobs* nil
+  "The most jobs one compile-file-parallel call may have waiting or running in the worker pool
+before the reader blocks. NIL means twice the number of workers.")
+
+;;; Tracks the jobs one compile-file call has submitted, so the reader can
+;;; be held back when it gets too far ahead and can wait for completion.
+(defstruct (compile-batch (:constructor make-compile-batch
+                              (limit &aux (lock (mp:make-lock :name "compile-batch"))
+                                          (changed (mp:make-condition-variable :name "compile-batch-changed")))))
+  limit (pending 0) lock changed)
+
+(defun compile-batch-submit (batch queue work)
+  (mp:with-lock ((compile-batch-lock batch))
+    (loop while (>= (compile-batch-pending batch) (compile-batch-limit batch))
+          do (mp:condition-variable-wait (compile-batch-changed batch) (compile-batch-lock batch)))
+    (incf (compile-batch-pending batch)))
+  (mp:enqueue queue work))
+
+(defun compile-batch-done (batch)
+  (mp:with-lock ((compile-batch-lock batch))
+    (decf (compile-batch-pending batch))
+    (mp:condition-variable-broadcast (compile-batch-changed batch))))
+
+(defun compile-batch-wait (batch)
+  (mp:with-lock ((compile-batch-lock batch))
+    (loop until (zerop (compile-batch-pending batch))
+          do (mp:condition-variable-wait (compile-batch-changed batch) (compile-batch-lock batch)))))
+
+(defun compile-job-bindings ()
+  "The special bindings of the current compile-file call that compile jobs must see."
+  (list (cons '*compile-print* *compile-print*)
+        (cons '*compile-file-parallel* *compile-file-parallel*)
+        (cons '*default-object-type* *default-object-type*)
+        (cons '*compile-verbose* *compile-verbose*)
+        (cons '*compile-file-output-pathname* *compile-file-output-pathname*)
+        (cons '*package* *package*)
+        (cons '*compile-file-pathname* *compile-file-pathname*)
+        (cons '*compile-file-truename* *compile-file-truename*)
+        #+cclasp(cons 'cleavir-cst-to-ast:*compiler* cleavir-cst-to-ast:*compiler*)
+        #+cclasp(cons 'core:*use-cleavir-compiler* core:*use-cleavir-compiler*)
+        (cons '*global-function-refs* *global-function-refs*)))
+
+(defun run-ast-job (ast-job &key compile-func optimize optimize-level intermediate-output-type write-bitcode)
+  (cfp-log "Thread ~a compiling form~%" (mp:process-name mp:*current-process*))
+  (block nil
+    (handler-bind
+        ((serious-condition
+           (lambda (e)
+             (setf (ast-job-serious-condition ast-job) e)
+             ;; Cannot continue with this job
+             (return)))
+         (warning
+           (lambda (w)
+             (push w (ast-job-warnings ast-job))
+             ;; Will be reported in the main thread instead.
+             (muffle-warning w)))
+         ((not (or serious-condition warning))
+           (lambda (c)
+             (push c (ast-job-other-conditions ast-job)))))
+      (funcall compile-func ast-job
+               :optimize optimize
+               :optimize-level optimize-level
+               :intermediate-output-type intermediate-output-type
+               :write-bitcode write-bitcode)))
+  (cfp-log "Thread ~a done with form~%" (mp:process-name mp:*current-process*)))
+
+(defun ast-job-work (ast-job batch bindings &rest job-options)
+  "Return the closure a worker runs to compile AST-JOB as part of BATCH."
+  (lambda ()
+    (unwind-protect
+         (progv (mapcar #'car bindings) (mapcar #'cdr bindings)
+           (apply #'run-ast-job ast-job job-options))
+      (compile-batch-done batch))))
 
 
 (defun cclasp-loop2 (source-sin
@@ -176,8 +502,9 @@ Boehm has a mutex and stack unwinding involves a mutex on linux.
 So as an experiment I tried doing AST->HIR and HIR->LLVM-IR in serial and 
 then leave the LLVM stuff to be done in parallel.   That slows down so much
 that it's not worth it either.   It would be better to improve the garbage collector (MPS)
-to work better in a multithreaded way.  There are also options for Boehm to improve
-multithreaded performance that we should explore."
+to work better in a multithreaded way.  Boehm marks with one thread per core
+(CLASP_GC_MARKERS changes that) and GCTOOLS:GC-PAUSE-STATISTICS shows how much time
+collections take."
   (let ((form-index (core:next-startup-position))
         (form-counter 0)
         (eof-value (gensym))
@@ -186,38 +513,16 @@ multithreaded performance that we should explore."
         #+cclasp(core:*use-cleavir-compiler* t)
         #+cclasp(eclector.reader:*client* clasp-cleavir::*cst-client*)
         #+cclasp(eclector.readtable:*readtable* cl:*readtable*)
+        (use-cache (and *compile-file-parallel-cache-directory*
+                        (eq intermediate-output-type :in-memory-object)
+                        (not compile-from-module)
+                        (not ast-only)))
+        (*form-cache-definitions* (make-hash-table :test #'eq))
         ast-jobs)
-    (cfp-log "Starting the pool of threads~%")
-    (finish-output)
-    (let* ((number-of-threads (core:num-logical-processors))
-           (ast-queue (core:make-queue 'compile-file-parallel))
-           ;; Setup a pool of threads
-           (ast-threads
-             (loop for thread-num below number-of-threads
-                   collect
-                   (mp:process-run-function
-                    (format nil "compile-file-parallel-~a" thread-num)
-                    (lambda ()
-                      (wait-for-ast-job ast-queue
-                                        :compile-func (if compile-from-module
-                                                          'compile-from-module
-                                                          'compile-from-ast)
-                                        :optimize optimize
-                                        :optimize-level optimize-level
-                                        :intermediate-output-type intermediate-output-type
-                                        :write-bitcode write-bitcode))
-                    `((*compile-print* . ',*compile-print*)
-                      (*compile-file-parallel* . ',*compile-file-parallel*)
-                      (*default-object-type* . ',*default-object-type*)
-                      (*compile-verbose* . ',*compile-verbose*)
-                      (*compile-file-output-pathname* . ',*compile-file-output-pathname*)
-                      (*package* . ',*package*)
-                      (*compile-file-pathname* . ',*compile-file-pathname*)
-                      (*compile-file-truename* . ',*compile-file-truename*)
-                      #+cclasp(cleavir-cst-to-ast:*compiler*
-                               . ',cleavir-cst-to-ast:*compiler*)
-                      #+cclasp(core:*use-cleavir-compiler* . ',core:*use-cleavir-compiler*)
-                      (*global-function-refs* . ',*global-function-refs*))))))
+    (let* ((queue (compile-worker-pool))
+           (batch (make-compile-batch (or *compile-file-parallel-max-pending-jobs*
+                                          (* 2 (length *compile-worker-threads*)))))
+           (bindings (compile-job-bindings)))
       (unwind-protect
            (loop
              ;; Required to update the source pos info. FIXME!?
@@ -232,6 +537,8 @@ multithreaded performance that we should explore."
                     (cst (eclector.concrete-syntax-tree:cst-read source-sin nil eof-value))
                     (_ (when (eq cst eof-value) (return nil)))
                     (form (cst:raw cst))
+                    (cache-symbols (and use-cache (form-cache-symbols form)))
+                    (cache-definitions (mapcar #'symbol-definitions cache-symbols))
                     (pre-ast
                       (if *debug-compile-file*
                           (with-compiler-timer ()
@@ -256,25 +563,44 @@ multithreaded performance that we should explore."
                    (let ((module (ast-job-to-module ast-job :optimize optimize :optimize-level optimize-level)))
                      (setf (ast-job-module ast-job) module)))
                  (when *compile-print* (describe-form form))
-                 (unless ast-only
-                   (push ast-job ast-jobs)
-                   (core:atomic-enqueue ast-queue ast-job))
+                 (let ((cached nil))
+                   (when use-cache
+                     (multiple-value-bind (dependencies redefined)
+                         (form-cache-dependencies cache-symbols cache-definitions)
+                       (let ((key (and (not (eq dependencies :unknown))
+                                       (form-cache-key form form-counter
+                                                       (form-cache-layout cst current-source-pos-info)
+                                                       dependencies optimize optimize-level))))
+                         (note-form-cache-definitions redefined key)
+                         (setf cached (and key (load-cached-form-object key current-source-pos-info)))
+                         (if cached
+                             (setf (ast-job-output-object ast-job) cached)
+                             (setf (ast-job-cache-key ast-job) key)))))
+                   (cond
+                     (cached (push ast-job ast-jobs))
+                     ((not ast-only)
+                      (push ast-job ast-jobs)
+                      (compile-batch-submit batch queue
+                                            (ast-job-work ast-job batch bindings
+                                                          :compile-func (if compile-from-module
+                                                                            'compile-from-module
+                                                                            'compile-from-ast)
+                                                          :optimize optimize
+                                                          :optimize-level optimize-level
+                                                          :intermediate-output-type intermediate-output-type
+                                                          :write-bitcode write-bitcode)))))
                  #+(or)
                  (compile-from-ast ast-job
                                    :optimize optimize
                                    :optimize-level optimize-level
                                    :intermediate-output-type intermediate-output-type))
                (incf form-counter)
-               (setf form-index (core:next-startup-position)))))
-      ;; Now send :quit messages to all threads
-      (loop for thread in ast-threads
-            do (cfp-log "Sending two :quit (why not?) for thread ~a~%" (mp:process-name thread))
-            do (core:atomic-enqueue ast-queue :quit)
-               (core:atomic-enqueue ast-queue :quit))
-      ;; Now wait for all threads to join
-      (loop for thread in ast-threads
-            do (mp:process-join thread)
-               (cfp-log "Process-join of thread ~a~%" (mp:process-name thread))))
+               (setf form-index (core:next-startup-position))))
+        ;; Wait for this file's jobs, also when reading fails, so that no
+        ;; worker is still compiling them once we return.
+        (compile-batch-wait batch)))
+    (when *compile-file-parallel-cache-directory*
+      (store-cached-form-objects ast-jobs))
     (dolist (job ast-jobs)
       (let ((*default-condition-origin*
               (ignore-errors (cleavir-ast:origin (ast-job-ast job)))))
@@ -463,16 +789,15 @@ Each bitcode filename will contain the form-index.")
 (defun cl:compile-file (input-file &rest args &key (output-type (default-library-type) output-type-p)
                                                 output-file (verbose *compile-verbose*) &allow-other-keys)
   (setf output-type (maybe-fixup-output-type output-type output-type-p))
+  ;; Forms compiled in parallel are separate modules that can't call
+  ;; each other directly, so LTO needs the serial compiler.
   (flet ((do-compile-file ()
-           (cond ((or output-type-p (null output-file))
-                  (if *compile-file-parallel*
-                      (apply #'compile-file-parallel input-file
-                             :output-type output-type args)
-                      (apply #'compile-file-serial input-file
-                             :output-type output-type args)))
-                 (t (if *compile-file-parallel*
-                        (apply #'compile-file-parallel input-file args)
-                        (apply #'compile-file-serial input-file args))))))
+           (let ((compiler (if (and *compile-file-parallel* (not *compile-file-lto*))
+                               #'compile-file-parallel
+                               #'compile-file-serial)))
+             (if (or output-type-p (null output-file))
+                 (apply compiler input-file :output-type output-type args)
+                 (apply compiler input-file args)))))
     (if verbose
         (time (do-compile-file))
         (do-compile-file))))
@@ -223,6 +223,17 @@ and the pathname of the source file - this will also be used as the module initi
       (funcall compile-file-hook source-sin environment)
       (bclasp-loop-read-and-compile-file-forms source-sin environment)))
 
+;;; Link-time optimization.
+;;; The serial compiler puts a whole file into one module, in which
+;;; calls to functions defined by earlier top level DEFUNs can be direct
+;;; calls (see the DIRECT-CALLS policy). With *COMPILE-FILE-LTO* that
+;;; module is optimized with OPTIMIZE-MODULE-FOR-LTO, which can inline
+;;; those functions into their callers across top level forms.
+(defvar *compile-file-lto* nil
+  "If true, compile-file compiles serially and optimizes each file as a whole,
+inlining small functions defined earlier in the file. Slower to compile;
+meant for release builds.")
+
 (defun compile-file-to-module (given-input-pathname
                                &key
                                  compile-file-hook
@@ -256,7 +267,10 @@ Compile a lisp source file into an LLVM module."
 	(bformat t "; Compiling file: %s%N" (namestring input-pathname)))
       (let (run-all-name)
         (with-module (:module module
-                      :optimize (when optimize #'optimize-module-for-compile-file)
+                      :optimize (when optimize
+                                  (if *compile-file-lto*
+                                      #'optimize-module-for-lto
+                                      #'optimize-module-for-compile-file))
                       :optimize-level optimize-level)
           ;; (1) Generate the code
           (with-debug-info-generator (:module *the-module*
@@ -630,6 +630,27 @@ The passed module is modified as a side-effect."
     (llvm-sys:remove-always-inline-functions module))
   module)
 
+;;; For a whole file compiled into one module with *COMPILE-FILE-LTO*,
+;;; or a system linked by LINK-FASOBC-MODULES-TO-FASO. This is
+;;; OPTIMIZE-MODULE-FOR-COMPILE-FILE with a cost based inliner instead
+;;; of the always-inliner, so that small functions reached by direct
+;;; calls get inlined into their callers. Like the other optimizers it
+;;; doesn't use the LTO pipeline: the module is not the whole program,
+;;; since it is linked against the running image when it's loaded.
+(defun optimize-module-for-lto (module &optional (optimize-level *optimization-level*) (size-level *size-level*))
+  (declare (type (or null llvm-sys:module) module))
+  (when (> optimize-level 0)
+    (let ((pass-manager-builder (llvm-sys:make-pass-manager-builder))
+          (mpm (llvm-sys:make-pass-manager)))
+      (llvm-sys:pass-manager-builder-setf-opt-level pass-manager-builder optimize-level)
+      (llvm-sys:pass-manager-builder-setf-size-level pass-manager-builder size-level)
+      (llvm-sys:pass-manager-builder-setf-inliner
+       pass-manager-builder (llvm-sys:create-function-inlining-pass optimize-level size-level nil))
+      (llvm-sys:populate-module-pass-manager pass-manager-builder mpm)
+      (llvm-sys:pass-manager-run mpm module))
+    (llvm-sys:remove-always-inline-functions module))
+  module)
+
 
 (defun optimize-module-for-compile (module)
   module)
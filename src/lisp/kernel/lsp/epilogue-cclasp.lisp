@@ -4,6 +4,9 @@
 #+cclasp
 (eval-when (:load-toplevel)
   (cl:in-package :cl-user)
+  ;; CLOS is compiled by now, so calls to generic functions can use
+  ;; per call site caches (see clos/call-site-cache.lisp).
+  (setf clos::*call-site-caches* t)
   (let ((core:*use-interpreter-for-eval* nil))
     (core:process-extension-loads)
     (core:maybe-load-clasprc)
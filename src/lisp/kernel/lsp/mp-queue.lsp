@@ -0,0 +1,295 @@
+;;;; -*- Mode: Lisp; Syntax: Common-Lisp; indent-tabs-mode: nil; Package: MP -*-
+;;;; vim: set filetype=lisp tabstop=8 shiftwidth=2 expandtab:
+
+;;;;
+;;;;  MP-QUEUE.LSP  -- Multi-producer/multi-consumer queues.
+;;;;
+;;;;  A queue is a linked list of fixed size segments. Producers claim
+;;;;  slots at the tail segment and consumers claim slots at the head
+;;;;  segment with a compare-and-swap of the segment's index, so neither
+;;;;  side takes a lock or conses per element. Each slot is written and
+;;;;  read exactly once; a segment that has been filled is followed by a
+;;;;  fresh one rather than recycled, which is what lets producers and
+;;;;  consumers move on to the next segment without coordinating.
+;;;;
+;;;;  Threads only take the queue's lock to park on one of its condition
+;;;;  variables, when the queue is empty (consumers) or a bounded queue is
+;;;;  full (producers), and the other side only takes it to wake them when
+;;;;  it sees somebody waiting.
+
+(in-package "MP")
+
+(export '(queue queue-p make-queue queue-name queue-capacity
+          enqueue enqueue-batch dequeue dequeue-batch
+          queue-count queue-empty-p))
+
+;;; Layout of a segment. The indices are spread out so that producers
+;;; and consumers don't bounce the same cache line between them.
+(defconstant +segment-enqueue-index+ 0)
+(defconstant +segment-dequeue-index+ 8)
+(defconstant +segment-next+ 16)
+(defconstant +segment-slots-start+ 24)
+(defconstant +segment-slots+ 256)
+
+;;; Layout of the shared state of a queue.
+(defconstant +queue-head+ 0)
+(defconstant +queue-tail+ 8)
+(defconstant +queue-count+ 16)
+(defconstant +queue-waiting-consumers+ 24)
+(defconstant +queue-waiting-producers+ 32)
+(defconstant +queue-state-size+ 33)
+
+(defun make-segment ()
+  ;; A slot that hasn't been written yet holds the segment itself,
+  ;; which is something no client can enqueue.
+  (let ((segment (make-array (+ +segment-slots-start+ +segment-slots+) :initial-element 0)))
+    (fill segment segment :start +segment-slots-start+)
+    (setf (svref segment +segment-next+) nil)
+    segment))
+
+(defstruct (queue (:constructor %make-queue (name capacity state lock not-empty not-full))
+                  (:copier nil))
+  name capacity state lock not-empty not-full)
+
+(defun make-queue (&key name capacity)
+  "Return a new multi-producer/multi-consumer queue.
+CAPACITY is NIL for an unbounded queue, or the number of elements the queue
+holds before ENQUEUE has to wait for a consumer."
+  (check-type capacity (or null (integer 1)))
+  (let ((state (make-array +queue-state-size+ :initial-element 0))
+        (segment (make-segment)))
+    (setf (svref state +queue-head+) segment
+          (svref state +queue-tail+) segment)
+    (%make-queue name capacity state
+                 (make-lock :name (format nil "~a-LOCK" name))
+                 (make-condition-variable :name (format nil "~a-NOT-EMPTY" name))
+                 (make-condition-variable :name (format nil "~a-NOT-FULL" name)))))
+
+(defun reserve-room (queue n)
+  "Reserve room for up to N elements in QUEUE and return how many were reserved."
+  (let ((capacity (queue-capacity queue)))
+    (if (null capacity)
+        n
+        (let ((state (queue-state queue)))
+          (loop (let* ((count (atomic (svref state +queue-count+)))
+                       (room (min n (- capacity count))))
+                  (when (<= room 0) (return 0))
+                  (when (eq count (cas (svref state +queue-count+) count (+ count room)))
+                    (return room))))))))
+
+(defun claim-enqueue-slots (state n)
+  "Claim up to N consecutive slots at the tail of the queue.
+Return the segment, the index of the first slot and the number of slots claimed."
+  (loop (let* ((segment (atomic (svref state +queue-tail+)))
+               (index (atomic (svref segment +segment-enqueue-index+))))
+          (if (< index +segment-slots+)
+              (let ((claimed (min n (- +segment-slots+ index))))
+                (when (eq index (cas (svref segment +segment-enqueue-index+) index (+ index claimed)))
+                  (return (values segment (+ +segment-slots-start+ index) claimed))))
+              ;; The segment is full - link a fresh one (unless another producer
+              ;; already did) and help move the tail forward.
+              (let ((next (atomic (svref segment +segment-next+))))
+                (when (null next)
+                  (let ((fresh (make-segment)))
+                    (setf next (or (cas (svref segment +segment-next+) nil fresh) fresh))))
+                (cas (svref state +queue-tail+) segment next))))))
+
+(defun claim-dequeue-slots (state n)
+  "Claim up to N consecutive slots at the head of the queue that producers have claimed.
+Return the segment, the index of the first slot and the number of slots claimed,
+which is zero if the queue is empty."
+  (loop (let* ((segment (atomic (svref state +queue-head+)))
+               (index (atomic (svref segment +segment-dequeue-index+)))
+               (limit (atomic (svref segment +segment-enqueue-index+))))
+          (cond ((< index limit)
+                 (let ((claimed (min n (- limit index))))
+                   (when (eq index (cas (svref segment +segment-dequeue-index+) index (+ index claimed)))
+                     (return (values segment (+ +segment-slots-start+ index) claimed)))))
+                ((< index +segment-slots+)
+                 (return (values segment 0 0)))
+                (t
+                 (let ((next (atomic (svref segment +segment-next+))))
+                   (if next
+                       (cas (svref state +queue-head+) segment next)
+                       (return (values segment 0 0)))))))))
+
+(defun take-slot (segment slot)
+  ;; The producer that claimed SLOT may not have stored into it yet.
+  (loop for item = (atomic (svref segment slot) :order :acquire)
+        while (eq item segment)
+        do (process-yield)
+        finally (setf (svref segment slot) nil)
+                (return item)))
+
+(defun %try-enqueue-batch (queue items start end)
+  "Store as many of the elements of the simple-vector ITEMS from START below END
+as fit into QUEUE without waiting. Return the index of the first element not stored."
+  (let ((state (queue-state queue))
+        (limit (+ start (reserve-room queue (- end start)))))
+    (loop while (< start limit)
+          do (multiple-value-bind (segment slot claimed)
+                 (claim-enqueue-slots state (- limit start))
+               (dotimes (i claimed)
+                 (setf (atomic (svref segment (+ slot i)) :order :release)
+                       (svref items (+ start i))))
+               (incf start claimed)))
+    limit))
+
+(defun %try-enqueue (queue item)
+  (when (plusp (reserve-room queue 1))
+    (multiple-value-bind (segment slot)
+        (claim-enqueue-slots (queue-state queue) 1)
+      (setf (atomic (svref segment slot) :order :release) item))
+    t))
+
+(defun %try-dequeue-batch (queue max)
+  "Remove up to MAX elements from QUEUE without waiting.
+Return a list of them, oldest first, and how many there are."
+  (let ((state (queue-state queue))
+        (result nil)
+        (count 0))
+    (loop while (< count max)
+          do (multiple-value-bind (segment slot claimed)
+                 (claim-dequeue-slots state (- max count))
+               (when (zerop claimed) (return))
+               (dotimes (i claimed)
+                 (push (take-slot segment (+ slot i)) result))
+               (incf count claimed)))
+    (values (nreverse result) count)))
+
+(defun %try-dequeue (queue)
+  (multiple-value-bind (segment slot claimed)
+      (claim-dequeue-slots (queue-state queue) 1)
+    (if (zerop claimed)
+        (values nil nil)
+        (values (take-slot segment slot) t))))
+
+(defun wake-waiters (queue waiting-index condition-variable all)
+  (when (plusp (atomic (svref (queue-state queue) waiting-index)))
+    (with-lock ((queue-lock queue))
+      (if all
+          (condition-variable-broadcast condition-variable)
+          (condition-variable-signal condition-variable)))))
+
+(defun note-enqueued (queue n)
+  (wake-waiters queue +queue-waiting-consumers+ (queue-not-empty queue) (> n 1)))
+
+(defun note-dequeued (queue n)
+  (when (queue-capacity queue)
+    (atomic-decf (svref (queue-state queue) +queue-count+) n)
+    (wake-waiters queue +queue-waiting-producers+ (queue-not-full queue) (> n 1))))
+
+(defun timeout-deadline (timeout)
+  (and timeout
+       (+ (get-internal-real-time) (round (* timeout internal-time-units-per-second)))))
+
+(defun wait-until (queue waiting-index condition-variable timeout attempt)
+  "Call ATTEMPT with the queue lock held until it returns true, waiting on
+CONDITION-VARIABLE between tries. Return the value of ATTEMPT, or NIL once
+TIMEOUT seconds have passed (never, if TIMEOUT is NIL)."
+  (let ((state (queue-state queue))
+        (lock (queue-lock queue))
+        (deadline (timeout-deadline timeout)))
+    ;; Announce ourselves before the last try, so that the other side
+    ;; either sees us waiting or made its change before that try.
+    (atomic-incf (svref state waiting-index))
+    (unwind-protect
+         (with-lock (lock)
+           (loop (let ((result (funcall attempt)))
+                   (when result (return result)))
+                 (if deadline
+                     (let ((remaining (- deadline (get-internal-real-time))))
+                       (when (<= remaining 0) (return nil))
+                       (condition-variable-timedwait condition-variable lock
+                                                     (/ remaining (float internal-time-units-per-second 1d0))))
+                     (condition-variable-wait condition-variable lock))))
+      (atomic-decf (svref state waiting-index)))))
+
+(defun no-wait-p (timeout)
+  (and timeout (<= timeout 0)))
+
+(defun enqueue (queue item &key timeout)
+  "Add ITEM to the end of QUEUE and return true.
+If QUEUE is bounded and full, wait up to TIMEOUT seconds (forever if TIMEOUT is NIL)
+for a consumer to make room, and return NIL if none did."
+  (when (or (%try-enqueue queue item)
+            (and (not (no-wait-p timeout))
+                 (wait-until queue +queue-waiting-producers+ (queue-not-full queue) timeout
+                             (lambda () (%try-enqueue queue item)))))
+    (note-enqueued queue 1)
+    t))
+
+(defun enqueue-batch (queue items &key timeout)
+  "Add the elements of the sequence ITEMS to the end of QUEUE, in order, and
+return how many were added. Consecutive elements are claimed together, but
+elements from other producers may end up in between them.
+If QUEUE is bounded and full, wait up to TIMEOUT seconds (forever if TIMEOUT is NIL)
+for room for the remaining elements."
+  (let* ((items (coerce items 'simple-vector))
+         (end (length items))
+         (start (%try-enqueue-batch queue items 0 end)))
+    (when (and (< start end) (not (no-wait-p timeout)))
+      (let ((deadline (timeout-deadline timeout)))
+        (loop while (< start end)
+              do (unless (wait-until queue +queue-waiting-producers+ (queue-not-full queue)
+                                     (and deadline
+                                          (/ (- deadline (get-internal-real-time))
+                                             (float internal-time-units-per-second 1d0)))
+                                     (lambda ()
+                                          (let ((next (%try-enqueue-batch queue items start end)))
+                                            (when (> next start)
+                                              (setf start next)))))
+                   (return)))))
+    (when (plusp start)
+      (note-enqueued queue start))
+    start))
+
+(defun dequeue (queue &key timeout)
+  "Remove and return the element at the front of QUEUE. The second value is true
+if there was one. If QUEUE is empty, wait up to TIMEOUT seconds (forever if TIMEOUT
+is NIL) for a producer, and return NIL and NIL if none came."
+  (multiple-value-bind (item found)
+      (%try-dequeue queue)
+    (unless found
+      (let ((box (and (not (no-wait-p timeout))
+                      (wait-until queue +queue-waiting-consumers+ (queue-not-empty queue) timeout
+                                  (lambda ()
+                                    (multiple-value-bind (item found)
+                                        (%try-dequeue queue)
+                                      (and found (list item))))))))
+        (setf item (car box) found (not (null box)))))
+    (when found
+      (note-dequeued queue 1))
+    (values item found)))
+
+(defun dequeue-batch (queue max &key timeout)
+  "Remove up to MAX elements from the front of QUEUE and return them as a list,
+oldest first. If QUEUE is empty, wait up to TIMEOUT seconds (forever if TIMEOUT is NIL)
+for at least one element, and return NIL if none came."
+  (check-type max (integer 1))
+  (multiple-value-bind (items count)
+      (%try-dequeue-batch queue max)
+    (when (and (zerop count) (not (no-wait-p timeout)))
+      (setf items (wait-until queue +queue-waiting-consumers+ (queue-not-empty queue) timeout
+                              (lambda () (%try-dequeue-batch queue max)))
+            count (length items)))
+    (when (plusp count)
+      (note-dequeued queue count))
+    items))
+
+(defun queue-count (queue)
+  "Return the number of elements in QUEUE.
+The result may be out of date as soon as it is returned if other threads
+are using the queue."
+  (let ((state (queue-state queue)))
+    (if (queue-capacity queue)
+        (atomic (svref state +queue-count+))
+        (loop for segment = (atomic (svref state +queue-head+))
+                then (atomic (svref segment +segment-next+))
+              while segment
+              sum (- (atomic (svref segment +segment-enqueue-index+))
+                     (atomic (svref segment +segment-dequeue-index+)))))))
+
+(defun queue-empty-p (queue)
+  "Return true if QUEUE has no elements. Like QUEUE-COUNT, the answer may be out of date."
+  (zerop (queue-count queue)))
@@ -303,3 +303,87 @@ the result."
 Returns an integer represented by the bit sequence obtained by replacing the
 specified bits of INTEGER2 with the specified bits of INTEGER1."
   (%deposit-field newbyte (byte-size bytespec) (byte-position bytespec) integer))
+
+;;; Exact summation.  The accumulator keeps an unnormalized
+;;; numerator/denominator pair so that adding rationals with the same
+;;; denominator (e.g. amounts of cents) costs one integer addition and no
+;;; gcd, and only normalizes when the value is extracted.  Floats are added
+;;; with their exact rational values, so the sum of floats is correctly
+;;; rounded once at the end instead of at every step.  Sequences are summed
+;;; in C++ by CORE:EXACT-SUM without consing intermediate results.
+
+(export '(ext::make-sum-accumulator ext::sum-accumulator-p
+          ext::sum-accumulator-add ext::sum-accumulator-add-sequence
+          ext::sum-accumulator-value)
+        "EXT")
+
+(defstruct (sum-accumulator (:constructor %make-sum-accumulator ())
+                            (:predicate ext:sum-accumulator-p)
+                            (:copier nil))
+  (numerator 0 :type integer)
+  (denominator 1 :type (integer 1))
+  ;; The widest float added so far, or NIL if only rationals were added.
+  (float-prototype nil))
+
+(defun ext:make-sum-accumulator ()
+  "Return an accumulator for exact summation - see SUM-ACCUMULATOR-ADD."
+  (%make-sum-accumulator))
+
+(defun sum-accumulator-add-rational (accumulator rational)
+  (let ((n (numerator rational))
+        (d (denominator rational))
+        (den (sum-accumulator-denominator accumulator)))
+    (cond ((= d den)
+           (incf (sum-accumulator-numerator accumulator) n))
+          ((zerop (rem den d))
+           (incf (sum-accumulator-numerator accumulator) (* n (truncate den d))))
+          (t
+           ;; Switch to the lcm of the denominators.
+           (let* ((g (gcd den d))
+                  (dg (truncate d g)))
+             (setf (sum-accumulator-numerator accumulator)
+                   (+ (* (sum-accumulator-numerator accumulator) dg)
+                      (* n (truncate den g)))
+                   (sum-accumulator-denominator accumulator) (* den dg))))))
+  accumulator)
+
+(defun sum-accumulator-note-float (accumulator float)
+  (let ((prototype (sum-accumulator-float-prototype accumulator)))
+    (when (or (null prototype)
+              (> (float-digits float) (float-digits prototype)))
+      (setf (sum-accumulator-float-prototype accumulator) float))))
+
+(defun ext:sum-accumulator-add (accumulator number)
+  "Add the rational or finite float NUMBER to ACCUMULATOR exactly and return ACCUMULATOR."
+  (etypecase number
+    (rational (sum-accumulator-add-rational accumulator number))
+    (float
+     (sum-accumulator-add-rational accumulator (rational number))
+     (sum-accumulator-note-float accumulator number)
+     accumulator)))
+
+(defun ext:sum-accumulator-add-sequence (accumulator sequence &key (start 0) end)
+  "Add the elements of the list or vector SEQUENCE between START and END to
+ACCUMULATOR exactly and return ACCUMULATOR."
+  (with-start-end (start end sequence)
+    (multiple-value-bind (sum index prototype)
+        (exact-sum sequence start end t)
+      (sum-accumulator-add-rational accumulator sum)
+      (when prototype
+        (sum-accumulator-note-float accumulator prototype))
+      (when (< index end)
+        ;; Not a rational or a finite float - let SUM-ACCUMULATOR-ADD
+        ;; signal the error.
+        (ext:sum-accumulator-add accumulator (elt sequence index))
+        (ext:sum-accumulator-add-sequence accumulator sequence
+                                          :start (1+ index) :end end))))
+  accumulator)
+
+(defun ext:sum-accumulator-value (accumulator)
+  "Return the sum of the numbers added to ACCUMULATOR.  If only rationals
+were added this is the exact rational sum, otherwise it is the exact sum
+rounded once to the widest float format that was added."
+  (let ((sum (/ (sum-accumulator-numerator accumulator)
+                (sum-accumulator-denominator accumulator)))
+        (prototype (sum-accumulator-float-prototype accumulator)))
+    (if prototype (float sum prototype) sum)))
@@ -112,6 +112,37 @@
     (setf initial-value
           (funcall function initial-value (funcall key elt)))))
 
+;;; The exact parts of REDUCE are done in C++ without calling FUNCTION
+;;; for every element.  This is only done where it gives the same result
+;;; as the left to right fold: exact reductions, with no key and a
+;;; rational initial value (a float initial value would make every step
+;;; of #'+ a float addition).
+(defun exact-reduce (function sequence key start end from-end
+                     initial-value ivsp)
+  "Integer vectors are reduced with #'+, #'min or #'max in C++.  With #'+
+the leading rationals of any list or vector are summed exactly with an
+accumulator that doesn't cons intermediate results.  Returns the result
+so far and the index of the first element that still has to be folded
+in, or NIL if nothing could be done."
+  (when (and (eq key #'identity)
+             (or (not ivsp) (rationalp initial-value)))
+    (let ((op (cond ((eq function #'+) '+)
+                    ((eq function #'min) 'min)
+                    ((eq function #'max) 'max))))
+      (when op
+        (multiple-value-bind (result nativep)
+            (if (vectorp sequence)
+                (reduce-integer-vector op sequence start end)
+                (values nil nil))
+          (cond (nativep
+                 (values (if ivsp (funcall function initial-value result) result)
+                         end))
+                ((and (eq op '+) (not from-end))
+                 (multiple-value-bind (sum index)
+                     (exact-sum sequence start end nil)
+                   (when (> index start)
+                     (values (if ivsp (+ initial-value sum) sum) index))))))))))
+
 (defun reduce (function sequence
                &rest args
                &key from-end
@@ -125,26 +156,42 @@
              (with-key (key)
                (if (>= start end)
                    (if ivsp initial-value (funcall function))
-                   (if from-end
-                       (list-reduce-from-end function sequence
+                   (multiple-value-bind (result next)
+                       (exact-reduce function sequence key start end from-end
+                                     initial-value ivsp)
+                     (cond ((null next)
+                            (if from-end
+                                (list-reduce-from-end function sequence
+                                                      key start end
+                                                      initial-value ivsp)
+                                (list-reduce function sequence
                                              key start end
-                                             initial-value ivsp)
-                       (list-reduce function sequence
-                                    key start end
-                                    initial-value ivsp)))))))
+                                             initial-value ivsp)))
+                           ((>= next end) result)
+                           (t (list-reduce function sequence
+                                           key next end
+                                           result t)))))))))
         ((vectorp sequence)
          (let ((function (coerce-fdesignator function)))
            (with-start-end (start end sequence)
              (with-key (key)
                (if (>= start end)
                    (if ivsp initial-value (funcall function))
-                   (if from-end
-                       (vector-reduce-from-end function sequence
+                   (multiple-value-bind (result next)
+                       (exact-reduce function sequence key start end from-end
+                                     initial-value ivsp)
+                     (cond ((null next)
+                            (if from-end
+                                (vector-reduce-from-end function sequence
+                                                        key start end
+                                                        initial-value ivsp)
+                                (vector-reduce function sequence
                                                key start end
-                                               initial-value ivsp)
-                       (vector-reduce function sequence
-                                      key start end
-                                      initial-value ivsp)))))))
+                                               initial-value ivsp)))
+                           ((>= next end) result)
+                           (t (vector-reduce function sequence
+                                             key next end
+                                             result t)))))))))
         (t (apply #'sequence:reduce function sequence args))))
 
 (defun fill (sequence item &rest args &key (start 0) end)
@@ -539,6 +586,14 @@
 
 
 (defun position (item sequence &key test test-not from-end (start 0) end key)
+  (when (and (characterp item) (stringp sequence)
+             (null test-not) (null key)
+             (or (null test) (eq test #'eql) (eq test 'eql)
+                 (eq test #'char=) (eq test 'char=)))
+    ;; Characters in strings are searched for directly in the string storage
+    (with-start-end (start end sequence)
+      (return-from position
+        (position-character item sequence start end from-end))))
   (with-tests (test test-not key)
     (declare (optimize (speed 3) (safety 0) (debug 0)))
     (with-start-end (start end sequence)
@@ -872,9 +927,48 @@ elements X and Y is arbitrary if both
 evaluates to NIL.  See STABLE-SORT."
   (setf key (if key (coerce-fdesignator key) #'identity)
 	predicate (coerce-fdesignator predicate))
-  (if (listp sequence)
-      (list-merge-sort sequence predicate key)
-      (quick-sort sequence 0 (the fixnum (1- (length sequence))) predicate key)))
+  (cond ((listp sequence)
+         (if (native-list-sort sequence predicate key)
+             sequence
+             (list-merge-sort sequence predicate key)))
+        ((native-vector-sort sequence predicate key nil) sequence)
+        (t (quick-sort sequence 0 (the fixnum (1- (length sequence))) predicate key))))
+
+(defun native-vector-sort (vector predicate key stable)
+  "Sort VECTOR in C++ when it is specialized on a numeric type and the
+predicate is #'< or #'> with no key, so that no predicate calls are made.
+Returns T if VECTOR was sorted."
+  (and (eq key #'identity)
+       (or (eq predicate #'<) (eq predicate #'>))
+       (sort-specialized-vector vector (eq predicate #'>) stable)))
+
+(defun native-list-sort (list predicate key)
+  "Sort a long LIST of fixnums with #'< or #'> and no key by copying
+the elements into a fixnum vector and sorting that natively.  The sorted
+elements are stored back into the conses of LIST.  Returns T if LIST was sorted."
+  (declare (optimize (speed 3) (safety 0)))
+  (when (and (eq key #'identity)
+             (or (eq predicate #'<) (eq predicate #'>)))
+    (let ((length 0))
+      (declare (fixnum length))
+      (dolist (elt list)
+        (unless (typep elt 'fixnum) (return-from native-list-sort nil))
+        (incf length))
+      ;; Short lists aren't worth the temporary vector
+      (when (< length 16) (return-from native-list-sort nil))
+      (let ((vector (make-array length :element-type 'fixnum)))
+        (do ((cur list (cdr cur))
+             (i 0 (1+ i)))
+            ((null cur))
+          (declare (fixnum i))
+          (setf (aref vector i) (car cur)))
+        (sort-specialized-vector vector (eq predicate #'>) nil)
+        (do ((cur list (cdr cur))
+             (i 0 (1+ i)))
+            ((null cur))
+          (declare (fixnum i))
+          (rplaca cur (aref vector i)))
+        t))))
 
 
 (defun list-merge-sort (l predicate key)
@@ -887,10 +981,9 @@ evaluates to NIL.  See STABLE-SORT."
 	   ((= i 2)
 	    (setq key-left (funcall key (car l)))
 	    (setq key-right (funcall key (cadr l)))
-	    (cond ((funcall predicate key-left key-right) (return l))
-		  ((funcall predicate key-right key-left)
-		   (return (nreverse l)))
-		  (t (return l)))))
+	    (if (funcall predicate key-right key-left)
+                (return (nreverse l))
+                (return l))))
      (setq i (floor i 2))
      (do ((j 1 (1+ j)) (l1 l (cdr l1)))
 	 ((>= j i)
@@ -907,9 +1000,9 @@ evaluates to NIL.  See STABLE-SORT."
      (setq key-left (funcall key (car left)))
      (setq key-right (funcall key (car right)))
    loop
-     (cond ((funcall predicate key-left key-right) (go left))
-	   ((funcall predicate key-right key-left) (go right))
-	   (t (go left)))
+     ;; Take from the right only if it strictly precedes the left,
+     ;; this keeps the merge stable with one predicate call per element.
+     (if (funcall predicate key-right key-left) (go right) (go left))
    left
      (rplacd l1 left)
      (setq l1 (cdr l1))
@@ -1070,7 +1163,10 @@ SEQUENCE.  See SORT."
   (setf key (if key (coerce-fdesignator key) #'identity)
         predicate (coerce-fdesignator predicate))
   (cond ((listp sequence)
-         (list-merge-sort sequence predicate key))
+         (if (native-list-sort sequence predicate key)
+             sequence
+             (list-merge-sort sequence predicate key)))
+        ((native-vector-sort sequence predicate key t) sequence)
         ;; TODO: We can actually do this for any non-general vector,
         ;; as the elements essentially lack discernable identities.
         ((or (stringp sequence) (bit-vector-p sequence))
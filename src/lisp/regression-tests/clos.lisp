@@ -128,3 +128,53 @@
  
 
 
+
+(defclass %allocated-standard ()
+  ((a :initarg :a :accessor %allocated-standard-a)
+   (b :initform 42)))
+(test allocate-instance-standard-class
+      (let ((fresh (allocate-instance (find-class '%allocated-standard)))
+            (made (make-instance '%allocated-standard :a 1)))
+        (and (not (slot-boundp fresh 'a))
+             (not (slot-boundp fresh 'b))
+             (eql (%allocated-standard-a made) 1)
+             (eql (slot-value made 'b) 42)
+             (eq (class-of fresh) (find-class '%allocated-standard)))))
+
+(eval-when (:compile-toplevel :load-toplevel :execute)
+  (defclass %sealed-shape () ((name :initform :shape :accessor %sealed-shape-name)))
+  (defclass %sealed-circle (%sealed-shape) ((radius :initarg :radius :accessor %sealed-radius)))
+  (defgeneric %sealed-area (shape))
+  (defmethod %sealed-area ((s %sealed-shape)) 0)
+  (defmethod %sealed-area ((c %sealed-circle)) (* 3 (%sealed-radius c) (%sealed-radius c)))
+  (clos:seal-class '%sealed-shape)
+  (clos:seal-generic-function '%sealed-area)
+  (clos:seal-generic-function '%sealed-radius)
+  (clos:seal-generic-function '(setf %sealed-radius)))
+(defun %sealed-use (c)
+  (setf (%sealed-radius c) (1+ (%sealed-radius c)))
+  (list (%sealed-area c) (%sealed-area (make-instance '%sealed-shape))))
+(test sealed-dispatch
+      (equal (%sealed-use (make-instance '%sealed-circle :radius 1)) '(12 0)))
+(test-expect-error sealed-slot-unbound
+                   (%sealed-radius (make-instance '%sealed-circle)))
+(test-expect-error sealed-generic-function-add-method
+                   (eval '(defmethod %sealed-area ((x integer)) x)))
+(test-expect-error sealed-generic-function-replace-accessor
+                   (eval '(defmethod %sealed-radius ((c %sealed-circle)) 99)))
+(test-expect-error sealed-class-subclass
+                   (eval '(defclass %sealed-square (%sealed-shape) ())))
+;;; Loading a file compiled in the same image redefines things as they were.
+(test sealed-identical-redefinition
+      (progn
+        (eval '(defclass %sealed-circle (%sealed-shape)
+                ((radius :initarg :radius :accessor %sealed-radius))))
+        (eval '(defmethod %sealed-area ((s %sealed-shape)) 0))
+        (equal (%sealed-use (make-instance '%sealed-circle :radius 1)) '(12 0))))
+(test-expect-error sealed-class-slot-change
+                   (eval '(defclass %sealed-circle (%sealed-shape)
+                           ((radius :initarg :radius :accessor %sealed-radius)
+                            (center :initform nil)))))
+(test sealed-class-leaves-standard-object-alone
+      (not (or (gethash (find-class 'standard-object) clos::*sealed-classes*)
+               (gethash (find-class t) clos::*sealed-classes*))))
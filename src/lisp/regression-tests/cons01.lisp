@@ -127,3 +127,36 @@
 
 (test-expect-error LIST-LENGTH-SYMBOL (LIST-LENGTH 'A) :type type-error)
 (test-expect-error LIST-LENGTH.ERROR.1 (list-length '(1 . 2)) :type type-error)
+
+(test dx-rest-list-reads
+      (let ((f (compile nil '(lambda (&rest args)
+                              (let ((sum 0))
+                                (dolist (x args (+ sum (length args)))
+                                  (incf sum x)))))))
+        (and (= (funcall f 1 2 3) 9)
+             (= (funcall f) 0)
+             (= (apply f (make-list 100 :initial-element 1)) 200))))
+
+(test dx-rest-list-escapes
+      ;; Returning a tail of the &rest list must still give a heap list.
+      (let* ((f (compile nil '(lambda (&rest args) (cdr args))))
+             (tail (funcall f 1 2 3)))
+        (gctools:garbage-collect)
+        (equal tail '(2 3))))
+
+(test dx-local-lists
+      (let ((f (compile nil '(lambda (a b)
+                              (let ((pair (cons a b))
+                                    (l (list a b a)))
+                                (+ (car pair) (cdr pair) (length l) (third l)))))))
+        (= (funcall f 1 2) 7)))
+
+(test dx-rest-list-getf-default
+      ;; GETF and REDUCE can return the &rest list itself.
+      (let* ((f (compile nil '(lambda (&rest args) (getf '(:a 1) :b args))))
+             (g (compile nil '(lambda (&rest args)
+                               (reduce #'+ '() :initial-value args))))
+             (l1 (funcall f 1 2))
+             (l2 (funcall g 3 4)))
+        (gctools:garbage-collect)
+        (and (equal l1 '(1 2)) (equal l2 '(3 4)))))
@@ -134,3 +134,64 @@
         (let ((c (cons nil nil)))
           (setf (macro-place-pre c) t)
           (cdr c))))
+
+;;; Calls to functions defined earlier in the file may be direct calls
+;;; when speed matters more than debug. Check argument passing.
+(defun direct-callee (a &optional (b 2) &rest more) (list* a b more))
+
+(defun direct-caller ()
+  (declare (optimize (speed 3) (debug 0)))
+  (list (direct-callee 1) (direct-callee 1 3) (direct-callee 1 3 4 5)))
+
+(test direct-call-arguments
+      (equal (direct-caller) '((1 2) (1 3) (1 3 4 5))))
+
+;;; Only the function a top level DEFUN installs is a direct call
+;;; target, not local functions or nested DEFUNs with the same name,
+;;; and a second DEFUN of a name stops direct calls to it.
+(defun direct-shadowed () :global)
+(defun direct-shadowing ()
+  (labels ((direct-shadowed () :local)) (direct-shadowed)))
+(defun direct-nested () :toplevel)
+(defun direct-nested-outer ()
+  (defun direct-nested () :nested))
+(defun direct-redefined () 1)
+(defun direct-redefined () 2)
+
+(defun direct-shadow-caller ()
+  (declare (optimize (speed 3) (debug 0)))
+  (list (direct-shadowing) (direct-shadowed) (direct-nested) (direct-redefined)))
+
+(test direct-call-targets
+      (equal (direct-shadow-caller) '(:local :global :toplevel 2)))
+
+;;; Functions with &rest or &key have separate entries for small
+;;; argument counts; make sure each count still parses correctly.
+(defun fast-entry-rest (a &optional (b :b) &rest more) (list* a b more))
+(defun fast-entry-key (a &optional b &key (c :c) (d :d d-p)) (list a b c d d-p))
+
+(test fast-entry-rest
+      (equal (list (fast-entry-rest 1) (fast-entry-rest 1 2) (fast-entry-rest 1 2 3)
+                   (fast-entry-rest 1 2 3 4) (fast-entry-rest 1 2 3 4 5))
+             '((1 :b) (1 2) (1 2 3) (1 2 3 4) (1 2 3 4 5))))
+(test fast-entry-key
+      (equal (list (fast-entry-key 1) (fast-entry-key 1 2)
+                   (fast-entry-key 1 2 :d 4) (fast-entry-key 1 2 :c 3 :d nil))
+             '((1 nil :c :d nil) (1 2 :c :d nil) (1 2 :c 4 t) (1 2 3 nil t))))
+(test-expect-error fast-entry-key-odd (fast-entry-key 1 2 :c))
+
+;;; Constant keyword arguments to known functions are matched up at
+;;; compile time.
+(defun known-key-callee (a &rest r &key (b :b) (c :c c-p)) (list a r b c c-p))
+
+(defun known-key-caller ()
+  (declare (optimize (speed 3) (debug 0)))
+  (list (known-key-callee 1) (known-key-callee 1 :c 3 :b 2 :c 4)))
+
+(test known-key-call
+      (equal (known-key-caller)
+             '((1 nil :b :c nil) (1 (:c 3 :b 2 :c 4) 2 3 t))))
+(test local-key-call
+      (flet ((f (&key (x 1) (y 2)) (list x y)))
+        (declare (notinline f))
+        (equal (list (f) (f :y 3) (f :x 4 :y 5 :x 6)) '((1 2) (1 3) (4 5)))))
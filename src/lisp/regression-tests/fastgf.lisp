@@ -5,3 +5,49 @@
 (defmethod fgf-foo ((x symbol)) :symbol)
 (test dispatch-symbol (eq (fgf-foo :yadda) :symbol))
 (test-expect-error dispatch-no-applicable-method (fgf-foo 1.2) :description "This should not dispatch")
+
+;;; Call site caches must miss when the classes or methods change.
+(defgeneric fgf-csc (x))
+(defmethod fgf-csc ((x integer)) :integer)
+(defmethod fgf-csc ((x symbol)) :symbol)
+(defun fgf-csc-call (x)
+  (declare (optimize (speed 3) (space 0)))
+  (fgf-csc x))
+(test call-site-cache-polymorphic
+      (equal (mapcar #'fgf-csc-call '(1 2 a b 3))
+             '(:integer :integer :symbol :symbol :integer)))
+(defmethod fgf-csc ((x null)) :null)
+(test call-site-cache-invalidated
+      (equal (mapcar #'fgf-csc-call '(1 a nil))
+             '(:integer :symbol :null)))
+(defmethod fgf-csc ((x string)) :string)
+(defmethod fgf-csc ((x character)) :character)
+(defmethod fgf-csc ((x cons)) :cons)
+(test call-site-cache-megamorphic
+      (equal (mapcar #'fgf-csc-call '(1 a "s" #\c (1) nil 2 b))
+             '(:integer :symbol :string :character :cons :null :integer :symbol)))
+
+;;; EQL specializers can't be cached, so the site goes back to calling
+;;; the generic function.
+(defgeneric fgf-csc-eql (x))
+(defmethod fgf-csc-eql ((x (eql 1))) :one)
+(defmethod fgf-csc-eql ((x integer)) :integer)
+(defun fgf-csc-eql-call (x)
+  (declare (optimize (speed 3) (space 0)))
+  (fgf-csc-eql x))
+(test call-site-cache-eql-specializers
+      (equal (loop repeat 3 nconc (mapcar #'fgf-csc-eql-call '(1 2)))
+             '(:one :integer :one :integer :one :integer)))
+
+;;; Dispatch profiles record what the call history has seen.
+(test dispatch-profile-round-trip
+      (let ((pathname (core:mkstemp "TMP:dispatch-profile")))
+        (unwind-protect
+             (progn
+               (fgf-csc-call 1)
+               (clos:save-dispatch-profile pathname)
+               (member '(integer)
+                       (rest (assoc 'fgf-csc (clos::load-dispatch-profile pathname)))
+                       :test #'equal))
+          (when (probe-file pathname)
+            (delete-file pathname)))))
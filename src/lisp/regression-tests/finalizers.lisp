@@ -70,3 +70,61 @@
   (gctools:garbage-collect))
 (format t "*count* --> ~a - it should be 0~%" *count*)
 (test finalizers-general-remove (= *count* 0) :description "Check if list of general finalizers were discarded")
+
+(test gc-pause-statistics
+      (progn
+        (gctools:garbage-collect)
+        (multiple-value-bind (collections total max last pauses total-pause max-pause)
+            (gctools:gc-pause-statistics)
+          (and (typep collections '(integer 0))
+               (typep pauses '(integer 0))
+               (every (lambda (seconds) (typep seconds '(double-float 0d0)))
+                      (list total max last total-pause max-pause))
+               (<= last max total)
+               (<= max-pause total-pause)
+               (or (plusp collections) (zerop total))
+               (or (plusp pauses) (zerop total-pause))
+               #+use-boehm (plusp collections)
+               (plusp (gctools:gc-marker-threads)))))
+      :description "Check that all collection statistics are available and consistent")
+
+(test gc-atomic-objects-survive
+      (let ((doubles (make-array 10000 :element-type 'double-float :initial-element 1d0))
+            (bits (make-array 1000 :element-type 'bit))
+            (big (expt 3 500))
+            (string (make-string 1000 :initial-element #\a)))
+        (gctools:garbage-collect)
+        (gctools:garbage-collect)
+        (multiple-value-bind (typed atomic) (gctools:gc-typed-allocation-stamps)
+          (and (integerp typed)
+               (integerp atomic)
+               (= (reduce #'+ doubles) 10000d0)
+               (zerop (count 1 bits))
+               (= big (expt 3 500))
+               (every (lambda (c) (char= c #\a)) string))))
+      :description "Pointer-free objects are allocated atomically and must keep their contents")
+
+;;; CLASP_GC_TYPED_ALLOCATION is read at startup, so run a child clasp with it set.
+(test gc-typed-allocation
+      (let ((form "(let ((table (make-hash-table :weakness :key :test #'eq))
+                         (keys (loop for i below 100 collect (list i)))
+                         (doubles (make-array 1000 :element-type 'double-float :initial-element 2d0))
+                         (objects (loop for i below 1000 collect (cons (make-instance 'standard-object) (list i)))))
+                     (dolist (key keys) (setf (gethash key table) (car key)))
+                     (gctools:garbage-collect)
+                     (gctools:garbage-collect)
+                     (multiple-value-bind (typed atomic) (gctools:gc-typed-allocation-stamps)
+                       (when (and #+use-boehm (plusp (+ typed atomic))
+                                  (every (lambda (key) (eql (gethash key table) (car key))) keys)
+                                  (= (reduce #'+ doubles) 2000d0)
+                                  (every (lambda (o i) (equal (cdr o) (list i))) objects (loop for i below 1000 collect i)))
+                         (format t \"~%TYPED-ALLOCATION-OK~%\"))))"))
+        (let ((stream (nth-value 2 (ext:vfork-execvp
+                                    (list "env" "CLASP_GC_TYPED_ALLOCATION=1"
+                                          (core:argv 0) "--noinform" "-N" "-e" form)
+                                    t))))
+          (and stream
+               (loop for line = (read-line stream nil nil)
+                     while line
+                       thereis (search "TYPED-ALLOCATION-OK" line)))))
+      :description "Allocate with Boehm type descriptors and check that objects and weak tables survive collections")
@@ -98,6 +98,48 @@
                                  (setf (gethash :key table) 23)
                                  (gethash :key table))))
 (test clrhash-weak-key (clrhash (make-hash-table :test #'eq :weakness :key)))
+(test hash-table-weakness-weak-key (eq :key (core:hash-table-weakness (make-hash-table :test #'eq :weakness :key))))
+(test weak-key-fixnum-zero
+      (let ((table (make-hash-table :test #'eq :weakness :key)))
+        (setf (gethash 0 table) 0
+              (gethash 1 table) 1)
+        (and (eql 0 (gethash 0 table))
+             (eql 1 (gethash 1 table))
+             (= 2 (hash-table-count table)))))
+
+;;weak tables: weakness :value and :key-and-value
+(test hash-table-weakness-weak-value (eq :value (core:hash-table-weakness (make-hash-table :test #'eq :weakness :value))))
+(test hash-table-weakness-weak-key-and-value
+      (eq :key-and-value (core:hash-table-weakness (make-hash-table :test #'eq :weakness :key-and-value))))
+(test setf-gethash-weak-value
+      (let ((table (make-hash-table :test #'eq :weakness :value))
+            (objects (loop for i below 100 collect (list i))))
+        (loop for v in objects
+              for i from 0
+              do (setf (gethash i table) v))
+        (and (= 100 (hash-table-count table))
+             (loop for v in objects
+                   for i from 0
+                   always (eq v (gethash i table))))))
+(test remhash-weak-key-and-value
+      (let ((table (make-hash-table :test #'eq :weakness :key-and-value))
+            (key (list :key))
+            (value (list :value)))
+        (setf (gethash key table) value)
+        (and (eq value (gethash key table))
+             (remhash key table)
+             (null (nth-value 1 (gethash key table)))
+             (zerop (hash-table-count table)))))
+(test maphash-weak-value
+      (let ((table (make-hash-table :test #'eq :weakness :value))
+            (sum 0))
+        (setf (gethash :a table) 1
+              (gethash :b table) 2
+              (gethash :c table) :c)
+        (maphash (lambda (k v) (declare (ignore k)) (when (numberp v) (incf sum v))) table)
+        (= sum 3)))
+(test-expect-error make-hash-table-weak-key-or-value
+                   (make-hash-table :test #'eq :weakness :key-or-value))
 (test maphash-weak-key (progn
                          (maphash #'(lambda(a b)
                                       (declare (ignore a b)))
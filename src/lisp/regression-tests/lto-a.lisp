@@ -0,0 +1,7 @@
+(in-package :cl-user)
+
+(defun lto-square (x) (* x x))
+
+(defun lto-cube (x)
+  (declare (optimize (speed 3) (debug 0)))
+  (* x (lto-square x)))
@@ -0,0 +1,4 @@
+(in-package :cl-user)
+
+(defun lto-sum-of-cubes (n)
+  (loop for i from 1 to n sum (lto-cube i)))
@@ -142,6 +142,94 @@
       (not (string= ""
                (with-output-to-string (*standard-output*)
                  (compile-file "sys:regression-tests;test-compile-file.lisp" :print t :verbose t)))))
+
+;;; Compile lto-a.lisp serially to LLVM IR and return true if the code
+;;; of LTO-CUBE still calls LTO-SQUARE.
+(defun %lto-cube-calls-square-p (lto)
+  (let* ((directory (core:mkdtemp "/tmp/lto"))
+         (output (make-pathname :name "lto-a" :type "fasoll" :defaults directory)))
+    (unwind-protect
+         (let ((cmp:*compile-file-parallel* nil)
+               (cmp:*compile-file-lto* lto))
+           (compile-file "sys:regression-tests;lto-a.lisp"
+                         :output-type :fasoll :output-file output)
+           (with-open-file (stream output)
+             (loop with in-cube = nil
+                   for line = (read-line stream nil nil)
+                   while line
+                   do (cond ((eql (search "define " line) 0)
+                             (setf in-cube (search "LTO-CUBE^CL-USER^FN" line)))
+                            ((eql (search "}" line) 0)
+                             (setf in-cube nil)))
+                   thereis (and in-cube
+                                (search "call " line)
+                                (search "LTO-SQUARE^CL-USER^FN" line)))))
+      (when (probe-file output) (delete-file output))
+      (core:rmdir directory))))
+
+;;; LTO-CUBE calls LTO-SQUARE directly. Only with LTO is that call
+;;; inlined, so that the module no longer calls LTO-SQUARE's entry point.
+(test compile-file-lto
+      (and (%lto-cube-calls-square-p nil)
+           (not (%lto-cube-calls-square-p t)))
+      :description "LTO inlines a function defined by an earlier form")
+
+;;; The LTO faso still loads and works.
+(test compile-file-lto-load
+      (let ((cmp:*compile-file-lto* t))
+        (fmakunbound 'cl-user::lto-cube)
+        (load (compile-file "sys:regression-tests;lto-a.lisp" :output-type :faso))
+        (eql (cl-user::lto-cube 3) 27)))
+
+(test link-fasobc-modules-to-faso
+      (let* ((directory (core:mkdtemp "/tmp/lto"))
+             (parts (loop for name in '("lto-a" "lto-b")
+                          collect (compile-file
+                                   (format nil "sys:regression-tests;~a.lisp" name)
+                                   :output-type :fasobc
+                                   :output-file (make-pathname :name name :type "fasobc"
+                                                               :defaults directory))))
+             (faso (make-pathname :name "lto" :type "faso" :defaults directory)))
+        (unwind-protect
+             (progn
+               (mapc #'fmakunbound '(cl-user::lto-square cl-user::lto-cube
+                                     cl-user::lto-sum-of-cubes))
+               (cmp:link-fasobc-modules-to-faso faso parts)
+               (load faso)
+               (and (eql (cl-user::lto-cube 3) 27)
+                    (eql (cl-user::lto-sum-of-cubes 3) 36)))
+          (dolist (file (cons faso parts))
+            (when (probe-file file) (delete-file file)))
+          (core:rmdir directory)))
+      :description "Link the fasobc files of two source files into one faso")
+
+;;; Moving a form down the file keeps its cache key, and the cached
+;;; object's source positions are moved with it.
+(test compile-file-parallel-cache-relocation
+      (let* ((directory (core:mkdtemp "/tmp/form-cache"))
+             (cache (merge-pathnames "cache/" directory))
+             (source (make-pathname :name "cached" :type "lisp" :defaults directory))
+             (cmp::*compile-file-parallel-cache-directory* cache))
+        (flet ((compile-and-load (blank-lines)
+                 (with-open-file (out source :direction :output :if-exists :supersede)
+                   (dotimes (i blank-lines) (terpri out))
+                   (write-line "(defun %form-cache-line () 42)" out))
+                 (load (cmp::compile-file-parallel source))
+                 (nth-value 2 (ext:compiled-function-file #'%form-cache-line)))
+               (cache-files ()
+                 (mapcar #'namestring (directory (merge-pathnames "*.*" cache)))))
+          (unwind-protect
+               (let* ((line (compile-and-load 0))
+                      (keys (cache-files))
+                      (moved-line (compile-and-load 3)))
+                 (and (= moved-line (+ line 3))
+                      (equal (cache-files) keys)
+                      (eql (%form-cache-line) 42)))
+            (dolist (file (append (directory (merge-pathnames "*.*" cache))
+                                  (directory (merge-pathnames "*.*" directory))))
+              (when (pathname-name file) (delete-file file)))
+            (when (probe-file cache) (core:rmdir cache))
+            (core:rmdir directory)))))
                  
 (defun %%blah (&key foo bar)
   (list foo bar))
@@ -245,3 +333,116 @@
              (values 3 0))
          1 (return nil)
          2 (return t))))
+
+(defun %serialize-round-trip (object)
+  (core:deserialize-from-octets (core:serialize-to-octets object)))
+
+(test serialize-scalars-and-arrays
+      (let ((data (list 1 -7 most-positive-fixnum (expt 3 100) (- (expt 2 200)) 2/3
+                        1.5f0 -2.25d0 #c(1 2) #\a :key 'cl:car "base" (coerce (list #\a (code-char 955)) (quote string))
+                        (make-array 3 :element-type 'double-float :initial-contents '(1d0 2d0 3d0))
+                        (make-array 3 :element-type '(unsigned-byte 8) :initial-contents '(1 2 255))
+                        #*1011001 #(a "b" 3))))
+        (equalp (%serialize-round-trip data) data)))
+
+(test serialize-sharing-and-cycles
+      (let* ((shared (list 1 2))
+             (circular (list 1 2 3))
+             (table (make-hash-table :test 'equal)))
+        (setf (cdr (last circular)) circular)
+        (setf (gethash "k" table) shared)
+        (destructuring-bind (a b c tab sym1 sym2)
+            (%serialize-round-trip (let ((g (gensym))) (list shared shared circular table g g)))
+          (and (eq a b) (equal a '(1 2))
+               (eq (cdddr c) c)
+               (equal (gethash "k" tab) '(1 2))
+               (eq sym1 sym2) (null (symbol-package sym1))))))
+
+(defstruct %serialize-struct a b)
+(test serialize-structure-instance
+      (let* ((s (make-%serialize-struct :a 1 :b (list "x")))
+             (copy (%serialize-round-trip (vector s s))))
+        (and (eq (aref copy 0) (aref copy 1))
+             (%serialize-struct-p (aref copy 0))
+             (equalp (aref copy 0) s))))
+
+(test serialize-wide-symbol-names
+      (let ((symbol (intern (coerce (list #\a (code-char 955) (code-char 8364)) 'string)
+                            "CL-USER")))
+        (eq (%serialize-round-trip symbol) symbol)))
+
+;;; Lengths are checked against what's left of the input.
+(test-expect-error serialize-truncated-vector
+                   (let ((octets (core:serialize-to-octets (make-array 3 :element-type 'double-float))))
+                     (core:deserialize-from-octets (subseq octets 0 (- (length octets) 1)))))
+
+;;; Vectors that aren't simple keep their fill pointer and adjustability,
+;;; and can contain themselves.
+(test serialize-fill-pointer-vector
+      (let ((string (make-array 8 :element-type 'character :fill-pointer 3 :adjustable t
+                                  :initial-contents "abcdefgh"))
+            (vector (make-array 2 :adjustable t)))
+        (setf (aref vector 0) vector)
+        (destructuring-bind (s v) (%serialize-round-trip (list string vector))
+          (and (string= s "abc")
+               (= (fill-pointer s) 3)
+               (= (array-total-size s) 8)
+               (adjustable-array-p s)
+               (char= (char s 7) #\h)
+               (adjustable-array-p v)
+               (not (array-has-fill-pointer-p v))
+               (eq (aref v 0) v)))))
+
+(test-expect-error serialize-invalid-character-code
+                   (let ((octets (core:serialize-to-octets #\a)))
+                     ;; Replace the code with char-code-limit, as LEB128.
+                     (core:deserialize-from-octets
+                      (coerce (concatenate 'list (subseq octets 0 (1- (length octets)))
+                                           (list #x80 #x80 #x44))
+                              '(simple-array (unsigned-byte 8) (*))))))
+
+;;; An instance written before its class gained a slot can't be read.
+(defclass %serialize-changing () ((a :initarg :a)))
+(test-expect-error serialize-instance-slot-count-changed
+                   (let ((octets (core:serialize-to-octets
+                                  (make-instance '%serialize-changing :a 1))))
+                     (eval '(defclass %serialize-changing () ((a :initarg :a) (b))))
+                     (clos:finalize-inheritance (find-class '%serialize-changing))
+                     (core:deserialize-from-octets octets)))
+
+;;; Call an interpreted function from several threads until the
+;;; background compiler has replaced it. It must be queued exactly once,
+;;; and the cell and the function cell must end up with the compiled
+;;; function.
+(test tiered-eval
+      (let* ((cells (list nil))
+             (hook interpret-ast:*tier-up-hook*)
+             (interpret-ast:*tier-up-threshold* 3)
+             (interpret-ast:*tier-up-hook*
+               (lambda (ast closure)
+                 (let ((cell (funcall hook ast closure)))
+                   (mp:atomic-push cell (car cells))
+                   cell))))
+        (eval '(defun %tiered (x) (if x (list x x) :none)))
+        (let* ((threads
+                 (loop repeat 4
+                       collect (mp:process-run-function
+                                "tiered-eval"
+                                (lambda ()
+                                  (loop repeat 50
+                                        always (equal (%tiered 1) '(1 1)))))))
+               (results (mapcar #'mp:process-join threads)))
+          (flet ((compiled ()
+                   (and (car cells) (mp:atomic (car (first (car cells)))))))
+            (loop repeat 1000
+                  until (and (compiled) (eq (fdefinition '%tiered) (compiled)))
+                  do (sleep 0.01))
+            (let ((function (compiled)))
+              (and (every #'identity results)
+                   (= (length (car cells)) 1)
+                   (compiled-function-p function)
+                   (eq (fdefinition '%tiered) function)
+                   (not (eq (core:function-name function)
+                            'interpret-ast::ast-interpreted-closure))
+                   (equal (%tiered 1) '(1 1))
+                   (eq (%tiered nil) :none)))))))
@@ -237,3 +237,62 @@
             (nthreads 7))
         (spam-processes nthreads (lambda () (mp:atomic-push nil (car place))))
         (equal (car place) (make-list nthreads))))
+
+(test mp-queue-fifo
+      ;; More elements than fit in one segment
+      (let ((queue (mp:make-queue)))
+        (dotimes (i 1000) (mp:enqueue queue i))
+        (and (= (mp:queue-count queue) 1000)
+             (equal (loop repeat 1000 collect (mp:dequeue queue))
+                    (loop for i below 1000 collect i))
+             (mp:queue-empty-p queue))))
+
+(test mp-queue-dequeue-timeout
+      (let ((queue (mp:make-queue)))
+        (and (equal (multiple-value-list (mp:dequeue queue :timeout 0)) '(nil nil))
+             (equal (multiple-value-list (mp:dequeue queue :timeout 0.01)) '(nil nil))
+             (mp:enqueue queue nil)
+             (equal (multiple-value-list (mp:dequeue queue :timeout 0)) '(nil t)))))
+
+(test mp-queue-bounded
+      (let ((queue (mp:make-queue :capacity 2)))
+        (and (mp:enqueue queue 'a)
+             (mp:enqueue queue 'b)
+             (not (mp:enqueue queue 'c :timeout 0))
+             (not (mp:enqueue queue 'c :timeout 0.01))
+             (eq (mp:dequeue queue) 'a)
+             (mp:enqueue queue 'c :timeout 0)
+             (= (mp:queue-count queue) 2)
+             (equal (mp:dequeue-batch queue 10) '(b c)))))
+
+(test mp-queue-batch
+      (let ((queue (mp:make-queue))
+            (items (loop for i below 600 collect i)))
+        (and (= (mp:enqueue-batch queue items) 600)
+             (equal (mp:dequeue-batch queue 1000) items)
+             (null (mp:dequeue-batch queue 10 :timeout 0)))))
+
+(test mp-queue-blocking-handoff
+      (let* ((queue (mp:make-queue :capacity 1))
+             (consumer (mp:process-run-function
+                        nil (lambda () (loop repeat 100 sum (mp:dequeue queue))))))
+        (dotimes (i 100) (mp:enqueue queue i))
+        (= (mp:process-join consumer) 4950)))
+
+(test mp-queue-many-producers-many-consumers
+      (let* ((queue (mp:make-queue :capacity 64))
+             (nthreads 4)
+             (per-thread 1000)
+             (producers (loop for p below nthreads
+                              collect (let ((p p))
+                                        (mp:process-run-function
+                                         nil (lambda ()
+                                               (dotimes (i per-thread)
+                                                 (mp:enqueue queue (+ (* p per-thread) i))))))))
+             (consumers (loop repeat nthreads
+                              collect (mp:process-run-function
+                                       nil (lambda ()
+                                             (loop repeat per-thread collect (mp:dequeue queue)))))))
+        (mapc #'mp:process-join producers)
+        (equal (sort (loop for consumer in consumers append (mp:process-join consumer)) #'<)
+               (loop for i below (* nthreads per-thread) collect i))))
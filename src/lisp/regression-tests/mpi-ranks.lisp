@@ -0,0 +1,44 @@
+;;; Run by mpi.lisp in two processes under mpirun. Each process prints
+;;; MPI-RANK-OK and its rank if all of its checks passed.
+
+(let* ((world mpi:*world*)
+       (rank (mpi::get-rank world))
+       (other (- 1 rank))
+       (ok t))
+  (flet ((check (name result)
+           (unless result
+             (setf ok nil)
+             (format t "~&MPI-RANK-FAIL ~d ~a~%" rank name))))
+    (if (zerop rank)
+        (mpi::prim-send world 1 1 '(1 "two" 3d0))
+        (check 'recv (equal (mpi::prim-recv world 0 1) '(1 "two" 3d0))))
+    ;; A nonblocking send takes a copy, and the collector may move the
+    ;; vectors while the messages are in flight.
+    (let* ((out (make-array 1000 :element-type 'double-float
+                                 :initial-element (float rank 1d0)))
+           (in (make-array 1000 :element-type 'double-float :initial-element -1d0))
+           (recv (mpi::irecv-vector world in other 2))
+           (send (mpi::isend-vector world out other 2)))
+      (fill out 99d0)
+      (gctools:garbage-collect)
+      (mpi::wait-request world send)
+      (check 'irecv-count (= (nth-value 2 (mpi::wait-request world recv)) 1000))
+      (check 'irecv-data (every (lambda (x) (= x (float other 1d0))) in)))
+    (check 'broadcast (equal (mpi::broadcast world (and (zerop rank) "root") 0) "root"))
+    (check 'gather (equal (mpi::gather-objects world rank 0)
+                          (if (zerop rank) '(0 1) nil)))
+    (check 'allreduce-objects
+           (equal (mpi::allreduce-objects world (list rank) #'append) '(0 1)))
+    (let ((v (make-array 3 :element-type 'fixnum
+                           :initial-contents (list rank 10 (* rank 7)))))
+      (check 'allreduce-vector
+             (equalp (mpi::allreduce-vector world '+ v (copy-seq v)) #(1 20 7))))
+    (let ((v (make-array 1 :element-type 'fixnum :initial-element most-positive-fixnum)))
+      (check 'fixnum-overflow
+             (handler-case (progn (mpi::allreduce-vector world '+ v (copy-seq v)) nil)
+               (error () t))))
+    (mpi::barrier world)
+    (when ok
+      (format t "~&MPI-RANK-OK ~d~%" rank))
+    (finish-output)
+    (core:quit 0)))
@@ -0,0 +1,19 @@
+(in-package #:clasp-tests)
+
+;;; MPI needs more than one process, so run mpi-ranks.lisp in two clasps
+;;; under mpirun on this machine.
+(test mpi-two-ranks
+      (let* ((script (namestring (translate-logical-pathname
+                                  "sys:regression-tests;mpi-ranks.lisp")))
+             (stream (nth-value 2 (ext:vfork-execvp
+                                   (list "mpirun" "-np" "2"
+                                         (core:argv 0) "--noinform" "-N" "-l" script)
+                                   t))))
+        (and stream
+             (let ((ranks (loop for line = (read-line stream nil nil)
+                                for ok = (and line (search "MPI-RANK-OK" line))
+                                while line
+                                when ok
+                                  collect (parse-integer line :start (+ ok 11)))))
+               (equal (sort ranks #'<) '(0 1)))))
+      :description "Send, receive, gather and reduce between two MPI processes")
@@ -388,6 +388,9 @@
 (test infinity-7 (ext:float-infinity-p ext:long-float-positive-infinity))
 (test infinity-8 (ext:float-infinity-p ext:long-float-negative-infinity))
 (test infinity-9 (ext:float-infinity-p (+ most-positive-long-float most-positive-long-float)))
+;;; An infinity has no integer value.
+(test-expect-error infinity-floor (floor ext:double-float-positive-infinity)
+                   :type arithmetic-error)
 
 ;;; nan
 (test nan-1 (ext:float-nan-p (/ 0s0 0s0)))
@@ -733,3 +736,85 @@
               unless (equal x y)
               do (format t "Diff ~a with ~a~2%" x y)))
         (values no-error-p)))
+
+(test bignum-fixnum-ash-overflow
+      (and (= (ash 3 100) (* 3 (expt 2 100)))
+           (= (ash -3 100) (* -3 (expt 2 100)))
+           (= (ash most-positive-fixnum 64) (* most-positive-fixnum (expt 2 64)))))
+
+(test bignum-from-double
+      (and (= (truncate 1d300) (rational 1d300))
+           (= (truncate (expt 2d0 70)) (expt 2 70))
+           (= (truncate (- (expt 2d0 70))) (- (expt 2 70)))
+           (= (floor 123456789012345678901234567890d0) (rational 123456789012345678901234567890d0))))
+
+(test bignum-logand-negative-carry
+      ;; Both operands fit in two limbs, the result needs three.
+      (= (logand (- (expt 2 127)) (- (1+ (expt 2 127))))
+         (- (expt 2 128))))
+
+(test exact-sum-reduce-ratios
+      (let ((amounts (loop for i from 1 to 500 collect (/ i 100))))
+        (and (= (reduce #'+ amounts) 2505/2)
+             (= (reduce #'+ (coerce amounts 'vector) :start 100 :initial-value 1/3)
+                (+ 1/3 (loop for x in (nthcdr 100 amounts) sum x))))))
+
+(test exact-sum-reduce-float-contagion
+      ;; Rationals are summed exactly up to the first float, after that
+      ;; the fold continues with float additions as usual.
+      (let ((numbers (list 1/3 2/3 (expt 10 20) 0.5d0 1/3)))
+        (= (reduce #'+ numbers)
+           (+ (+ (+ (+ 1/3 2/3) (expt 10 20)) 0.5d0) 1/3))))
+
+(test exact-sum-accumulator
+      (let ((acc (ext:make-sum-accumulator)))
+        (ext:sum-accumulator-add-sequence acc (list 1d20 1d0 -1d20 1/2))
+        (ext:sum-accumulator-add acc 1/4)
+        (= (ext:sum-accumulator-value acc) 1.75d0)))
+
+(test unboxed-double-float-loop
+      (let ((dot (compile nil '(lambda (x y)
+                                (declare (type (simple-array double-float (*)) x y)
+                                         (optimize speed (safety 0)))
+                                (let ((sum 0d0))
+                                  (declare (double-float sum))
+                                  (dotimes (i (length x) sum)
+                                    (setf sum (+ sum (* (aref x i) (aref y i)))))))))
+            (x (make-array 4 :element-type 'double-float
+                             :initial-contents '(1d0 2d0 3d0 4d0)))
+            (y (make-array 4 :element-type 'double-float
+                             :initial-contents '(0.5d0 0.25d0 2d0 -1d0))))
+        (= (funcall dot x y) 3d0)))
+
+(test unboxed-byte64-logic
+      (let ((mix (compile nil '(lambda (v)
+                                (declare (type (simple-array ext:byte64 (*)) v)
+                                         (optimize speed (safety 0)))
+                                (let ((acc 0))
+                                  (declare (type ext:byte64 acc))
+                                  (dotimes (i (length v))
+                                    (setf acc (logxor acc (aref v i))
+                                          (aref v i) (logand acc #xFFFFFFFF00000000)))
+                                  acc))))
+            (v (make-array 3 :element-type 'ext:byte64
+                             :initial-contents (list (1- (expt 2 64)) #x0F0F 1))))
+        (and (= (funcall mix v) (logxor (1- (expt 2 64)) #x0F0F 1))
+             (= (aref v 0) #xFFFFFFFF00000000))))
+
+(test-expect-error unboxed-double-float-bounds-check
+                   (funcall (compile nil '(lambda (v i)
+                                           (declare (type (simple-array double-float (*)) v)
+                                                    (fixnum i))
+                                           (aref v i)))
+                            (make-array 2 :element-type 'double-float
+                                          :initial-element 0d0)
+                            2))
+
+(test-expect-error unboxed-byte64-set-bounds-check
+                   (funcall (compile nil '(lambda (v i)
+                                           (declare (type (simple-array ext:byte64 (*)) v)
+                                                    (fixnum i))
+                                           (setf (aref v i) 1)))
+                            (make-array 2 :element-type 'ext:byte64
+                                          :initial-element 0)
+                            5))
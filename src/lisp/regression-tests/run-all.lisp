@@ -52,6 +52,8 @@
 (load-if-compiled-correctly "sys:regression-tests;debug.lisp")
 (load-if-compiled-correctly "sys:regression-tests;mp.lisp")
 (load-if-compiled-correctly "sys:regression-tests;posix.lisp")
+#+use-mpi
+(load-if-compiled-correctly "sys:regression-tests;mpi.lisp")
 (progn
   (note-test-finished)
   (format t "Passes: ~a~%" *passes*)
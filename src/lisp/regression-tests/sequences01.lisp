@@ -525,3 +525,68 @@
       (let ()
         (declare (inline make-sequence))
       (make-sequence '(array char (*)) 0)))
+
+;;; Specialized numeric vectors and fixnum lists sorted with #'< and #'>
+;;; are sorted natively - make them long enough to hit the radix sort
+(defun sorted-test-numbers (n &optional (mod 1000))
+  (let ((state 12345) (result nil))
+    (dotimes (i n result)
+      (setq state (mod (+ (* state 1103515245) 12345) 2147483648))
+      (push (- (mod state mod) (floor mod 2)) result))))
+
+(test sort-native-fixnum-vector
+      (let* ((numbers (sorted-test-numbers 1000))
+             (vec (make-array 1000 :element-type 'fixnum :initial-contents numbers)))
+        (and (equalp (sort vec #'<) (coerce (sort (copy-list numbers) (lambda (x y) (< x y))) 'vector))
+             (equalp (sort vec #'>) (coerce (sort (copy-list numbers) (lambda (x y) (> x y))) 'vector)))))
+
+(test sort-native-unsigned-vector
+      (let ((vec (make-array 600 :element-type '(unsigned-byte 32)
+                                 :initial-contents (mapcar (lambda (x) (+ x 500)) (sorted-test-numbers 600)))))
+        (setq vec (stable-sort vec #'<))
+        (every #'<= vec (subseq vec 1))))
+
+(test sort-native-double-vector
+      (let ((vec (make-array 5 :element-type 'double-float :initial-contents '(3d0 -1d0 2.5d0 0d0 -7d0))))
+        (equalp (sort vec #'>) #(3d0 2.5d0 0d0 -1d0 -7d0))))
+
+(test sort-native-fixnum-list
+      (let ((numbers (sorted-test-numbers 100 50)))
+        (and (equal (sort (copy-list numbers) #'<) (sort (copy-list numbers) (lambda (x y) (< x y))))
+             (equal (stable-sort (copy-list numbers) #'>) (stable-sort (copy-list numbers) (lambda (x y) (> x y)))))))
+
+(test stable-sort-list-stability
+      (equal (stable-sort (list '(1 . a) '(0 . b) '(1 . c) '(0 . d) '(1 . e)) #'< :key #'car)
+             '((0 . b) (0 . d) (1 . a) (1 . c) (1 . e))))
+
+(test vector-kernels-fill-replace
+      (let ((a (make-array 10 :element-type 'double-float :initial-element 0d0))
+            (b (make-array 10 :element-type 'double-float :initial-element 0d0)))
+        (fill a 2d0 :start 2 :end 5)
+        (replace b a :start1 1)
+        (replace a a :start1 1 :end1 5)
+        (and (equalp b #(0d0 0d0 0d0 2d0 2d0 2d0 0d0 0d0 0d0 0d0))
+             (equalp a #(0d0 0d0 0d0 2d0 2d0 0d0 0d0 0d0 0d0 0d0)))))
+
+(test vector-kernels-reduce
+      (let ((vec (make-array 1000 :element-type '(signed-byte 64)
+                                  :initial-contents (sorted-test-numbers 1000))))
+        (setf (aref vec 17) most-positive-fixnum
+              (aref vec 18) most-positive-fixnum)
+        (and (= (reduce #'+ vec) (reduce (lambda (x y) (+ x y)) vec))
+             (= (reduce #'+ vec :start 10 :end 20 :initial-value 7)
+                (+ 7 (loop for i from 10 below 20 sum (aref vec i))))
+             (= (reduce #'max vec) most-positive-fixnum)
+             (= (reduce #'min vec) (reduce (lambda (x y) (min x y)) vec)))))
+
+(test vector-kernels-arithmetic
+      (let ((a (make-array 20 :element-type 'double-float :initial-element 1.5d0))
+            (b (make-array 20 :element-type 'double-float :initial-element 2d0))
+            (r (make-array 20 :element-type 'double-float :initial-element 0d0)))
+        (ext:vector-add r a b)
+        (and (every (lambda (x) (= x 3.5d0)) r)
+             (every (lambda (x) (= x 3d0)) (ext:vector-multiply r a b))
+             (every (lambda (x) (= x 6d0)) (ext:vector-scale r r 2d0))
+             (= (ext:vector-dot a b) 60d0)
+             (= (ext:vector-sum b) 40d0)
+             (equal (ext:vector-compare '< b (ext:vector-subtract r r b)) (make-array 20 :element-type 'bit :initial-element 1)))))
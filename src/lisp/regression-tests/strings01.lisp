@@ -131,3 +131,48 @@
       (equal
        (type-of "zażółć gęślą jaźń")
        '(SIMPLE-ARRAY CHARACTER (17))))
+
+;;; The string kernels work in blocks of characters - use strings
+;;; long enough to exercise both the block loops and the tails
+(test string-kernels-search-long
+      (let ((outer (concatenate 'string (make-string 100 :initial-element #\a) "abcab" "xyz")))
+        (and (eql (search "abcab" outer) 100)
+             (eql (search "abcab" outer :start2 50) 100)
+             (null (search "abcab" outer :end2 104))
+             (eql (search "ab" outer :start2 101) 103))))
+(test string-kernels-search-mixed-width
+      (let ((outer (make-string 40 :initial-element (code-char 256))))
+        (setf (char outer 30) #\x (char outer 31) #\y)
+        (and (eql (search "xy" outer) 30)
+             (eql (search (coerce "xy" 'base-string) outer) 30)
+             (null (search "yx" outer)))))
+(test string-kernels-position
+      (let ((str (concatenate 'string (make-string 37 :initial-element #\a) "b" (make-string 37 :initial-element #\a) "b")))
+        (and (eql (position #\b str) 37)
+             (eql (position #\b str :from-end t) 75)
+             (eql (position #\b str :start 38) 75)
+             (null (position #\b str :end 37))
+             (null (position (code-char 256) str))
+             (eql (position #\B str :test #'char-equal) 37))))
+(test string-kernels-string=
+      (let ((s1 (make-string 50 :initial-element #\q))
+            (s2 (make-array 50 :element-type 'character :initial-element #\q :adjustable t)))
+        (and (string= s1 s2)
+             (string= s1 (coerce s1 'base-string))
+             (progn (setf (char s2 49) #\r) (not (string= s1 s2)))
+             (string= s1 s2 :end1 49 :end2 49))))
+(test string-kernels-string-equal
+      (and (string-equal (make-string 33 :initial-element #\a) (make-string 33 :initial-element #\A))
+           (not (string-equal (make-string 33 :initial-element #\a) (make-string 33 :initial-element #\b)))
+           (string-equal "Hello World, how are you today?" "HELLO WORLD, HOW ARE YOU TODAY?")))
+(test string-kernels-upcase
+      (let ((str (concatenate 'string "abcdefghijklmnopqrstuvwxyz[`{@" (string (code-char 256)))))
+        (and (string= (string-upcase str) (concatenate 'string "ABCDEFGHIJKLMNOPQRSTUVWXYZ[`{@" (string (char-upcase (code-char 256)))))
+             (string= (string-downcase "ABCDEFGHIJKLMNOPQRSTUVWXYZ[`{@") "abcdefghijklmnopqrstuvwxyz[`{@")
+             (let ((copy (copy-seq str)))
+               (nstring-upcase copy)
+               (string= copy (string-upcase str))))))
+(test string-kernels-trim
+      (and (string= (string-trim " " "   abc   ") "abc")
+           (string= (string-left-trim '(#\a #\b) "ababcab") "cab")
+           (string= (string-right-trim (vector #\a (code-char 256)) (concatenate 'string "xa" (string (code-char 256)) "a")) "x")))
@@ -0,0 +1,62 @@
+;;; Compare mp:queue against the lock based core:queue.
+;;; Load this file and evaluate (run-all).
+
+(defun time-core-queue (nproducers nconsumers per-producer)
+  (let* ((queue (core:make-queue 'bench))
+         (total (* nproducers per-producer))
+         (consumers (loop for c below nconsumers
+                          collect (let ((count (+ (floor total nconsumers)
+                                                  (if (< c (mod total nconsumers)) 1 0))))
+                                    (mp:process-run-function
+                                     'consumer (lambda () (loop repeat count do (core:dequeue queue))))))))
+    (loop repeat nproducers
+          collect (mp:process-run-function
+                   'producer (lambda () (dotimes (i per-producer) (core:atomic-enqueue queue i))))
+            into producers
+          finally (time (progn (mapc #'mp:process-join producers)
+                               (mapc #'mp:process-join consumers))))))
+
+(defun time-mp-queue (nproducers nconsumers per-producer &optional capacity)
+  (let* ((queue (mp:make-queue :name 'bench :capacity capacity))
+         (total (* nproducers per-producer))
+         (consumers (loop for c below nconsumers
+                          collect (let ((count (+ (floor total nconsumers)
+                                                  (if (< c (mod total nconsumers)) 1 0))))
+                                    (mp:process-run-function
+                                     'consumer (lambda () (loop repeat count do (mp:dequeue queue))))))))
+    (loop repeat nproducers
+          collect (mp:process-run-function
+                   'producer (lambda () (dotimes (i per-producer) (mp:enqueue queue i))))
+            into producers
+          finally (time (progn (mapc #'mp:process-join producers)
+                               (mapc #'mp:process-join consumers))))))
+
+(defun time-mp-queue-batch (nproducers nconsumers per-producer batch-size)
+  (let* ((queue (mp:make-queue :name 'bench))
+         (total (* nproducers per-producer))
+         (batch (make-list batch-size :initial-element 0))
+         (consumers (loop for c below nconsumers
+                          collect (let ((count (+ (floor total nconsumers)
+                                                  (if (< c (mod total nconsumers)) 1 0))))
+                                    (mp:process-run-function
+                                     'consumer (lambda ()
+                                                 (loop while (plusp count)
+                                                       do (decf count (length (mp:dequeue-batch queue (min count batch-size)))))))))))
+    (loop repeat nproducers
+          collect (mp:process-run-function
+                   'producer (lambda () (loop repeat (floor per-producer batch-size)
+                                              do (mp:enqueue-batch queue batch))))
+            into producers
+          finally (time (progn (mapc #'mp:process-join producers)
+                               (mapc #'mp:process-join consumers))))))
+
+(defun run-all (&optional (per-producer 1000000))
+  (dolist (threads '(1 2 4 8))
+    (format t "core:queue with ~a producers and ~a consumers~%" threads threads)
+    (time-core-queue threads threads per-producer)
+    (format t "mp:queue (unbounded) with ~a producers and ~a consumers~%" threads threads)
+    (time-mp-queue threads threads per-producer)
+    (format t "mp:queue (capacity 1024) with ~a producers and ~a consumers~%" threads threads)
+    (time-mp-queue threads threads per-producer 1024)
+    (format t "mp:queue batches of 64 with ~a producers and ~a consumers~%" threads threads)
+    (time-mp-queue-batch threads threads per-producer 64)))
@@ -3,7 +3,8 @@
 (defpackage #:serialize 
   (:nicknames :ser)
   (:use :cl)
-  (:export save-archive load-archive)
+  (:export save-archive load-archive
+           save-binary-archive load-binary-archive)
 )
 
 (in-package #:serialize)
@@ -37,6 +38,20 @@
 
 
 
+(defun save-binary-archive (obj filename)
+  "Write obj to a file in the binary format of core:serialize-to-octets"
+  (with-open-file (fout filename :direction :output :if-exists :supersede
+                                 :element-type '(unsigned-byte 8))
+    (write-sequence (core:serialize-to-octets obj) fout))
+  obj)
+
+(defun load-binary-archive (filename)
+  "Load an object from a file written by save-binary-archive"
+  (with-open-file (fin filename :direction :input :element-type '(unsigned-byte 8))
+    (let ((octets (make-array (file-length fin) :element-type '(unsigned-byte 8))))
+      (read-sequence octets fin)
+      (values (core:deserialize-from-octets octets)))))
+
 (defun test-archive ()
   (let ((fn "archive.dat")
 	(a (make-hash-table :test 'eq)))
@@ -84,6 +84,9 @@ THE SOFTWARE.
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/IR/Verifier.h>
 #include "llvm/IR/AssemblyAnnotationWriter.h" // Should be llvm/IR was
+#include <llvm/BinaryFormat/Dwarf.h>
+#include <llvm/Object/ObjectFile.h>
+#include <llvm/Support/LEB128.h>
 //#include <llvm/IR/PrintModulePass.h> // will be llvm/IR
 
 #include <clasp/core/foundation.h>
@@ -102,6 +105,7 @@ THE SOFTWARE.
 #include <clasp/core/bignum.h>
 #include <clasp/core/pointer.h>
 #include <clasp/core/array.h>
+#include <clasp/core/functor.h>
 #include <clasp/core/translators.h>
 #include <clasp/llvmo/debugInfoExpose.h>
 #include <clasp/llvmo/insertPoint.h>
@@ -493,6 +497,242 @@ CL_DEFUN size_t total_memory_allocated_for_object_files() {
   }
   return sz;
 }
+
+/*! Source position relocation.
+    The form-level compile cache stores the object code of a toplevel form
+    and reuses it when the same form turns up at another place in the file.
+    The line numbers and file positions in its debug information and function
+    descriptions are then shifted in place. Every number is rewritten with the
+    width it already has, so no section changes size; if a new value doesn't
+    fit, the relocation fails and the form has to be compiled again. */
+namespace {
+
+bool rewrite_fixed(uint8_t* p, unsigned width, uint64_t value) {
+  if (width < 8 && (value >> (8 * width)) != 0) return false;
+  for (unsigned i = 0; i < width; ++i) p[i] = (value >> (8 * i)) & 0xff;
+  return true;
+}
+
+bool rewrite_uleb128(uint8_t* p, unsigned width, uint64_t value) {
+  uint8_t buffer[16];
+  if (width > sizeof(buffer)) return false;
+  if (llvm::encodeULEB128(value, buffer, width) != width) return false;
+  memcpy(p, buffer, width);
+  return true;
+}
+
+bool rewrite_sleb128(uint8_t* p, unsigned width, int64_t value) {
+  uint8_t buffer[16];
+  if (width > sizeof(buffer)) return false;
+  if (llvm::encodeSLEB128(value, buffer, width) != width) return false;
+  memcpy(p, buffer, width);
+  return true;
+}
+
+uint64_t read_fixed(const uint8_t* p, unsigned width) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < width; ++i) value |= (uint64_t)p[i] << (8 * i);
+  return value;
+}
+
+/*! Shift the line numbers of the DWARF 2-4 line programs in DATA by DELTA.
+    The line register starts at 1 in each sequence and later changes are
+    relative, so only the first change in each sequence is rewritten. */
+bool relocate_debug_line(uint8_t* data, size_t size, int64_t delta) {
+  size_t unit = 0;
+  while (unit < size) {
+    if (unit + 4 > size) return false;
+    uint64_t unit_length = read_fixed(data + unit, 4);
+    if (unit_length >= 0xfffffff0) return false; // 64-bit DWARF
+    size_t end = unit + 4 + unit_length;
+    if (end > size) return false;
+    size_t p = unit + 4;
+    uint64_t version = read_fixed(data + p, 2);
+    p += 2;
+    if (version < 2 || version > 4) return false;
+    size_t program = p + 4 + read_fixed(data + p, 4);
+    p += 4;
+    p += (version >= 4) ? 3 : 2; // instruction lengths, default_is_stmt
+    int line_base = (int8_t)data[p++];
+    unsigned line_range = data[p++];
+    unsigned opcode_base = data[p++];
+    const uint8_t* standard_lengths = data + p;
+    if (line_range == 0 || opcode_base == 0 || program > end) return false;
+    bool first = true;
+    p = program;
+    while (p < end) {
+      unsigned opcode = data[p++];
+      unsigned n = 0;
+      const char* error = nullptr;
+      if (opcode >= opcode_base) {
+        if (first) {
+          unsigned adjusted = opcode - opcode_base;
+          int64_t advance = line_base + (adjusted % line_range) + delta;
+          if (advance < line_base || advance >= line_base + (int64_t)line_range) return false;
+          uint64_t new_opcode = (advance - line_base) + line_range * (adjusted / line_range) + opcode_base;
+          if (new_opcode > 255) return false;
+          data[p - 1] = new_opcode;
+          first = false;
+        }
+      } else if (opcode == 0) {
+        uint64_t length = llvm::decodeULEB128(data + p, &n, data + end, &error);
+        if (error) return false;
+        p += n;
+        if (length == 0 || p + length > end) return false;
+        if (data[p] == llvm::dwarf::DW_LNE_end_sequence) first = true;
+        p += length;
+      } else if (opcode == llvm::dwarf::DW_LNS_advance_line) {
+        int64_t advance = llvm::decodeSLEB128(data + p, &n, data + end, &error);
+        if (error) return false;
+        if (first) {
+          if (!rewrite_sleb128(data + p, n, advance + delta)) return false;
+          first = false;
+        }
+        p += n;
+      } else if (opcode == llvm::dwarf::DW_LNS_copy && first) {
+        // A row at line 1 that no opcode here can move.
+        return false;
+      } else if (opcode == llvm::dwarf::DW_LNS_fixed_advance_pc) {
+        p += 2;
+      } else {
+        for (unsigned i = 0; i < standard_lengths[opcode - 1]; ++i) {
+          llvm::decodeULEB128(data + p, &n, data + end, &error);
+          if (error) return false;
+          p += n;
+        }
+      }
+    }
+    unit = end;
+  }
+  return true;
+}
+
+/*! Shift the DW_AT_decl_line and DW_AT_call_line attributes in the
+    .debug_info section, which starts at DEBUG_INFO, by DELTA. */
+bool relocate_debug_info(llvm::DWARFContext& context, uint8_t* debug_info, int64_t delta) {
+  for (const auto& unit : context.compile_units()) {
+    for (const llvm::DWARFDebugInfoEntry& entry : unit->dies()) {
+      llvm::DWARFDie die(unit.get(), &entry);
+      for (const llvm::DWARFAttribute& attribute : die.attributes()) {
+        if (attribute.Attr != llvm::dwarf::DW_AT_decl_line && attribute.Attr != llvm::dwarf::DW_AT_call_line)
+          continue;
+        uint8_t* p = debug_info + attribute.Offset;
+        unsigned width = attribute.ByteSize;
+        switch (attribute.Value.getForm()) {
+        case llvm::dwarf::DW_FORM_data1:
+        case llvm::dwarf::DW_FORM_data2:
+        case llvm::dwarf::DW_FORM_data4:
+        case llvm::dwarf::DW_FORM_data8: {
+          int64_t line = (int64_t)*attribute.Value.getAsUnsignedConstant();
+          if (line == 0) continue;
+          if (line + delta <= 0 || !rewrite_fixed(p, width, line + delta)) return false;
+          break;
+        }
+        case llvm::dwarf::DW_FORM_udata: {
+          int64_t line = (int64_t)*attribute.Value.getAsUnsignedConstant();
+          if (line == 0) continue;
+          if (line + delta <= 0 || !rewrite_uleb128(p, width, line + delta)) return false;
+          break;
+        }
+        case llvm::dwarf::DW_FORM_sdata: {
+          int64_t line = *attribute.Value.getAsSignedConstant();
+          if (line == 0) continue;
+          if (line + delta <= 0 || !rewrite_sleb128(p, width, line + delta)) return false;
+          break;
+        }
+        default:
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/*! Shift the lineno and filepos of every FunctionDescription, whose
+    symbols are named by cmp::function-description-name. */
+bool relocate_function_descriptions(const llvm::object::ObjectFile& object,
+                                    int64_t line_delta, int64_t filepos_delta) {
+  for (const llvm::object::SymbolRef& symbol : object.symbols()) {
+    llvm::Expected<llvm::StringRef> name = symbol.getName();
+    if (!name) {
+      llvm::consumeError(name.takeError());
+      return false;
+    }
+    if (!name->endswith("^DESC")) continue;
+    llvm::Expected<llvm::object::section_iterator> section = symbol.getSection();
+    if (!section) {
+      llvm::consumeError(section.takeError());
+      return false;
+    }
+    llvm::Expected<llvm::StringRef> contents = (*section)->getContents();
+    if (!contents) {
+      llvm::consumeError(contents.takeError());
+      return false;
+    }
+    size_t offset = symbol.getValue() - (*section)->getAddress();
+    if (offset + sizeof(core::FunctionDescription) > contents->size()) return false;
+    uint8_t* description = (uint8_t*)contents->data() + offset;
+    int64_t lineno = (int32_t)read_fixed(description + offsetof(core::FunctionDescription, lineno), 4);
+    int64_t filepos = (int32_t)read_fixed(description + offsetof(core::FunctionDescription, filepos), 4);
+    lineno += line_delta;
+    filepos += filepos_delta;
+    if (lineno < 0 || lineno > INT32_MAX || filepos < 0 || filepos > INT32_MAX) return false;
+    rewrite_fixed(description + offsetof(core::FunctionDescription, lineno), 4, lineno);
+    rewrite_fixed(description + offsetof(core::FunctionDescription, filepos), 4, filepos);
+  }
+  return true;
+}
+
+};
+
+CL_LAMBDA(object line-delta filepos-delta);
+CL_DOCSTRING(R"doc(Shift the line numbers and file positions recorded in OBJECT, an octet vector holding a
+relocatable object file, by LINE-DELTA and FILEPOS-DELTA. OBJECT is changed in place.
+Return T, or NIL if some position can't be moved, in which case OBJECT is left partly changed
+and must not be used.)doc");
+CL_LISPIFY_NAME(relocate_object_source_positions);
+CL_DEFUN bool relocate_object_source_positions(core::SimpleVector_byte8_t_sp object, core::Fixnum line_delta, core::Fixnum filepos_delta) {
+  if (line_delta == 0 && filepos_delta == 0) return true;
+  // The object file is read in place, so section contents point into OBJECT.
+  llvm::StringRef sbuffer((const char*)object->rowMajorAddressOfElement_(0), object->length());
+  llvm::MemoryBufferRef mbuf_ref(sbuffer, "object-file-buffer");
+  auto eom = llvm::object::ObjectFile::createObjectFile(mbuf_ref);
+  if (!eom) {
+    llvm::consumeError(eom.takeError());
+    return false;
+  }
+  llvm::object::ObjectFile& object_file = **eom;
+  if (!object_file.isLittleEndian()) return false;
+  if (!relocate_function_descriptions(object_file, line_delta, filepos_delta)) return false;
+  if (line_delta == 0) return true;
+  for (const llvm::object::SectionRef& section : object_file.sections()) {
+    llvm::StringRef name;
+    if (section.getName(name)) return false;
+    if (name.startswith(".zdebug") || name.startswith("__zdebug")) return false;
+    if (!name.endswith("debug_line")) continue;
+    llvm::Expected<llvm::StringRef> contents = section.getContents();
+    if (!contents) {
+      llvm::consumeError(contents.takeError());
+      return false;
+    }
+    if (!relocate_debug_line((uint8_t*)contents->data(), contents->size(), line_delta))
+      return false;
+  }
+  for (const llvm::object::SectionRef& section : object_file.sections()) {
+    llvm::StringRef name;
+    if (section.getName(name)) return false;
+    if (!name.endswith("debug_info")) continue;
+    llvm::Expected<llvm::StringRef> contents = section.getContents();
+    if (!contents) {
+      llvm::consumeError(contents.takeError());
+      return false;
+    }
+    std::unique_ptr<llvm::DWARFContext> context = llvm::DWARFContext::create(object_file);
+    return relocate_debug_info(*context, (uint8_t*)contents->data(), line_delta);
+  }
+  return true;
+}
 };
 
 namespace llvmo { // DWARFContext_O
@@ -26,6 +26,10 @@ THE SOFTWARE.
 /* -^- */
 #define DEBUG_LEVEL_FULL
 
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <map>
 #include <clasp/core/foundation.h>
 #ifdef USE_MPI
 #include <boost/mpi.hpp>
@@ -34,6 +38,10 @@ THE SOFTWARE.
 #include <clasp/core/lisp.h>
 #include <clasp/core/cons.h>
 #include <clasp/core/lispStream.h>
+#include <clasp/core/array.h>
+#include <clasp/core/hashTableEql.h>
+#include <clasp/core/evaluator.h>
+#include <clasp/core/serialize.h>
 #include <clasp/mpip/claspMpi.h>
 #include <clasp/core/wrappers.h>
 
@@ -117,6 +125,7 @@ __END_DOC
 namespace mpip {
 
 SYMBOL_EXPORT_SC_(MpiPkg, MpiTermConverter);
+SYMBOL_SC_(MpiPkg, STARpending_requestsSTAR);
 
 static bool _MpiInitialized = false;
 static bool _MpiWorldInitialized = false;
@@ -191,6 +200,8 @@ void Mpi_O::Init(int &argc, char **&argv, bool &mpiEnabled, int &rank, int &msiz
   _MpiInitialized = _MpiEnvironment->initialized();
   if (_MpiInitialized) {
     boost::mpi::communicator world;
+    // Report MPI errors as Lisp errors rather than aborting every process.
+    MPI_Comm_set_errhandler(MPI_COMM_WORLD, MPI_ERRORS_RETURN);
     mpiEnabled = true;
     rank = world.rank();
     msize = world.size();
@@ -261,26 +272,226 @@ CL_DEFMETHOD int Mpi_O::Get_rank() {
 #endif
 }
 
+#ifdef USE_MPI
+/*! Messages are either the raw storage of a specialized vector, sent and
+received in place with the MPI datatype of its elements, or a general object
+encoded with core:serialize-to-octets and sent as MPI_BYTE.  Blocking calls
+use the Lisp storage directly; nonblocking ones go through malloc'd memory
+(see MpiPendingRequest). */
+
+#define MPI_VECTOR_DATATYPES(X) \
+  X(core::SimpleVector_double_O, MPI_DOUBLE) \
+  X(core::SimpleVector_float_O, MPI_FLOAT) \
+  X(core::SimpleVector_fixnum_O, MPI_INT64_T) \
+  X(core::SimpleVector_byte8_t_O, MPI_UINT8_T) \
+  X(core::SimpleVector_int8_t_O, MPI_INT8_T) \
+  X(core::SimpleVector_byte16_t_O, MPI_UINT16_T) \
+  X(core::SimpleVector_int16_t_O, MPI_INT16_T) \
+  X(core::SimpleVector_byte32_t_O, MPI_UINT32_T) \
+  X(core::SimpleVector_int32_t_O, MPI_INT32_T) \
+  X(core::SimpleVector_byte64_t_O, MPI_UINT64_T) \
+  X(core::SimpleVector_int64_t_O, MPI_INT64_T) \
+  X(core::SimpleVector_size_t_O, MPI_UINT64_T)
+
+struct MpiBuffer {
+  void* _Data;
+  int _Count;
+  MPI_Datatype _Type;
+  size_t _Bytes;
+  bool _Fixnum;
+  MpiBuffer(core::Vector_sp vec) {
+    core::AbstractSimpleVector_sp sv;
+    size_t start, end;
+    vec->asAbstractSimpleVectorRange(sv,start,end);
+    this->_Type = MPI_DATATYPE_NULL;
+#define MPI_BUFFER_TYPE(vectorClass,mpiType) \
+    if (this->_Type == MPI_DATATYPE_NULL && gc::IsA<gc::smart_ptr<vectorClass>>(sv)) this->_Type = mpiType;
+    MPI_VECTOR_DATATYPES(MPI_BUFFER_TYPE);
+#undef MPI_BUFFER_TYPE
+    if (this->_Type == MPI_DATATYPE_NULL) {
+      SIMPLE_ERROR(BF("MPI cannot transfer vectors of element-type %s in place") % _rep_(vec->element_type()));
+    }
+    if (end-start > INT_MAX) SIMPLE_ERROR(BF("The vector is too long for a single MPI message"));
+    this->_Count = end-start;
+    this->_Data = this->_Count ? sv->rowMajorAddressOfElement_(start) : NULL;
+    int typeSize;
+    MPI_Type_size(this->_Type,&typeSize);
+    this->_Bytes = (size_t)this->_Count*typeSize;
+    this->_Fixnum = gc::IsA<gc::smart_ptr<core::SimpleVector_fixnum_O>>(sv);
+  }
+};
+
+static void mpi_check(int rc, const char* what) {
+  if (rc != MPI_SUCCESS) {
+    char msg[MPI_MAX_ERROR_STRING];
+    int len;
+    MPI_Error_string(rc,msg,&len);
+    SIMPLE_ERROR(BF("%s failed: %s") % what % std::string(msg,len));
+  }
+}
+
+// Fixnum vectors are sent as MPI_INT64_T, but a sum or product of fixnums
+// can leave the fixnum range or wrap around int64.  They are reduced with
+// these ops instead, which produce mpi_fixnum_overflow for such elements.
+// It is not a fixnum, so it can't come from the data.
+static const int64_t mpi_fixnum_overflow = INT64_MIN;
+
+template <typename Combine>
+static void mpi_fixnum_combine(void* invec, void* inoutvec, int len, Combine combine) {
+  const int64_t* in = (const int64_t*)invec;
+  int64_t* inout = (int64_t*)inoutvec;
+  for (int i = 0; i < len; ++i) {
+    int64_t result;
+    if (in[i] == mpi_fixnum_overflow || inout[i] == mpi_fixnum_overflow
+        || combine(in[i],inout[i],&result)
+        || result > gctools::most_positive_fixnum || result < gctools::most_negative_fixnum)
+      inout[i] = mpi_fixnum_overflow;
+    else
+      inout[i] = result;
+  }
+}
+
+static void mpi_fixnum_sum(void* invec, void* inoutvec, int* len, MPI_Datatype* type) {
+  mpi_fixnum_combine(invec,inoutvec,*len,[](int64_t a, int64_t b, int64_t* r) { return __builtin_add_overflow(a,b,r); });
+}
+
+static void mpi_fixnum_prod(void* invec, void* inoutvec, int* len, MPI_Datatype* type) {
+  mpi_fixnum_combine(invec,inoutvec,*len,[](int64_t a, int64_t b, int64_t* r) { return __builtin_mul_overflow(a,b,r); });
+}
+
+static MPI_Op mpi_create_op(MPI_User_function* function) {
+  MPI_Op op;
+  mpi_check(MPI_Op_create(function,1,&op),"MPI_Op_create");
+  return op;
+}
+
+static MPI_Op mpi_reduce_op(core::T_sp op, const MpiBuffer& buffer) {
+  if (op == cl::_sym__PLUS_) {
+    if (!buffer._Fixnum) return MPI_SUM;
+    static MPI_Op fixnumSum = mpi_create_op(mpi_fixnum_sum);
+    return fixnumSum;
+  }
+  if (op == cl::_sym__TIMES_) {
+    if (!buffer._Fixnum) return MPI_PROD;
+    static MPI_Op fixnumProd = mpi_create_op(mpi_fixnum_prod);
+    return fixnumProd;
+  }
+  if (op == cl::_sym_min) return MPI_MIN;
+  if (op == cl::_sym_max) return MPI_MAX;
+  SIMPLE_ERROR(BF("Unsupported MPI reduction %s - use one of + * min max") % _rep_(op));
+}
+
+static void mpi_check_reduction(const MpiBuffer& result) {
+  if (!result._Fixnum) return;
+  const int64_t* data = (const int64_t*)result._Data;
+  for (int i = 0; i < result._Count; ++i) {
+    if (data[i] == mpi_fixnum_overflow) {
+      SIMPLE_ERROR(BF("The reduction of element %d of a fixnum vector is not a fixnum") % i);
+    }
+  }
+}
+
+static int mpi_message_length(core::SimpleVector_byte8_t_sp octets) {
+  if (octets->length() > INT_MAX) SIMPLE_ERROR(BF("The serialized object is too large for a single MPI message"));
+  return octets->length();
+}
+
+static unsigned char* octets_data(core::SimpleVector_byte8_t_sp octets) {
+  return octets->length() ? (unsigned char*)octets->rowMajorAddressOfElement_(0) : NULL;
+}
+
+// Outstanding nonblocking requests.  The collector may move a Lisp vector
+// while MPI is still reading or writing it, so MPI gets a malloc'd _Buffer
+// instead: a send copies the data into it when it starts, and a receive
+// copies it into the vector, which is kept in *pending-requests* meanwhile,
+// when it completes.  Requests may be started and completed by any thread.
+struct MpiPendingRequest {
+  MPI_Request _Request;
+  MPI_Datatype _Type;
+  void* _Buffer;
+  bool _Receive;
+};
+static mp::Mutex _MpiRequestsMutex(MPIREQST_NAMEWORD);
+static std::map<core::Fixnum,MpiPendingRequest> _MpiRequests;
+static core::Fixnum _MpiNextRequest = 0;
+
+static void* mpi_malloc_buffer(size_t bytes) {
+  void* buffer = malloc(bytes ? bytes : 1);
+  if (!buffer) SIMPLE_ERROR(BF("Could not allocate %lu bytes for an MPI message") % bytes);
+  return buffer;
+}
+
+static void* mpi_copy_buffer(const void* data, size_t bytes) {
+  void* buffer = mpi_malloc_buffer(bytes);
+  if (bytes) memcpy(buffer,data,bytes);
+  return buffer;
+}
+
+// Register a started request.  TARGET is the vector a receive completes into.
+static core::Fixnum mpi_register_request(const MpiPendingRequest& pending, core::T_sp target) {
+  WITH_READ_WRITE_LOCK(_MpiRequestsMutex);
+  core::Fixnum handle = _MpiNextRequest++;
+  _MpiRequests[handle] = pending;
+  if (pending._Receive) {
+    gc::As<core::HashTable_sp>(_sym_STARpending_requestsSTAR->symbolValue())->setf_gethash(core::make_fixnum(handle),target);
+  }
+  return handle;
+}
+
+// Return a copy of the request so that MPI_Wait is not called with the lock held.
+static MpiPendingRequest mpi_find_request(core::Fixnum handle) {
+  WITH_READ_WRITE_LOCK(_MpiRequestsMutex);
+  auto it = _MpiRequests.find(handle);
+  if (it == _MpiRequests.end()) SIMPLE_ERROR(BF("%d is not a pending MPI request") % handle);
+  return it->second;
+}
+
+// Forget a completed request, finish a receive and return the number of
+// elements it transferred.
+static int mpi_complete_request(core::Fixnum handle, MPI_Status& status) {
+  MpiPendingRequest pending;
+  core::T_sp target;
+  {
+    WITH_READ_WRITE_LOCK(_MpiRequestsMutex);
+    auto it = _MpiRequests.find(handle);
+    if (it == _MpiRequests.end()) SIMPLE_ERROR(BF("MPI request %d has already been completed") % handle);
+    pending = it->second;
+    _MpiRequests.erase(it);
+    if (pending._Receive) {
+      core::HashTable_sp requests = gc::As<core::HashTable_sp>(_sym_STARpending_requestsSTAR->symbolValue());
+      target = requests->gethash(core::make_fixnum(handle));
+      requests->remhash(core::make_fixnum(handle));
+    }
+  }
+  int count = 0;
+  MPI_Get_count(&status,pending._Type,&count);
+  if (pending._Receive) {
+    MpiBuffer buffer(gc::As<core::Vector_sp>(target));
+    int typeSize;
+    MPI_Type_size(pending._Type,&typeSize);
+    memcpy(buffer._Data,pending._Buffer,(size_t)count*typeSize);
+  }
+  free(pending._Buffer);
+  return count;
+}
+#else
+[[noreturn]] static void mpi_not_enabled() {
+  SIMPLE_ERROR(BF("MPI is not enabled in this build"));
+}
+#endif
+
 // Object_sp obj, int dest, int tag )
 /*
   __BEGIN_DOC( mpi.MpiObject.Send, subsection, Send)
   \scriptcore::Method{mpi}{Send}{Object::data core::Int::dest core::Int::tag}
 
-  Sends the \sa{Object::data} to the process \sa{dest} with the tag \sa{tag}. The data can be any Cando-Script object - it is archived into XML format and then sent to the process \sa{dest} and then dearchived back into a Cando-Script object on the other side.
+  Sends the \sa{Object::data} to the process \sa{dest} with the tag \sa{tag}. The data can be any object that core:serialize-to-octets accepts - it is serialized into a compact binary form, sent to the process \sa{dest} and deserialized back into an object on the other side.
   __END_DOC
 */
 CL_DEFMETHOD core::T_sp Mpi_O::prim_Send(int dest, int tag, core::T_sp obj) {
-  _G();
 #ifdef USE_MPI
-  IMPLEMENT_ME();
-#if 0
-  core::SexpSaveArchive_sp archive = core::SexpSaveArchive_O::create();
-  archive->put(KW("only"), obj);
-  core::StringOutStream_sp sos = core::StringOutStream_O::make();
-  archive->sexpSaveArchiveWrite(sos);
-  LOG(BF("About to call MPI_Send\n%s\n") % sos->str());
-  this->_Communicator.send(dest, tag, sos->str());
-#endif
+  core::SimpleVector_byte8_t_sp octets = core::core__serialize_to_octets(obj);
+  mpi_check(MPI_Send(octets_data(octets),mpi_message_length(octets),MPI_BYTE,dest,tag,(MPI_Comm)this->_Communicator),"MPI_Send");
 #endif
   return _Nil<core::T_O>();
 }
@@ -293,27 +504,249 @@ CL_DEFMETHOD core::T_sp Mpi_O::prim_Send(int dest, int tag, core::T_sp obj) {
   __END_DOC
 */
 CL_DEFMETHOD core::T_mv Mpi_O::prim_Recv(int source, int tag) {
-  _G();
 #ifdef USE_MPI
-  IMPLEMENT_ME();
-#if 0
-  LOG(BF("About to call MPI_Probe")); // vp0(("About to call MPI_Probe"));
-  boost::mpi::status stat = this->_Communicator.probe(source, tag);
-  this->_Source = stat.source();
-  this->_Tag = stat.tag();
-  LOG(BF("Probe command returned source %d") % this->_Source); // vp0(("Probe command returned source %d", this->_Source ));
-  string buffer;
-  this->_Communicator.recv(source, tag, buffer);
-  core::StringInputStream_sp sis = core::StringInputStream_O::create(buffer);
-  core::SexpLoadArchive_sp arch = core::SexpLoadArchive_O::create();
-  arch->parseFromStream(sis);
-  core::T_sp obj = arch->get(KW("only"));
-  //    free(buffer);
+  MPI_Comm comm = (MPI_Comm)this->_Communicator;
+  MPI_Status status;
+  mpi_check(MPI_Probe(source,tag,comm,&status),"MPI_Probe");
+  int len;
+  MPI_Get_count(&status,MPI_BYTE,&len);
+  // Receive exactly the probed message even if source or tag were wildcards.
+  this->_Source = status.MPI_SOURCE;
+  this->_Tag = status.MPI_TAG;
+  core::SimpleVector_byte8_t_sp octets = core::SimpleVector_byte8_t_O::make(len);
+  mpi_check(MPI_Recv(octets_data(octets),len,MPI_BYTE,this->_Source,this->_Tag,comm,MPI_STATUS_IGNORE),"MPI_Recv");
+  core::T_sp obj = core::core__deserialize_from_octets(octets,0,_Nil<core::T_O>());
   return Values(obj, core::make_fixnum(this->_Source), core::make_fixnum(this->_Tag));
+#else
+  return Values(_Nil<core::T_O>());
+#endif
+}
+
+CL_LISPIFY_NAME("send-vector");
+CL_DOCSTRING("Send the elements of the specialized numeric VECTOR to DEST straight from its storage.");
+CL_DEFMETHOD void Mpi_O::send_vector(core::Vector_sp vector, int dest, int tag) {
+#ifdef USE_MPI
+  MpiBuffer buffer(vector);
+  mpi_check(MPI_Send(buffer._Data,buffer._Count,buffer._Type,dest,tag,(MPI_Comm)this->_Communicator),"MPI_Send");
+#else
+  mpi_not_enabled();
+#endif
+}
+
+CL_LISPIFY_NAME("recv-vector");
+CL_DOCSTRING("Receive a message sent with send-vector directly into the storage of VECTOR, which must have the sender's element-type and room for the message. Return (values vector source tag element-count).");
+CL_DEFMETHOD core::T_mv Mpi_O::recv_vector(core::Vector_sp vector, int source, int tag) {
+#ifdef USE_MPI
+  MpiBuffer buffer(vector);
+  MPI_Status status;
+  mpi_check(MPI_Recv(buffer._Data,buffer._Count,buffer._Type,source,tag,(MPI_Comm)this->_Communicator,&status),"MPI_Recv");
+  int count;
+  MPI_Get_count(&status,buffer._Type,&count);
+  this->_Source = status.MPI_SOURCE;
+  this->_Tag = status.MPI_TAG;
+  return Values(vector, core::make_fixnum(this->_Source), core::make_fixnum(this->_Tag), core::make_fixnum(count));
+#else
+  mpi_not_enabled();
 #endif
+}
+
+CL_LISPIFY_NAME("isend-object");
+CL_DOCSTRING("Start sending OBJECT to DEST without waiting. Return a request for wait-request or test-request.");
+CL_DEFMETHOD core::Fixnum Mpi_O::isend_object(core::T_sp obj, int dest, int tag) {
+#ifdef USE_MPI
+  core::SimpleVector_byte8_t_sp octets = core::core__serialize_to_octets(obj);
+  int len = mpi_message_length(octets);
+  MpiPendingRequest pending{MPI_REQUEST_NULL,MPI_BYTE,mpi_copy_buffer(octets_data(octets),len),false};
+  int rc = MPI_Isend(pending._Buffer,len,MPI_BYTE,dest,tag,(MPI_Comm)this->_Communicator,&pending._Request);
+  if (rc != MPI_SUCCESS) free(pending._Buffer);
+  mpi_check(rc,"MPI_Isend");
+  return mpi_register_request(pending,_Nil<core::T_O>());
+#else
+  mpi_not_enabled();
+#endif
+}
+
+CL_LISPIFY_NAME("isend-vector");
+CL_DOCSTRING("Start sending a copy of the elements of VECTOR to DEST without waiting. VECTOR may be modified right away.");
+CL_DEFMETHOD core::Fixnum Mpi_O::isend_vector(core::Vector_sp vector, int dest, int tag) {
+#ifdef USE_MPI
+  MpiBuffer buffer(vector);
+  MpiPendingRequest pending{MPI_REQUEST_NULL,buffer._Type,mpi_copy_buffer(buffer._Data,buffer._Bytes),false};
+  int rc = MPI_Isend(pending._Buffer,buffer._Count,buffer._Type,dest,tag,(MPI_Comm)this->_Communicator,&pending._Request);
+  if (rc != MPI_SUCCESS) free(pending._Buffer);
+  mpi_check(rc,"MPI_Isend");
+  return mpi_register_request(pending,_Nil<core::T_O>());
+#else
+  mpi_not_enabled();
+#endif
+}
+
+CL_LISPIFY_NAME("irecv-vector");
+CL_DOCSTRING("Start receiving a message for VECTOR without waiting. The elements are stored into VECTOR when wait-request or test-request finds that the request has completed.");
+CL_DEFMETHOD core::Fixnum Mpi_O::irecv_vector(core::Vector_sp vector, int source, int tag) {
+#ifdef USE_MPI
+  MpiBuffer buffer(vector);
+  MpiPendingRequest pending{MPI_REQUEST_NULL,buffer._Type,mpi_malloc_buffer(buffer._Bytes),true};
+  int rc = MPI_Irecv(pending._Buffer,buffer._Count,buffer._Type,source,tag,(MPI_Comm)this->_Communicator,&pending._Request);
+  if (rc != MPI_SUCCESS) free(pending._Buffer);
+  mpi_check(rc,"MPI_Irecv");
+  return mpi_register_request(pending,vector);
+#else
+  mpi_not_enabled();
+#endif
+}
+
+CL_LISPIFY_NAME("wait-request");
+CL_DOCSTRING("Block until REQUEST completes. Return (values source tag element-count).");
+CL_DEFMETHOD core::T_mv Mpi_O::wait_request(core::Fixnum handle) {
+#ifdef USE_MPI
+  MPI_Status status;
+  MpiPendingRequest pending = mpi_find_request(handle);
+  mpi_check(MPI_Wait(&pending._Request,&status),"MPI_Wait");
+  int count = mpi_complete_request(handle,status);
+  return Values(core::make_fixnum(status.MPI_SOURCE), core::make_fixnum(status.MPI_TAG), core::make_fixnum(count));
+#else
+  mpi_not_enabled();
+#endif
+}
+
+CL_LISPIFY_NAME("test-request");
+CL_DOCSTRING("If REQUEST has completed return (values t source tag element-count), otherwise NIL.");
+CL_DEFMETHOD core::T_mv Mpi_O::test_request(core::Fixnum handle) {
+#ifdef USE_MPI
+  MPI_Status status;
+  int done;
+  MpiPendingRequest pending = mpi_find_request(handle);
+  mpi_check(MPI_Test(&pending._Request,&done,&status),"MPI_Test");
+  if (!done) return Values(_Nil<core::T_O>());
+  int count = mpi_complete_request(handle,status);
+  return Values(_lisp->_true(), core::make_fixnum(status.MPI_SOURCE), core::make_fixnum(status.MPI_TAG), core::make_fixnum(count));
+#else
+  mpi_not_enabled();
+#endif
+}
+
+CL_LISPIFY_NAME("barrier");
+CL_DEFMETHOD void Mpi_O::barrier() {
+#ifdef USE_MPI
+  mpi_check(MPI_Barrier((MPI_Comm)this->_Communicator),"MPI_Barrier");
+#endif
+}
+
+CL_LISPIFY_NAME("broadcast");
+CL_DOCSTRING("Return OBJECT from the process ROOT in every process.");
+CL_DEFMETHOD core::T_sp Mpi_O::broadcast(core::T_sp obj, int root) {
+#ifdef USE_MPI
+  MPI_Comm comm = (MPI_Comm)this->_Communicator;
+  core::SimpleVector_byte8_t_sp octets;
+  int len = 0;
+  if (this->Get_rank() == root) {
+    octets = core::core__serialize_to_octets(obj);
+    len = mpi_message_length(octets);
+  }
+  mpi_check(MPI_Bcast(&len,1,MPI_INT,root,comm),"MPI_Bcast");
+  if (this->Get_rank() != root) octets = core::SimpleVector_byte8_t_O::make(len);
+  mpi_check(MPI_Bcast(octets_data(octets),len,MPI_BYTE,root,comm),"MPI_Bcast");
+  if (this->Get_rank() == root) return obj;
+  return core::core__deserialize_from_octets(octets,0,_Nil<core::T_O>());
+#else
+  return obj;
+#endif
+}
+
+CL_LISPIFY_NAME("broadcast-vector");
+CL_DOCSTRING("Copy the contents of VECTOR in the process ROOT into VECTOR in every process, in place.");
+CL_DEFMETHOD core::Vector_sp Mpi_O::broadcast_vector(core::Vector_sp vector, int root) {
+#ifdef USE_MPI
+  MpiBuffer buffer(vector);
+  mpi_check(MPI_Bcast(buffer._Data,buffer._Count,buffer._Type,root,(MPI_Comm)this->_Communicator),"MPI_Bcast");
+#endif
+  return vector;
+}
+
+CL_LISPIFY_NAME("gather-objects");
+CL_DOCSTRING("Collect OBJECT from every process. Return the list of objects ordered by rank in the process ROOT and NIL elsewhere.");
+CL_DEFMETHOD core::T_sp Mpi_O::gather_objects(core::T_sp obj, int root) {
+#ifdef USE_MPI
+  MPI_Comm comm = (MPI_Comm)this->_Communicator;
+  int size = this->Get_size();
+  bool isRoot = (this->Get_rank() == root);
+  core::SimpleVector_byte8_t_sp octets = core::core__serialize_to_octets(obj);
+  int len = mpi_message_length(octets);
+  std::vector<int> lengths(isRoot ? size : 0), offsets(isRoot ? size : 0);
+  mpi_check(MPI_Gather(&len,1,MPI_INT,lengths.data(),1,MPI_INT,root,comm),"MPI_Gather");
+  core::SimpleVector_byte8_t_sp all;
+  if (isRoot) {
+    size_t total = 0;
+    for (int i = 0; i < size; ++i) {
+      offsets[i] = total;
+      total += lengths[i];
+    }
+    if (total > INT_MAX) SIMPLE_ERROR(BF("The gathered objects are too large for a single MPI message"));
+    all = core::SimpleVector_byte8_t_O::make(total);
+  }
+  mpi_check(MPI_Gatherv(octets_data(octets),len,MPI_BYTE,
+                        isRoot ? octets_data(all) : NULL,lengths.data(),offsets.data(),MPI_BYTE,root,comm),"MPI_Gatherv");
+  if (!isRoot) return _Nil<core::T_O>();
+  ql::list result;
+  for (int i = 0; i < size; ++i) {
+    result << core::core__deserialize_from_octets(all,offsets[i],core::make_fixnum(offsets[i]+lengths[i]));
+  }
+  return result.cons();
+#else
+  return core::Cons_O::createList(obj);
+#endif
+}
+
+CL_LISPIFY_NAME("reduce-objects");
+CL_DOCSTRING("Combine OBJECT from every process with FUNCTION, as by cl:reduce in rank order. Return the result in the process ROOT and NIL elsewhere.");
+CL_DEFMETHOD core::T_sp Mpi_O::reduce_objects(core::T_sp obj, core::T_sp function, int root) {
+  core::T_sp objects = this->gather_objects(obj,root);
+  if (objects.nilp()) return objects;
+  core::T_sp result = oCar(objects);
+  for (core::T_sp cur = oCdr(objects); cur.consp(); cur = oCdr(cur)) {
+    result = core::eval::funcall(function,result,oCar(cur));
+  }
+  return result;
+}
+
+CL_LISPIFY_NAME("allreduce-objects");
+CL_DOCSTRING("Combine OBJECT from every process with FUNCTION and return the result in every process.");
+CL_DEFMETHOD core::T_sp Mpi_O::allreduce_objects(core::T_sp obj, core::T_sp function) {
+  return this->broadcast(this->reduce_objects(obj,function,0),0);
+}
+
+CL_LISPIFY_NAME("reduce-vector");
+CL_DOCSTRING("Combine the specialized numeric vectors SOURCE of every process elementwise with OP, one of + * min max, into RESULT in the process ROOT. RESULT may be SOURCE.");
+CL_DEFMETHOD core::Vector_sp Mpi_O::reduce_vector(core::T_sp op, core::Vector_sp source, core::Vector_sp result, int root) {
+#ifdef USE_MPI
+  MpiBuffer in(source);
+  MpiBuffer out(result);
+  if (in._Type != out._Type || in._Count != out._Count) SIMPLE_ERROR(BF("reduce-vector requires SOURCE and RESULT of the same element-type and length"));
+  bool isRoot = (this->Get_rank() == root);
+  const void* sendbuf = (isRoot && in._Data == out._Data) ? MPI_IN_PLACE : in._Data;
+  mpi_check(MPI_Reduce(sendbuf,out._Data,in._Count,in._Type,mpi_reduce_op(op,in),root,(MPI_Comm)this->_Communicator),"MPI_Reduce");
+  if (isRoot) mpi_check_reduction(out);
+#else
+  result->unsafe_setf_subseq(0,source->length(),source);
+#endif
+  return result;
+}
+
+CL_LISPIFY_NAME("allreduce-vector");
+CL_DOCSTRING("Like reduce-vector, but every process receives the combined vector in RESULT.");
+CL_DEFMETHOD core::Vector_sp Mpi_O::allreduce_vector(core::T_sp op, core::Vector_sp source, core::Vector_sp result) {
+#ifdef USE_MPI
+  MpiBuffer in(source);
+  MpiBuffer out(result);
+  if (in._Type != out._Type || in._Count != out._Count) SIMPLE_ERROR(BF("allreduce-vector requires SOURCE and RESULT of the same element-type and length"));
+  const void* sendbuf = (in._Data == out._Data) ? MPI_IN_PLACE : in._Data;
+  mpi_check(MPI_Allreduce(sendbuf,out._Data,in._Count,in._Type,mpi_reduce_op(op,in),(MPI_Comm)this->_Communicator),"MPI_Allreduce");
+  mpi_check_reduction(out);
 #else
-  return _Nil<T_O>();
+  result->unsafe_setf_subseq(0,source->length(),source);
 #endif
+  return result;
 }
 
 /*
@@ -348,6 +781,7 @@ void Mpi_O::initializeGlobals(core::Lisp_sp lisp) {
   SYMBOL_EXPORT_SC_(MpiPkg, STARworldSTAR);
   Mpi_sp world = Mpi_O::mpiCommWorld();
   _sym_STARworldSTAR->defparameter(world);
+  _sym_STARpending_requestsSTAR->defparameter(core::HashTableEql_O::create_default());
 #endif
 }
 #if 0
@@ -87,6 +87,7 @@ SRC_CORE_FILES = \
         'array',
         'string',
         'array_bit',
+        'vectorKernels',
         'grayPackage',
         'closPackage',
         'cleavirPrimopsPackage',
@@ -320,6 +321,8 @@ def collect_bclasp_lisp_files(**kwargs):
         "src/lisp/kernel/clos/dtree",
         "src/lisp/kernel/clos/effective-accessor",
         "src/lisp/kernel/clos/closfastgf",
+        "src/lisp/kernel/clos/call-site-cache",
+        "src/lisp/kernel/clos/sealing",
         "src/lisp/kernel/clos/satiation",
         "src/lisp/kernel/clos/method",
         "src/lisp/kernel/clos/combin",
@@ -355,6 +358,7 @@ def collect_bclasp_lisp_files(**kwargs):
         "src/lisp/kernel/cmp/compiler-conditions",
         "src/lisp/kernel/lsp/packlib2",
         "src/lisp/kernel/clos/inspect",
+        "src/lisp/kernel/clos/dispatch-profile",
         "src/lisp/kernel/lsp/fli",
         "src/lisp/kernel/lsp/posix",
         "src/lisp/modules/sockets/sockets",
@@ -367,7 +371,9 @@ def collect_bclasp_lisp_files(**kwargs):
 
 def collect_cclasp_lisp_files(**kwargs):
     return collect_bclasp_lisp_files(**kwargs) + cleavir_file_list + [
+        "src/lisp/kernel/lsp/mp-queue",
         "src/lisp/kernel/lsp/queue",
+        "src/lisp/kernel/cleavir/tier-up",
         "src/lisp/kernel/cmp/compile-file-parallel",
         "src/lisp/kernel/lsp/generated-encodings",
         "src/lisp/kernel/lsp/encodings",
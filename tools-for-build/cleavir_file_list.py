@@ -226,6 +226,7 @@ cleavir_file_list = [
     "src/lisp/kernel/cleavir/bir",
     "src/lisp/kernel/cleavir/bmir",
     "src/lisp/kernel/cleavir/bir-to-bmir",
+    "src/lisp/kernel/cleavir/escape",
     "src/lisp/kernel/cleavir/landing-pad",
     "src/lisp/kernel/cleavir/translate",
     "src/lisp/kernel/cleavir/fixup-eclector-readtables",